@@ -21,21 +21,23 @@ static const size_t QUEUE_BATCH_SIZE = 128;
 // This Benchmark tests the CheckQueue with a slightly realistic workload, where
 // checks all contain a prevector that is indirect 50% of the time and there is
 // a little bit of work done between calls to Add.
-static void CCheckQueueSpeedPrevectorJob(benchmark::Bench &bench) {
+struct PrevectorJob {
+    prevector<PREVECTOR_SIZE, uint8_t> p;
+    PrevectorJob() {}
+    explicit PrevectorJob(FastRandomContext &insecure_rand) {
+        p.resize(insecure_rand.randrange(PREVECTOR_SIZE * 2));
+    }
+    bool operator()() { return true; }
+    void swap(PrevectorJob &x) noexcept { p.swap(x.p); };
+};
+
+template <typename Queue>
+static void CheckQueueSpeedPrevectorJob(benchmark::Bench &bench, int threads) {
     const ECCVerifyHandle verify_handle;
     ECC_Start();
 
-    struct PrevectorJob {
-        prevector<PREVECTOR_SIZE, uint8_t> p;
-        PrevectorJob() {}
-        explicit PrevectorJob(FastRandomContext &insecure_rand) {
-            p.resize(insecure_rand.randrange(PREVECTOR_SIZE * 2));
-        }
-        bool operator()() { return true; }
-        void swap(PrevectorJob &x) noexcept { p.swap(x.p); };
-    };
-    CCheckQueue<PrevectorJob> queue{QUEUE_BATCH_SIZE};
-    queue.StartWorkerThreads(std::max(MIN_CORES, GetNumCores()));
+    Queue queue{QUEUE_BATCH_SIZE};
+    queue.StartWorkerThreads(threads);
 
     // create all the data once, then submit copies in the benchmark.
     FastRandomContext insecure_rand(true);
@@ -51,10 +53,9 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench &bench) {
         .batch(BATCH_SIZE * BATCHES)
         .unit("job")
         .run([&] {
-            // Make insecure_rand here so that each iteration is identical.
-            CCheckQueueControl<PrevectorJob> control(&queue);
-            std::vector<std::vector<PrevectorJob>> vBatches(BATCHES);
-            for (auto &vChecks : vBatches) {
+            CCheckQueueControl<PrevectorJob, Queue> control(&queue);
+            for (const auto &vBatch : vBatches) {
+                std::vector<PrevectorJob> vChecks = vBatch;
                 control.Add(vChecks);
             }
             // control waits for completion by RAII, but it is done explicitly
@@ -64,4 +65,39 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench &bench) {
     queue.StopWorkerThreads();
     ECC_Stop();
 }
+
+static void CCheckQueueSpeedPrevectorJob(benchmark::Bench &bench) {
+    CheckQueueSpeedPrevectorJob<CCheckQueue<PrevectorJob>>(
+        bench, std::max(MIN_CORES, GetNumCores()));
+}
+
+// Sweep the thread counts to compare how both queues scale.
+static void CCheckQueueSpeed2Threads(benchmark::Bench &bench) {
+    CheckQueueSpeedPrevectorJob<CCheckQueue<PrevectorJob>>(bench, 2);
+}
+static void CCheckQueueSpeed8Threads(benchmark::Bench &bench) {
+    CheckQueueSpeedPrevectorJob<CCheckQueue<PrevectorJob>>(bench, 8);
+}
+static void CCheckQueueSpeed32Threads(benchmark::Bench &bench) {
+    CheckQueueSpeedPrevectorJob<CCheckQueue<PrevectorJob>>(bench, 32);
+}
+static void WorkStealingCheckQueueSpeed2Threads(benchmark::Bench &bench) {
+    CheckQueueSpeedPrevectorJob<WorkStealingCheckQueue<PrevectorJob>>(bench,
+                                                                      2);
+}
+static void WorkStealingCheckQueueSpeed8Threads(benchmark::Bench &bench) {
+    CheckQueueSpeedPrevectorJob<WorkStealingCheckQueue<PrevectorJob>>(bench,
+                                                                      8);
+}
+static void WorkStealingCheckQueueSpeed32Threads(benchmark::Bench &bench) {
+    CheckQueueSpeedPrevectorJob<WorkStealingCheckQueue<PrevectorJob>>(bench,
+                                                                      32);
+}
+
 BENCHMARK(CCheckQueueSpeedPrevectorJob);
+BENCHMARK(CCheckQueueSpeed2Threads);
+BENCHMARK(CCheckQueueSpeed8Threads);
+BENCHMARK(CCheckQueueSpeed32Threads);
+BENCHMARK(WorkStealingCheckQueueSpeed2Threads);
+BENCHMARK(WorkStealingCheckQueueSpeed8Threads);
+BENCHMARK(WorkStealingCheckQueueSpeed32Threads);
@@ -75,6 +75,22 @@ static void SipHash_32b(benchmark::Bench &bench) {
     });
 }
 
+static void SipHash_32b_Lanes(benchmark::Bench &bench) {
+    std::array<uint256, SIPHASH_LANES> x;
+    std::array<const uint256 *, SIPHASH_LANES> vals;
+    for (size_t i = 0; i < SIPHASH_LANES; ++i) {
+        vals[i] = &x[i];
+    }
+    std::array<uint64_t, SIPHASH_LANES> hashes;
+    uint64_t k1 = 0;
+    bench.batch(SIPHASH_LANES).unit("hash").run([&] {
+        SipHashUint256Lanes(0, ++k1, vals, hashes);
+        for (size_t i = 0; i < SIPHASH_LANES; ++i) {
+            std::memcpy(x[i].begin(), &hashes[i], sizeof(hashes[i]));
+        }
+    });
+}
+
 static void FastRandom_32bit(benchmark::Bench &bench) {
     FastRandomContext rng(true);
     bench.run([&] { rng.rand32(); });
@@ -127,6 +143,7 @@ BENCHMARK(SHA3_256_1M);
 
 BENCHMARK(SHA256_32b);
 BENCHMARK(SipHash_32b);
+BENCHMARK(SipHash_32b_Lanes);
 BENCHMARK(SHA256D64_1024);
 BENCHMARK(FastRandom_32bit);
 BENCHMARK(FastRandom_1bit);
@@ -16,6 +16,7 @@
 #include <util/system.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <unordered_map>
 
 CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock &block)
@@ -48,6 +49,18 @@ uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const TxHash &txhash) const {
     return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffL;
 }
 
+std::array<uint64_t, SIPHASH_LANES> CBlockHeaderAndShortTxIDs::GetShortIDs(
+    const std::array<const TxHash *, SIPHASH_LANES> &txhashes) const {
+    std::array<const uint256 *, SIPHASH_LANES> vals;
+    std::copy(txhashes.begin(), txhashes.end(), vals.begin());
+    std::array<uint64_t, SIPHASH_LANES> shortids;
+    SipHashUint256Lanes(shorttxidk0, shorttxidk1, vals, shortids);
+    for (uint64_t &shortid : shortids) {
+        shortid &= 0xffffffffffffL;
+    }
+    return shortids;
+}
+
 ReadStatus PartiallyDownloadedBlock::InitData(
     const CBlockHeaderAndShortTxIDs &cmpctblock,
     const std::vector<std::pair<TxHash, CTransactionRef>> &extra_txns) {
@@ -98,17 +111,31 @@ ReadStatus PartiallyDownloadedBlock::InitData(
 
     {
         LOCK(pool->cs);
-        auto it = pool->mapTx.begin();
-        while (it != pool->mapTx.end()) {
-            uint64_t shortid = cmpctblock.GetShortID(it->GetTx().GetHash());
-
-            mempool_count +=
-                shortidProcessor->matchKnownItem(shortid, it->GetSharedTx());
-            it++;
-
-            if (mempool_count == shortidProcessor->getShortIdCount()) {
-                break;
+        // Scan the contiguous hashes of the mempool rather than walking mapTx,
+        // and compute the short ids several at a time.
+        const auto &tx_hashes = pool->vTxHashes;
+        const size_t shortid_count = shortidProcessor->getShortIdCount();
+        size_t i = 0;
+        while (i + SIPHASH_LANES <= tx_hashes.size() &&
+               mempool_count != shortid_count) {
+            std::array<const TxHash *, SIPHASH_LANES> txhashes;
+            for (size_t lane = 0; lane < SIPHASH_LANES; ++lane) {
+                txhashes[lane] = &tx_hashes[i + lane].first;
+            }
+            const std::array<uint64_t, SIPHASH_LANES> shortids =
+                cmpctblock.GetShortIDs(txhashes);
+            for (size_t lane = 0;
+                 lane < SIPHASH_LANES && mempool_count != shortid_count;
+                 ++lane) {
+                mempool_count += shortidProcessor->matchKnownItem(
+                    shortids[lane], tx_hashes[i + lane].second->GetSharedTx());
             }
+            i += SIPHASH_LANES;
+        }
+        for (; i < tx_hashes.size() && mempool_count != shortid_count; ++i) {
+            uint64_t shortid = cmpctblock.GetShortID(tx_hashes[i].first);
+            mempool_count += shortidProcessor->matchKnownItem(
+                shortid, tx_hashes[i].second->GetSharedTx());
         }
     }
 
@@ -5,10 +5,12 @@
 #ifndef BITCOIN_BLOCKENCODINGS_H
 #define BITCOIN_BLOCKENCODINGS_H
 
+#include <crypto/siphash.h>
 #include <primitives/block.h>
 #include <serialize.h>
 #include <shortidprocessor.h>
 
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -101,6 +103,12 @@ public:
     explicit CBlockHeaderAndShortTxIDs(const CBlock &block);
 
     uint64_t GetShortID(const TxHash &txhash) const;
+    /**
+     * Compute the short ids of several transactions at once, which is faster
+     * than computing them one by one.
+     */
+    std::array<uint64_t, SIPHASH_LANES> GetShortIDs(
+        const std::array<const TxHash *, SIPHASH_LANES> &txhashes) const;
 
     size_t BlockTxCount() const {
         return shorttxids.size() + prefilledtxn.size();
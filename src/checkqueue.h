@@ -10,9 +10,28 @@
 #include <util/threadnames.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <type_traits>
 #include <vector>
 
-template <typename T> class CCheckQueueControl;
+template <typename T, typename Queue> class CCheckQueueControl;
+template <typename T> class WorkStealingCheckQueue;
+
+/**
+ * Whether T provides a static RunBatch(std::vector<T> &) function, which runs
+ * a batch of checks at once and must return the same result as running each
+ * of them in turn.
+ */
+template <typename T, typename = void>
+struct HasRunBatch : std::false_type {};
+template <typename T>
+struct HasRunBatch<T, std::void_t<decltype(T::RunBatch(
+                          std::declval<std::vector<T> &>()))>>
+    : std::true_type {};
 
 /**
  * Queue for verifications that have to be performed.
@@ -26,6 +45,8 @@ template <typename T> class CCheckQueueControl;
  */
 template <typename T> class CCheckQueue {
 private:
+    friend class WorkStealingCheckQueue<T>;
+
     //! Mutex to protect the inner state
     Mutex m_mutex;
 
@@ -61,6 +82,20 @@ private:
     std::vector<std::thread> m_worker_threads;
     bool m_request_stop GUARDED_BY(m_mutex){false};
 
+    /** Run a batch of checks, stopping at the first failure. */
+    static bool RunChecks(std::vector<T> &vChecks) {
+        if constexpr (HasRunBatch<T>::value) {
+            return T::RunBatch(vChecks);
+        } else {
+            for (T &check : vChecks) {
+                if (!check()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
     /** Internal function that does bulk of the verification work. */
     bool Loop(bool fMaster) {
         std::condition_variable &cond = fMaster ? m_master_cv : m_worker_cv;
@@ -126,10 +161,8 @@ private:
                 fOk = fAllOk;
             }
             // execute work
-            for (T &check : vChecks) {
-                if (fOk) {
-                    fOk = check();
-                }
+            if (fOk) {
+                fOk = RunChecks(vChecks);
             }
             vChecks.clear();
         } while (true);
@@ -143,8 +176,9 @@ public:
     explicit CCheckQueue(unsigned int nBatchSizeIn)
         : nBatchSize(nBatchSizeIn) {}
 
-    //! Create a pool of new worker threads.
-    void StartWorkerThreads(const int threads_num) {
+    //! Create a pool of new worker threads, named after thread_name.
+    void StartWorkerThreads(const int threads_num,
+                            const std::string &thread_name = "scriptch") {
         {
             LOCK(m_mutex);
             nIdle = 0;
@@ -153,8 +187,8 @@ public:
         }
         assert(m_worker_threads.empty());
         for (int n = 0; n < threads_num; ++n) {
-            m_worker_threads.emplace_back([this, n]() {
-                util::ThreadRename(strprintf("scriptch.%i", n));
+            m_worker_threads.emplace_back([this, n, thread_name]() {
+                util::ThreadRename(strprintf("%s.%i", thread_name, n));
                 Loop(false /* worker thread */);
             });
         }
@@ -190,23 +224,326 @@ public:
         WITH_LOCK(m_mutex, m_request_stop = false);
     }
 
+    //! Whether worker threads have been started, i.e. whether the work added
+    //! to this queue can actually be done in parallel.
+    bool HasThreads() const { return !m_worker_threads.empty(); }
+
     ~CCheckQueue() { assert(m_worker_threads.empty()); }
 };
 
+/**
+ * Variant of CCheckQueue where the checks are spread over one queue per
+ * thread instead of a single mutex protected queue.
+ *
+ * The master pushes the checks round-robin onto the queues without taking
+ * any lock, and every thread takes batches of checks from its own queue,
+ * stealing from the queues of the other threads once its own is empty. A
+ * batch is taken with a single compare-and-swap on the head of a queue, so
+ * threads only contend when they take from the same queue. The mutex is only
+ * used to put idle threads to sleep and wake them up.
+ *
+ * It has the same interface as CCheckQueue and can be used through
+ * CCheckQueueControl<T, WorkStealingCheckQueue<T>>.
+ */
+template <typename T> class WorkStealingCheckQueue {
+private:
+    //! Ring buffer of pointers to the checks. It is replaced by a larger one
+    //! when full, and the old ones are kept around as they may still be read
+    //! by threads failing to take from the queue.
+    struct Buffer {
+        explicit Buffer(size_t capacity)
+            : mask(capacity - 1),
+              slots(std::make_unique<std::atomic<T *>[]>(capacity)) {}
+        const size_t mask;
+        std::unique_ptr<std::atomic<T *>[]> slots;
+    };
+
+    /**
+     * Single producer, multiple consumers queue. Only the master pushes at the
+     * tail, all the threads take from the head.
+     */
+    struct Queue {
+        //! Index of the next check to take. Keep the indexes on their own
+        //! cache lines, they are written by different threads.
+        alignas(64) std::atomic<int64_t> head{0};
+        //! Index past the last pushed check.
+        alignas(64) std::atomic<int64_t> tail{0};
+        std::atomic<Buffer *> buffer{nullptr};
+        //! The current and all the previous buffers.
+        std::vector<std::unique_ptr<Buffer>> buffers;
+
+        Queue() { Grow(16); }
+
+        Buffer *Grow(size_t capacity) {
+            auto buf = std::make_unique<Buffer>(capacity);
+            if (Buffer *old = buffer.load(std::memory_order_relaxed)) {
+                const int64_t t = tail.load(std::memory_order_relaxed);
+                for (int64_t i = head.load(std::memory_order_acquire); i < t;
+                     ++i) {
+                    buf->slots[i & buf->mask].store(
+                        old->slots[i & old->mask].load(
+                            std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+                }
+            }
+            buffer.store(buf.get(), std::memory_order_release);
+            buffers.push_back(std::move(buf));
+            return buffers.back().get();
+        }
+
+        //! Push checks. Must only be called by the master.
+        void Push(T *checks, size_t count) {
+            const int64_t t = tail.load(std::memory_order_relaxed);
+            Buffer *buf = buffer.load(std::memory_order_relaxed);
+            // The head can only have moved forward since it was read, so the
+            // slots about to be written are free.
+            const int64_t used = t - head.load(std::memory_order_acquire);
+            if (size_t(used) + count > buf->mask + 1) {
+                size_t capacity = buf->mask + 1;
+                while (size_t(used) + count > capacity) {
+                    capacity *= 2;
+                }
+                buf = Grow(capacity);
+            }
+            for (size_t i = 0; i < count; ++i) {
+                buf->slots[(t + i) & buf->mask].store(
+                    &checks[i], std::memory_order_relaxed);
+            }
+            tail.store(t + count, std::memory_order_release);
+        }
+
+        /**
+         * Take up to max_count checks, half of the queue at most so that the
+         * other threads can share the rest.
+         */
+        bool Take(std::vector<T *> &checks, size_t max_count) {
+            int64_t h = head.load(std::memory_order_acquire);
+            while (true) {
+                const int64_t t = tail.load(std::memory_order_acquire);
+                if (h >= t) {
+                    return false;
+                }
+                Buffer *buf = buffer.load(std::memory_order_acquire);
+                const size_t count =
+                    std::clamp<size_t>((t - h + 1) / 2, 1, max_count);
+                checks.resize(count);
+                for (size_t i = 0; i < count; ++i) {
+                    checks[i] = buf->slots[(h + i) & buf->mask].load(
+                        std::memory_order_relaxed);
+                }
+                // The slots can only have been reused if the head moved past
+                // them, in which case this fails and h is reloaded.
+                if (head.compare_exchange_weak(h, h + count,
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_acquire)) {
+                    return true;
+                }
+            }
+        }
+    };
+
+    //! Mutex used to put the threads to sleep when out of work.
+    Mutex m_mutex;
+
+    //! Worker threads block on this when out of work
+    std::condition_variable m_worker_cv;
+
+    //! Master thread blocks on this when out of work
+    std::condition_variable m_master_cv;
+
+    //! One queue per thread, the first one is the master's. They are only
+    //! resized while no worker thread is running.
+    std::vector<std::unique_ptr<Queue>> m_queues;
+
+    //! The checks added since the master last waited. Only accessed by the
+    //! master, the queues point into it.
+    std::deque<std::vector<T>> m_checks;
+
+    //! Queue the next check is pushed onto. Only accessed by the master.
+    size_t m_next_queue{0};
+
+    //! Bumped whenever checks are added, so that a thread finding nothing to
+    //! do can tell whether it may sleep.
+    std::atomic<uint64_t> m_generation{0};
+
+    //! Number of checks that haven't completed yet.
+    std::atomic<size_t> m_todo{0};
+
+    //! The temporary evaluation result.
+    std::atomic<bool> m_all_ok{true};
+
+    //! The maximum number of elements to be processed in one batch
+    const unsigned int nBatchSize;
+
+    std::vector<std::thread> m_worker_threads;
+    bool m_request_stop GUARDED_BY(m_mutex){false};
+
+    /** Take a batch from our own queue first, then from the others'. */
+    bool Take(size_t index, std::vector<T *> &checks) {
+        for (size_t i = 0; i < m_queues.size(); ++i) {
+            if (m_queues[(index + i) % m_queues.size()]->Take(checks,
+                                                              nBatchSize)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Run a batch of checks and account for them. */
+    void Run(std::vector<T *> &checks, std::vector<T> &vChecks) {
+        vChecks.resize(checks.size());
+        for (size_t i = 0; i < checks.size(); ++i) {
+            vChecks[i].swap(*checks[i]);
+        }
+        // Check whether we need to do work at all
+        if (m_all_ok.load(std::memory_order_relaxed) &&
+            !CCheckQueue<T>::RunChecks(vChecks)) {
+            m_all_ok.store(false, std::memory_order_relaxed);
+        }
+        vChecks.clear();
+        if (m_todo.fetch_sub(checks.size(), std::memory_order_acq_rel) ==
+            checks.size()) {
+            // We processed the last element; inform the master it can exit
+            // and return the result. Taking the lock makes sure the master is
+            // either waiting already or sees m_todo == 0.
+            {
+                LOCK(m_mutex);
+            }
+            m_master_cv.notify_one();
+        }
+    }
+
+    /** Internal function that does bulk of the verification work. */
+    bool Loop(size_t index, bool fMaster) {
+        std::vector<T *> checks;
+        std::vector<T> vChecks;
+        checks.reserve(nBatchSize);
+        vChecks.reserve(nBatchSize);
+        while (true) {
+            const uint64_t generation =
+                m_generation.load(std::memory_order_acquire);
+            if (Take(index, checks)) {
+                Run(checks, vChecks);
+                continue;
+            }
+
+            WAIT_LOCK(m_mutex, lock);
+            if (fMaster) {
+                // Nothing is left to take, wait for the other threads to
+                // finish their batches.
+                m_master_cv.wait(lock, [this] {
+                    return m_todo.load(std::memory_order_acquire) == 0;
+                });
+                m_checks.clear();
+                return m_all_ok.exchange(true);
+            }
+            m_worker_cv.wait(lock,
+                             [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                                 return m_request_stop ||
+                                        m_generation.load(
+                                            std::memory_order_relaxed) !=
+                                            generation;
+                             });
+            if (m_request_stop) {
+                return false;
+            }
+        }
+    }
+
+public:
+    //! Mutex to ensure only one concurrent CCheckQueueControl
+    Mutex m_control_mutex;
+
+    //! Create a new check queue
+    explicit WorkStealingCheckQueue(unsigned int nBatchSizeIn)
+        : nBatchSize(nBatchSizeIn) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+
+    //! Create a pool of new worker threads, named after thread_name.
+    void StartWorkerThreads(const int threads_num,
+                            const std::string &thread_name = "scriptch") {
+        assert(m_worker_threads.empty());
+        assert(m_todo == 0);
+        m_queues.resize(1);
+        for (int n = 0; n < threads_num; ++n) {
+            m_queues.push_back(std::make_unique<Queue>());
+        }
+        m_next_queue = 0;
+        for (int n = 0; n < threads_num; ++n) {
+            m_worker_threads.emplace_back([this, n, thread_name]() {
+                util::ThreadRename(strprintf("%s.%i", thread_name, n));
+                Loop(n + 1, false /* worker thread */);
+            });
+        }
+    }
+
+    //! Wait until execution finishes, and return whether all evaluations were
+    //! successful.
+    bool Wait() { return Loop(0, true /* master thread */); }
+
+    //! Add a batch of checks to the queue
+    void Add(std::vector<T> &vChecks) {
+        if (vChecks.empty()) {
+            return;
+        }
+        std::vector<T> &checks = m_checks.emplace_back(vChecks.size());
+        for (size_t i = 0; i < vChecks.size(); ++i) {
+            checks[i].swap(vChecks[i]);
+        }
+        m_todo.fetch_add(checks.size(), std::memory_order_relaxed);
+
+        // Spread the checks evenly over the queues, in contiguous runs.
+        const size_t num_queues = m_queues.size();
+        const size_t per_queue = (checks.size() + num_queues - 1) / num_queues;
+        for (size_t pos = 0; pos < checks.size(); pos += per_queue) {
+            m_queues[m_next_queue]->Push(
+                &checks[pos], std::min(per_queue, checks.size() - pos));
+            m_next_queue = (m_next_queue + 1) % num_queues;
+        }
+
+        WITH_LOCK(m_mutex,
+                  m_generation.fetch_add(1, std::memory_order_release));
+        if (checks.size() == 1) {
+            m_worker_cv.notify_one();
+        } else {
+            m_worker_cv.notify_all();
+        }
+    }
+
+    //! Stop all of the worker threads.
+    void StopWorkerThreads() {
+        WITH_LOCK(m_mutex, m_request_stop = true);
+        m_worker_cv.notify_all();
+        for (std::thread &t : m_worker_threads) {
+            t.join();
+        }
+        m_worker_threads.clear();
+        WITH_LOCK(m_mutex, m_request_stop = false);
+    }
+
+    //! Whether worker threads have been started, i.e. whether the work added
+    //! to this queue can actually be done in parallel.
+    bool HasThreads() const { return !m_worker_threads.empty(); }
+
+    ~WorkStealingCheckQueue() { assert(m_worker_threads.empty()); }
+};
+
 /**
  * RAII-style controller object for a CCheckQueue that guarantees the passed
  * queue is finished before continuing.
  */
-template <typename T> class CCheckQueueControl {
+template <typename T, typename Queue = CCheckQueue<T>>
+class CCheckQueueControl {
 private:
-    CCheckQueue<T> *const pqueue;
+    Queue *const pqueue;
     bool fDone;
 
 public:
     CCheckQueueControl() = delete;
     CCheckQueueControl(const CCheckQueueControl &) = delete;
     CCheckQueueControl &operator=(const CCheckQueueControl &) = delete;
-    explicit CCheckQueueControl(CCheckQueue<T> *const pqueueIn)
+    explicit CCheckQueueControl(Queue *const pqueueIn)
         : pqueue(pqueueIn), fDone(false) {
         // passed queue is supposed to be unused, or nullptr
         if (pqueue != nullptr) {
@@ -105,9 +105,7 @@ void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin coin,
     }
     CCoinsMap::iterator it;
     bool inserted;
-    std::tie(it, inserted) =
-        cacheCoins.emplace(std::piecewise_construct,
-                           std::forward_as_tuple(outpoint), std::tuple<>());
+    std::tie(it, inserted) = cacheCoins.try_emplace(outpoint);
     bool fresh = false;
     if (!inserted) {
         cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
@@ -149,6 +147,19 @@ void CCoinsViewCache::EmplaceCoinInternalDANGER(COutPoint &&outpoint,
         std::forward_as_tuple(std::move(coin), CCoinsCacheEntry::DIRTY));
 }
 
+void CCoinsViewCache::InsertFetchedCoin(const COutPoint &outpoint,
+                                        Coin &&coin) {
+    assert(!coin.IsSpent());
+    CCoinsMap::iterator it;
+    bool inserted;
+    std::tie(it, inserted) = cacheCoins.emplace(
+        std::piecewise_construct, std::forward_as_tuple(outpoint),
+        std::forward_as_tuple(std::move(coin)));
+    if (inserted) {
+        cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+    }
+}
+
 void AddCoins(CCoinsViewCache &cache, const CTransaction &tx, int nHeight,
               bool check_for_overwrite) {
     bool fCoinbase = tx.IsCoinBase();
@@ -276,6 +287,9 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins,
             }
         }
     }
+    // The entries have been freed as they were written, release the memory
+    // they were allocated from.
+    mapCoins.clear();
     hashBlock = hashBlockIn;
     return true;
 }
@@ -344,7 +358,9 @@ bool CCoinsViewErrorCatcher::GetCoin(const COutPoint &outpoint,
     try {
         return CCoinsViewBacked::GetCoin(outpoint, coin);
     } catch (const std::runtime_error &e) {
-        for (auto f : m_err_callbacks) {
+        const auto callbacks = WITH_LOCK(m_callbacks_mutex,
+                                         return m_err_callbacks);
+        for (auto f : callbacks) {
             f();
         }
         LogPrintf("Error reading from database: %s\n", e.what());
@@ -8,14 +8,15 @@
 
 #include <compressor.h>
 #include <memusage.h>
+#include <openhashmap.h>
 #include <primitives/blockhash.h>
 #include <serialize.h>
+#include <sync.h>
 #include <util/hasher.h>
 
 #include <cassert>
 #include <cstdint>
 #include <functional>
-#include <unordered_map>
 
 /**
  * A UTXO entry.
@@ -120,7 +121,7 @@ struct CCoinsCacheEntry {
         : coin(std::move(coin_)), flags(flag) {}
 };
 
-typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher>
+typedef OpenHashMap<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher>
     CCoinsMap;
 
 /** Cursor for iterating over CoinsView state */
@@ -266,6 +267,15 @@ public:
      */
     void EmplaceCoinInternalDANGER(COutPoint &&outpoint, Coin &&coin);
 
+    /**
+     * Insert an unspent coin that was retrieved from the backing view,
+     * exactly as FetchCoin() would have done (i.e. neither DIRTY nor FRESH).
+     * This allows the lookups into the backing view to be done ahead of time,
+     * for instance in parallel. Has no effect if the outpoint is already in
+     * the cache.
+     */
+    void InsertFetchedCoin(const COutPoint &outpoint, Coin &&coin);
+
     /**
      * Spend a coin. Pass moveto in order to get the deleted data.
      * If no unspent output exists for the passed outpoint, this call has no
@@ -341,17 +351,21 @@ public:
     explicit CCoinsViewErrorCatcher(CCoinsView *view)
         : CCoinsViewBacked(view) {}
 
-    void AddReadErrCallback(std::function<void()> f) {
+    void AddReadErrCallback(std::function<void()> f)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_callbacks_mutex) {
+        LOCK(m_callbacks_mutex);
         m_err_callbacks.emplace_back(std::move(f));
     }
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
 
 private:
+    mutable Mutex m_callbacks_mutex;
     /**
      * A list of callbacks to execute upon leveldb read error.
      */
-    std::vector<std::function<void()>> m_err_callbacks;
+    std::vector<std::function<void()>>
+        m_err_callbacks GUARDED_BY(m_callbacks_mutex);
 };
 
 #endif // BITCOIN_COINS_H
@@ -97,6 +97,9 @@ typedef char *sockopt_arg_type;
 // https://github.com/bitcoin/bitcoin/pull/14336#issuecomment-437384408
 #if defined(__linux__)
 #define USE_POLL
+// The sockets of the peers stay registered with epoll, rather than being
+// passed to poll() at every iteration of the socket handler.
+#define USE_EPOLL
 #endif
 
 static bool inline IsSelectableSocket(const SOCKET &s) {
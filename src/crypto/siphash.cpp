@@ -175,3 +175,72 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256 &val,
     SIPROUND;
     return v0 ^ v1 ^ v2 ^ v3;
 }
+
+namespace {
+/** SIPROUND applied to each of the lanes of the interleaved states. */
+inline void SipRoundLanes(uint64_t (&v0)[SIPHASH_LANES],
+                          uint64_t (&v1)[SIPHASH_LANES],
+                          uint64_t (&v2)[SIPHASH_LANES],
+                          uint64_t (&v3)[SIPHASH_LANES]) {
+    for (size_t i = 0; i < SIPHASH_LANES; ++i) {
+        v0[i] += v1[i];
+        v1[i] = ROTL(v1[i], 13);
+        v1[i] ^= v0[i];
+        v0[i] = ROTL(v0[i], 32);
+        v2[i] += v3[i];
+        v3[i] = ROTL(v3[i], 16);
+        v3[i] ^= v2[i];
+        v0[i] += v3[i];
+        v3[i] = ROTL(v3[i], 21);
+        v3[i] ^= v0[i];
+        v2[i] += v1[i];
+        v1[i] = ROTL(v1[i], 17);
+        v1[i] ^= v2[i];
+        v2[i] = ROTL(v2[i], 32);
+    }
+}
+} // namespace
+
+void SipHashUint256Lanes(
+    uint64_t k0, uint64_t k1,
+    const std::array<const uint256 *, SIPHASH_LANES> &vals,
+    std::array<uint64_t, SIPHASH_LANES> &out) {
+    /* Same as SipHashUint256, with the states of the lanes interleaved */
+    uint64_t v0[SIPHASH_LANES], v1[SIPHASH_LANES], v2[SIPHASH_LANES],
+        v3[SIPHASH_LANES], d[SIPHASH_LANES];
+    for (size_t i = 0; i < SIPHASH_LANES; ++i) {
+        v0[i] = 0x736f6d6570736575ULL ^ k0;
+        v1[i] = 0x646f72616e646f6dULL ^ k1;
+        v2[i] = 0x6c7967656e657261ULL ^ k0;
+        v3[i] = 0x7465646279746573ULL ^ k1;
+    }
+
+    for (int word = 0; word < 4; ++word) {
+        for (size_t i = 0; i < SIPHASH_LANES; ++i) {
+            d[i] = vals[i]->GetUint64(word);
+            v3[i] ^= d[i];
+        }
+        SipRoundLanes(v0, v1, v2, v3);
+        SipRoundLanes(v0, v1, v2, v3);
+        for (size_t i = 0; i < SIPHASH_LANES; ++i) {
+            v0[i] ^= d[i];
+        }
+    }
+
+    for (size_t i = 0; i < SIPHASH_LANES; ++i) {
+        v3[i] ^= uint64_t(4) << 59;
+    }
+    SipRoundLanes(v0, v1, v2, v3);
+    SipRoundLanes(v0, v1, v2, v3);
+    for (size_t i = 0; i < SIPHASH_LANES; ++i) {
+        v0[i] ^= uint64_t(4) << 59;
+        v2[i] ^= 0xFF;
+    }
+    SipRoundLanes(v0, v1, v2, v3);
+    SipRoundLanes(v0, v1, v2, v3);
+    SipRoundLanes(v0, v1, v2, v3);
+    SipRoundLanes(v0, v1, v2, v3);
+    for (size_t i = 0; i < SIPHASH_LANES; ++i) {
+        out[i] = v0[i] ^ v1[i] ^ v2[i] ^ v3[i];
+    }
+}
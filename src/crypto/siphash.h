@@ -7,6 +7,8 @@
 
 #include <uint256.h>
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 
 /** SipHash-2-4 */
@@ -48,4 +50,17 @@ uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256 &val);
 uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256 &val,
                              uint32_t extra);
 
+/** Number of values hashed at once by SipHashUint256Lanes. */
+static constexpr size_t SIPHASH_LANES = 4;
+
+/**
+ * Compute SipHashUint256 for several values with the same key. The states of
+ * the hashes are interleaved so that their rounds run in parallel, which lets
+ * the compiler use vector instructions and keeps the CPU pipeline busy.
+ */
+void SipHashUint256Lanes(
+    uint64_t k0, uint64_t k1,
+    const std::array<const uint256 *, SIPHASH_LANES> &vals,
+    std::array<uint64_t, SIPHASH_LANES> &out);
+
 #endif // BITCOIN_CRYPTO_SIPHASH_H
@@ -543,6 +543,21 @@ public:
         return false;
     }
 
+    /**
+     * for_each calls f on every element that is in the table and not
+     * collected, in no particular order. It is not thread safe with
+     * concurrent insertions.
+     *
+     * @param f The function to call with each element
+     */
+    template <typename F> void for_each(F f) const {
+        for (uint32_t i = 0; i < size; ++i) {
+            if (!collection_flags.bit_is_set(i)) {
+                f(table[i]);
+            }
+        }
+    }
+
 private:
     const Element *find(const Key &k, const bool erase) const {
         std::array<uint32_t, 8> locs = compute_hashes(k);
@@ -335,7 +335,11 @@ bool HTTPRPCRequestProcessor::ProcessHTTPRequest(HTTPRequest *req) {
         // Set the URI
         jreq.URI = req->GetURI();
 
-        std::string strReply;
+        // The reply is serialized straight into the request output buffer,
+        // which is sent once the reply is complete.
+        const auto write_chunk = [req](const std::string &chunk) {
+            req->WriteReplyChunk(chunk);
+        };
         bool user_has_whitelist = g_rpc_whitelist.count(jreq.authUser);
         if (!user_has_whitelist && g_rpc_whitelist_default) {
             LogPrintf("RPC User %s not allowed to call any methods\n",
@@ -356,7 +360,7 @@ bool HTTPRPCRequestProcessor::ProcessHTTPRequest(HTTPRequest *req) {
             UniValue result = rpcServer.ExecuteCommand(config, jreq);
 
             // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            JSONRPCWriteReply(result, NullUniValue, jreq.id, write_chunk);
 
             // array of requests
         } else if (valRequest.isArray()) {
@@ -381,14 +385,14 @@ bool HTTPRPCRequestProcessor::ProcessHTTPRequest(HTTPRequest *req) {
                     }
                 }
             }
-            strReply = JSONRPCExecBatch(config, rpcServer, jreq,
-                                        valRequest.get_array());
+            JSONRPCExecBatch(config, rpcServer, jreq, valRequest.get_array(),
+                             write_chunk);
         } else {
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
         }
 
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strReply);
+        req->WriteReply(HTTP_OK);
     } catch (const UniValue &objError) {
         JSONErrorReply(req, objError, jreq.id);
         return false;
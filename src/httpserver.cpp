@@ -11,10 +11,12 @@
 #include <logging.h>
 #include <netbase.h>
 #include <node/ui_interface.h>
+#include <reverse_iterator.h>
 #include <rpc/protocol.h> // For HTTP status codes
 #include <shutdown.h>
 #include <sync.h>
 #include <util/strencodings.h>
+#include <util/string.h>
 #include <util/system.h>
 #include <util/threadnames.h>
 #include <util/translation.h>
@@ -22,6 +24,7 @@
 #include <event2/buffer.h>
 #include <event2/bufferevent.h>
 #include <event2/keyvalq_struct.h>
+#include <event2/listener.h>
 #include <event2/thread.h>
 #include <event2/util.h>
 
@@ -30,8 +33,10 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
+#include <chrono>
 #include <cstring>
 #include <deque>
 #include <memory>
@@ -62,21 +67,39 @@ private:
     Config *config;
 };
 
+/** Work item running a function */
+class HTTPFunctionWorkItem final : public HTTPClosure {
+public:
+    explicit HTTPFunctionWorkItem(std::function<void()> _func)
+        : func(std::move(_func)) {}
+
+    void operator()() override { func(); }
+
+private:
+    std::function<void()> func;
+};
+
 /**
  * Simple work queue for distributing work over multiple threads.
  * Work items are simply callable objects.
  */
 template <typename WorkItem> class WorkQueue {
 private:
+    using Clock = std::chrono::steady_clock;
+
     /** Mutex protects entire object */
     Mutex cs;
     std::condition_variable cond;
-    std::deque<std::unique_ptr<WorkItem>> queue;
+    std::deque<std::pair<std::unique_ptr<WorkItem>, Clock::time_point>> queue;
     bool running;
     size_t maxDepth;
+    HTTPWorkQueueStats stats;
 
 public:
-    explicit WorkQueue(size_t _maxDepth) : running(true), maxDepth(_maxDepth) {}
+    explicit WorkQueue(size_t _maxDepth)
+        : running(true), maxDepth(_maxDepth), stats{} {
+        stats.max_depth = maxDepth;
+    }
     /**
      * Precondition: worker threads have all stopped (they have all been joined)
      */
@@ -86,9 +109,24 @@ public:
     bool Enqueue(WorkItem *item) {
         LOCK(cs);
         if (queue.size() >= maxDepth) {
+            ++stats.rejected;
+            return false;
+        }
+        queue.emplace_back(std::unique_ptr<WorkItem>(item), Clock::now());
+        cond.notify_one();
+        return true;
+    }
+
+    /**
+     * Enqueue a work item only if the queue is less than half full, so that
+     * room is left for the incoming requests.
+     */
+    bool EnqueueSpare(WorkItem *item) {
+        LOCK(cs);
+        if (!running || queue.size() >= maxDepth / 2) {
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        queue.emplace_back(std::unique_ptr<WorkItem>(item), Clock::now());
         cond.notify_one();
         return true;
     }
@@ -97,6 +135,7 @@ public:
     void Run() {
         while (true) {
             std::unique_ptr<WorkItem> i;
+            Clock::time_point start;
             {
                 WAIT_LOCK(cs, lock);
                 while (running && queue.empty()) {
@@ -105,13 +144,30 @@ public:
                 if (!running) {
                     break;
                 }
-                i = std::move(queue.front());
+                i = std::move(queue.front().first);
+                start = Clock::now();
+                stats.wait_time +=
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        start - queue.front().second);
                 queue.pop_front();
             }
             (*i)();
+            const auto handle_time =
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    Clock::now() - start);
+            LOCK(cs);
+            ++stats.handled;
+            stats.handle_time += handle_time;
         }
     }
 
+    HTTPWorkQueueStats GetStats() {
+        LOCK(cs);
+        HTTPWorkQueueStats ret = stats;
+        ret.depth = queue.size();
+        return ret;
+    }
+
     /** Interrupt and exit loops */
     void Interrupt() {
         LOCK(cs);
@@ -129,20 +185,41 @@ struct HTTPPathHandler {
     HTTPRequestHandler handler;
 };
 
+/**
+ * Event loop of the HTTP server. Each event loop accepts its own connections
+ * and hands their requests over to its own work queue.
+ */
+struct HTTPEventLoop {
+    Config *config;
+    //! libevent event loop
+    struct event_base *base{nullptr};
+    //! HTTP server
+    struct evhttp *http{nullptr};
+    //! Bound listening sockets
+    std::vector<evhttp_bound_socket *> boundSockets;
+    //! Work queue for handling longer requests off the event loop thread
+    std::unique_ptr<WorkQueue<HTTPClosure>> workQueue;
+    std::thread thread;
+    std::vector<std::thread> workers;
+
+    ~HTTPEventLoop() {
+        if (http) {
+            evhttp_free(http);
+        }
+        if (base) {
+            event_base_free(base);
+        }
+    }
+};
+
 /** HTTP module state */
 
-//! libevent event loop
-static struct event_base *eventBase = nullptr;
-//! HTTP server
-static struct evhttp *eventHTTP = nullptr;
+//! Event loops, the first one also runs the events of EventBase()
+static std::vector<std::unique_ptr<HTTPEventLoop>> g_event_loops;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
-//! Work queue for handling longer requests off the event loop thread
-static WorkQueue<HTTPClosure> *workQueue = nullptr;
 //! Handlers for (sub)paths
 static std::vector<HTTPPathHandler> pathHandlers;
-//! Bound listening sockets
-static std::vector<evhttp_bound_socket *> boundSockets;
 
 /** Check if a network address is allowed to access the HTTP server */
 static bool ClientAllowed(const CNetAddr &netaddr) {
@@ -212,7 +289,7 @@ std::string RequestMethodString(HTTPRequest::RequestMethod m) {
 
 /** HTTP request callback */
 static void http_request_cb(struct evhttp_request *req, void *arg) {
-    Config &config = *reinterpret_cast<Config *>(arg);
+    HTTPEventLoop &loop = *reinterpret_cast<HTTPEventLoop *>(arg);
 
     // Disable reading to work around a libevent bug, fixed in 2.2.0.
     if (event_get_version_number() >= 0x02010600 &&
@@ -272,9 +349,9 @@ static void http_request_cb(struct evhttp_request *req, void *arg) {
     // Dispatch to worker thread.
     if (i != iend) {
         std::unique_ptr<HTTPWorkItem> item(
-            new HTTPWorkItem(config, std::move(hreq), path, i->handler));
-        assert(workQueue);
-        if (workQueue->Enqueue(item.get())) {
+            new HTTPWorkItem(*loop.config, std::move(hreq), path, i->handler));
+        assert(loop.workQueue);
+        if (loop.workQueue->Enqueue(item.get())) {
             /* if true, queue took ownership */
             item.release();
         } else {
@@ -305,8 +382,8 @@ static bool ThreadHTTP(struct event_base *base) {
     return event_base_got_break(base) == 0;
 }
 
-/** Bind HTTP server to specified addresses */
-static bool HTTPBindAddresses(struct evhttp *http) {
+/** Determine the addresses to bind the HTTP server to */
+static std::vector<std::pair<std::string, uint16_t>> HTTPBindEndpoints() {
     uint16_t http_port{static_cast<uint16_t>(
         gArgs.GetIntArg("-rpcport", BaseParams().RPCPort()))};
     std::vector<std::pair<std::string, uint16_t>> endpoints;
@@ -334,29 +411,60 @@ static bool HTTPBindAddresses(struct evhttp *http) {
             endpoints.push_back(std::make_pair(host, port));
         }
     }
+    return endpoints;
+}
 
+/** Bind HTTP server to specified addresses */
+static bool HTTPBindAddresses(
+    HTTPEventLoop &loop,
+    const std::vector<std::pair<std::string, uint16_t>> &endpoints) {
     // Bind addresses
-    for (std::vector<std::pair<std::string, uint16_t>>::iterator i =
-             endpoints.begin();
-         i != endpoints.end(); ++i) {
-        LogPrint(BCLog::HTTP, "Binding RPC on address %s port %i\n", i->first,
-                 i->second);
+    for (const auto &[host, port] : endpoints) {
+        LogPrint(BCLog::HTTP, "Binding RPC on address %s port %i\n", host,
+                 port);
         evhttp_bound_socket *bind_handle = evhttp_bind_socket_with_handle(
-            http, i->first.empty() ? nullptr : i->first.c_str(), i->second);
+            loop.http, host.empty() ? nullptr : host.c_str(), port);
         if (bind_handle) {
             CNetAddr addr;
-            if (i->first.empty() ||
-                (LookupHost(i->first, addr, false) && addr.IsBindAny())) {
+            if (host.empty() ||
+                (LookupHost(host, addr, false) && addr.IsBindAny())) {
                 LogPrintf("WARNING: the RPC server is not safe to expose to "
                           "untrusted networks such as the public internet\n");
             }
-            boundSockets.push_back(bind_handle);
+            loop.boundSockets.push_back(bind_handle);
         } else {
-            LogPrintf("Binding RPC on address %s port %i failed.\n", i->first,
-                      i->second);
+            LogPrintf("Binding RPC on address %s port %i failed.\n", host,
+                      port);
+        }
+    }
+    return !loop.boundSockets.empty();
+}
+
+/**
+ * Accept connections on the listening sockets of another event loop as well.
+ * The sockets are shared rather than bound again, and remain owned by the
+ * event loop which bound them.
+ */
+static bool HTTPShareBoundSockets(HTTPEventLoop &loop,
+                                  const HTTPEventLoop &owner) {
+    for (evhttp_bound_socket *socket : owner.boundSockets) {
+        // The socket is already listening, hence the null backlog.
+        struct evconnlistener *listener =
+            evconnlistener_new(loop.base, nullptr, nullptr,
+                               LEV_OPT_CLOSE_ON_EXEC, 0,
+                               evhttp_bound_socket_get_fd(socket));
+        if (!listener) {
+            return false;
         }
+        evhttp_bound_socket *bind_handle =
+            evhttp_bind_listener(loop.http, listener);
+        if (!bind_handle) {
+            evconnlistener_free(listener);
+            return false;
+        }
+        loop.boundSockets.push_back(bind_handle);
     }
-    return !boundSockets.empty();
+    return true;
 }
 
 /** Simple wrapper to set thread name and run work queue */
@@ -400,43 +508,66 @@ bool InitHTTPServer(Config &config) {
     evthread_use_pthreads();
 #endif
 
-    raii_event_base base_ctr = obtain_event_base();
+    const int eventThreads = std::max(
+        (long)gArgs.GetIntArg("-rpceventthreads", DEFAULT_HTTP_EVENT_THREADS),
+        1L);
+    const auto endpoints = HTTPBindEndpoints();
+    int workQueueDepth = std::max(
+        (long)gArgs.GetIntArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
 
-    /* Create a new evhttp object to handle requests. */
-    raii_evhttp http_ctr = obtain_evhttp(base_ctr.get());
-    struct evhttp *http = http_ctr.get();
-    if (!http) {
-        LogPrintf("couldn't create evhttp. Exiting.\n");
-        return false;
-    }
+    for (int i = 0; i < eventThreads; ++i) {
+        auto &loop =
+            g_event_loops.emplace_back(std::make_unique<HTTPEventLoop>());
+        loop->config = &config;
 
-    evhttp_set_timeout(http, gArgs.GetIntArg("-rpcservertimeout",
-                                             DEFAULT_HTTP_SERVER_TIMEOUT));
-    evhttp_set_max_headers_size(http, MAX_HEADERS_SIZE);
-    evhttp_set_max_body_size(http, MIN_SUPPORTED_BODY_SIZE +
-                                       2 * config.GetMaxBlockSize());
-    evhttp_set_gencb(http, http_request_cb, &config);
+        raii_event_base base_ctr = obtain_event_base();
 
-    // Only POST and OPTIONS are supported, but we return HTTP 405 for the
-    // others
-    evhttp_set_allowed_methods(
-        http, EVHTTP_REQ_GET | EVHTTP_REQ_POST | EVHTTP_REQ_HEAD |
-                  EVHTTP_REQ_PUT | EVHTTP_REQ_DELETE | EVHTTP_REQ_OPTIONS);
+        /* Create a new evhttp object to handle requests. */
+        raii_evhttp http_ctr = obtain_evhttp(base_ctr.get());
+        struct evhttp *http = http_ctr.get();
+        if (!http) {
+            LogPrintf("couldn't create evhttp. Exiting.\n");
+            g_event_loops.clear();
+            return false;
+        }
 
-    if (!HTTPBindAddresses(http)) {
-        LogPrintf("Unable to bind any endpoint for RPC server\n");
-        return false;
+        evhttp_set_timeout(http, gArgs.GetIntArg("-rpcservertimeout",
+                                                 DEFAULT_HTTP_SERVER_TIMEOUT));
+        evhttp_set_max_headers_size(http, MAX_HEADERS_SIZE);
+        evhttp_set_max_body_size(http, MIN_SUPPORTED_BODY_SIZE +
+                                           2 * config.GetMaxBlockSize());
+        evhttp_set_gencb(http, http_request_cb, loop.get());
+
+        // Only POST and OPTIONS are supported, but we return HTTP 405 for the
+        // others
+        evhttp_set_allowed_methods(
+            http, EVHTTP_REQ_GET | EVHTTP_REQ_POST | EVHTTP_REQ_HEAD |
+                      EVHTTP_REQ_PUT | EVHTTP_REQ_DELETE | EVHTTP_REQ_OPTIONS);
+
+        // transfer ownership to the event loop via .release()
+        loop->base = base_ctr.release();
+        loop->http = http_ctr.release();
+
+        // The listening sockets are bound once and shared by all the event
+        // loops, which compete to accept the connections.
+        if (i == 0 && !HTTPBindAddresses(*loop, endpoints)) {
+            LogPrintf("Unable to bind any endpoint for RPC server\n");
+            g_event_loops.clear();
+            return false;
+        }
+        if (i > 0 && !HTTPShareBoundSockets(*loop, *g_event_loops.front())) {
+            LogPrintf("Unable to listen on the RPC server sockets\n");
+            g_event_loops.clear();
+            return false;
+        }
+
+        loop->workQueue =
+            std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth);
     }
 
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
-    int workQueueDepth = std::max(
-        (long)gArgs.GetIntArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
-    LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
-
-    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
-    // transfer ownership to eventBase/HTTP via .release()
-    eventBase = base_ctr.release();
-    eventHTTP = http_ctr.release();
+    LogPrintf("HTTP: creating %d work queues of depth %d\n", eventThreads,
+              workQueueDepth);
     return true;
 }
 
@@ -454,68 +585,95 @@ bool UpdateHTTPServerLogging(bool enable) {
 #endif
 }
 
-static std::thread g_thread_http;
-static std::vector<std::thread> g_thread_http_workers;
-
 void StartHTTPServer() {
     LogPrint(BCLog::HTTP, "Starting HTTP server\n");
     int rpcThreads = std::max(
         (long)gArgs.GetIntArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
     LogPrintf("HTTP: starting %d worker threads\n", rpcThreads);
-    g_thread_http = std::thread(ThreadHTTP, eventBase);
 
-    for (int i = 0; i < rpcThreads; i++) {
-        g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue, i);
+    // Spread the worker threads over the work queues, with at least one each.
+    const int nLoops = g_event_loops.size();
+    int worker_num = 0;
+    for (int i = 0; i < nLoops; ++i) {
+        HTTPEventLoop &loop = *g_event_loops[i];
+        loop.thread = std::thread(ThreadHTTP, loop.base);
+        const int nWorkers =
+            std::max(rpcThreads / nLoops + (i < rpcThreads % nLoops), 1);
+        for (int j = 0; j < nWorkers; j++) {
+            loop.workers.emplace_back(HTTPWorkQueueRun, loop.workQueue.get(),
+                                      worker_num++);
+        }
     }
 }
 
 void InterruptHTTPServer() {
     LogPrint(BCLog::HTTP, "Interrupting HTTP server\n");
-    if (eventHTTP) {
+    for (auto &loop : g_event_loops) {
         // Reject requests on current connections
-        evhttp_set_gencb(eventHTTP, http_reject_request_cb, nullptr);
-    }
-    if (workQueue) {
-        workQueue->Interrupt();
+        evhttp_set_gencb(loop->http, http_reject_request_cb, nullptr);
+        loop->workQueue->Interrupt();
     }
 }
 
 void StopHTTPServer() {
     LogPrint(BCLog::HTTP, "Stopping HTTP server\n");
-    if (workQueue) {
-        LogPrint(BCLog::HTTP, "Waiting for HTTP worker threads to exit\n");
-        for (auto &thread : g_thread_http_workers) {
+    LogPrint(BCLog::HTTP, "Waiting for HTTP worker threads to exit\n");
+    for (auto &loop : g_event_loops) {
+        for (auto &thread : loop->workers) {
             thread.join();
         }
-        g_thread_http_workers.clear();
-        delete workQueue;
-        workQueue = nullptr;
-    }
-    // Unlisten sockets, these are what make the event loop running, which means
-    // that after this and all connections are closed the event loop will quit.
-    for (evhttp_bound_socket *socket : boundSockets) {
-        evhttp_del_accept_socket(eventHTTP, socket);
-    }
-    boundSockets.clear();
-    if (eventBase) {
-        LogPrint(BCLog::HTTP, "Waiting for HTTP event thread to exit\n");
-        if (g_thread_http.joinable()) {
-            g_thread_http.join();
+        loop->workers.clear();
+    }
+    // The first event loop owns the listening sockets shared by the others,
+    // so it closes them last.
+    for (auto &loop : reverse_iterate(g_event_loops)) {
+        // Unlisten sockets, these are what make the event loop running, which
+        // means that after this and all connections are closed the event loop
+        // will quit.
+        for (evhttp_bound_socket *socket : loop->boundSockets) {
+            evhttp_del_accept_socket(loop->http, socket);
         }
+        loop->boundSockets.clear();
     }
-    if (eventHTTP) {
-        evhttp_free(eventHTTP);
-        eventHTTP = nullptr;
-    }
-    if (eventBase) {
-        event_base_free(eventBase);
-        eventBase = nullptr;
+    LogPrint(BCLog::HTTP, "Waiting for HTTP event threads to exit\n");
+    for (auto &loop : g_event_loops) {
+        if (loop->thread.joinable()) {
+            loop->thread.join();
+        }
     }
+    g_event_loops.clear();
     LogPrint(BCLog::HTTP, "Stopped HTTP server\n");
 }
 
 struct event_base *EventBase() {
-    return eventBase;
+    return g_event_loops.empty() ? nullptr : g_event_loops.front()->base;
+}
+
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats() {
+    std::vector<HTTPWorkQueueStats> stats;
+    for (const auto &loop : g_event_loops) {
+        stats.push_back(loop->workQueue->GetStats());
+    }
+    return stats;
+}
+
+bool QueueHTTPWork(std::function<void()> work) {
+    if (g_event_loops.empty()) {
+        return false;
+    }
+    // Spread the work over the queues, starting from a different one each
+    // time.
+    static std::atomic<size_t> next_loop{0};
+    const size_t start = next_loop++;
+    for (size_t i = 0; i < g_event_loops.size(); ++i) {
+        auto item = std::make_unique<HTTPFunctionWorkItem>(work);
+        const auto &loop = g_event_loops[(start + i) % g_event_loops.size()];
+        if (loop->workQueue->EnqueueSpare(item.get())) {
+            item.release();
+            return true;
+        }
+    }
+    return false;
 }
 
 static void httpevent_callback_fn(evutil_socket_t, short, void *data) {
@@ -599,6 +757,46 @@ void HTTPRequest::WriteHeader(const std::string &hdr,
     evhttp_add_header(headers, hdr.c_str(), value.c_str());
 }
 
+void HTTPRequest::WriteReplyChunk(const std::string &data) {
+    assert(!replySent && req);
+    struct evbuffer *evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    evbuffer_add(evb, data.data(), data.size());
+}
+
+bool HTTPRequest::WriteReplyFileRange(const HTTPReplyFile &file,
+                                      uint64_t offset, uint64_t length) {
+    assert(!replySent && req);
+    struct evbuffer *evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    return evbuffer_add_file_segment(evb, file.segment, offset, length) == 0;
+}
+
+std::unique_ptr<HTTPReplyFile> HTTPReplyFile::Open(FILE *file) {
+    if (!file) {
+        return nullptr;
+    }
+    struct evbuffer_file_segment *segment =
+        evbuffer_file_segment_new(fileno(file), 0, -1, 0);
+    if (!segment) {
+        fclose(file);
+        return nullptr;
+    }
+    // The segment is reference counted by the replies it was added to, close
+    // the file once it is not used anymore.
+    evbuffer_file_segment_add_cleanup_cb(
+        segment,
+        [](struct evbuffer_file_segment const *, int, void *arg) {
+            fclose(static_cast<FILE *>(arg));
+        },
+        file);
+    return std::unique_ptr<HTTPReplyFile>(new HTTPReplyFile(segment));
+}
+
+HTTPReplyFile::~HTTPReplyFile() {
+    evbuffer_file_segment_free(segment);
+}
+
 /**
  * Closure sent to main thread to request a reply to be sent to a HTTP request.
  * Replies must be sent in the main loop in the main http thread, this cannot be
@@ -613,8 +811,12 @@ void HTTPRequest::WriteReply(int nStatus, const std::string &strReply) {
     struct evbuffer *evb = evhttp_request_get_output_buffer(req);
     assert(evb);
     evbuffer_add(evb, strReply.data(), strReply.size());
+    // The reply is sent by the event loop of the connection.
+    evhttp_connection *conn = evhttp_request_get_connection(req);
+    struct event_base *base =
+        conn ? evhttp_connection_get_base(conn) : EventBase();
     auto req_copy = req;
-    HTTPEvent *ev = new HTTPEvent(eventBase, true, [req_copy, nStatus] {
+    HTTPEvent *ev = new HTTPEvent(base, true, [req_copy, nStatus] {
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
         // Re-enable reading from the socket. This is the second part of the
         // libevent workaround above.
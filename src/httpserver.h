@@ -6,13 +6,20 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS = 4;
+static const int DEFAULT_HTTP_EVENT_THREADS = 1;
 static const int DEFAULT_HTTP_WORKQUEUE = 16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT = 30;
 
+struct evbuffer_file_segment;
 struct evhttp_request;
 struct event_base;
 
@@ -39,6 +46,31 @@ void InterruptHTTPServer();
 /** Stop HTTP server */
 void StopHTTPServer();
 
+/** Statistics of a work queue of the HTTP server */
+struct HTTPWorkQueueStats {
+    //! Number of requests waiting to be handled
+    size_t depth;
+    size_t max_depth;
+    //! Number of requests handled, and rejected because the queue was full
+    uint64_t handled;
+    uint64_t rejected;
+    //! Total time the handled requests spent in the queue, and being handled
+    std::chrono::microseconds wait_time;
+    std::chrono::microseconds handle_time;
+};
+
+/** Get the statistics of the work queue of each HTTP event thread */
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats();
+
+/**
+ * Queue a function to be run by an HTTP worker thread, e.g. to handle parts of
+ * a request in parallel. The work is only queued if there is room to spare in
+ * the work queues.
+ * @returns false if the work could not be queued, in which case it is up to
+ * the caller to run it.
+ */
+bool QueueHTTPWork(std::function<void()> work);
+
 /**
  * Change logging level for libevent. Removes BCLog::LIBEVENT from
  * log categories if libevent doesn't support debug logging.
@@ -67,6 +99,33 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
  */
 struct event_base *EventBase();
 
+/**
+ * File whose ranges can be appended to HTTP replies. The data is read from the
+ * file as the replies are sent instead of being copied into memory first.
+ */
+class HTTPReplyFile {
+private:
+    struct evbuffer_file_segment *segment;
+
+    explicit HTTPReplyFile(struct evbuffer_file_segment *segmentIn)
+        : segment(segmentIn) {}
+
+    friend class HTTPRequest;
+
+public:
+    /**
+     * Take ownership of the file, which is closed once this object is gone and
+     * the replies using it have been sent.
+     * @returns nullptr if the file cannot be used.
+     */
+    static std::unique_ptr<HTTPReplyFile> Open(FILE *file);
+
+    ~HTTPReplyFile();
+
+    HTTPReplyFile(const HTTPReplyFile &) = delete;
+    HTTPReplyFile &operator=(const HTTPReplyFile &) = delete;
+};
+
 /**
  * In-flight HTTP request.
  * Thin C++ wrapper around evhttp_request.
@@ -112,6 +171,24 @@ public:
      */
     void WriteHeader(const std::string &hdr, const std::string &value);
 
+    /**
+     * Append data to the reply body, ahead of the strReply passed to
+     * WriteReply. This lets large replies be written in chunks instead of
+     * being built as a single string first. Nothing is sent before WriteReply
+     * is called.
+     *
+     * @note call this before calling WriteReply.
+     */
+    void WriteReplyChunk(const std::string &data);
+
+    /**
+     * Append length bytes of the file, starting at offset, to the reply body.
+     *
+     * @note call this before calling WriteReply.
+     */
+    bool WriteReplyFileRange(const HTTPReplyFile &file, uint64_t offset,
+                             uint64_t length);
+
     /**
      * Write HTTP reply.
      * nStatus is the HTTP status code to send.
@@ -92,6 +92,7 @@
 #include <sys/stat.h>
 #endif
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <cstdint>
 #include <cstdio>
@@ -102,11 +103,13 @@
 #include <thread>
 #include <vector>
 
+using node::BlockTemplateBuilder;
 using node::CacheSizes;
 using node::CalculateCacheSizes;
 using node::ChainstateLoadingError;
 using node::ChainstateLoadVerifyError;
 using node::CleanupBlockRevFiles;
+using node::DEFAULT_REINDEX_THREADS;
 using node::DEFAULT_STOPAFTERBLOCKIMPORT;
 using node::fPruneMode;
 using node::fReindex;
@@ -130,6 +133,10 @@ static constexpr bool DEFAULT_CHRONIK = false;
 
 static const char *DEFAULT_ASMAP_FILENAME = "ip_asn.map";
 
+//! Whether the script caches have been loaded and startup completed, so that
+//! they can be saved on shutdown.
+static std::atomic<bool> g_script_caches_loaded{false};
+
 /**
  * The PID file facilities.
  */
@@ -246,6 +253,9 @@ void Shutdown(NodeContext &node) {
     if (node.peerman) {
         UnregisterValidationInterface(node.peerman.get());
     }
+    if (node.block_template_builder) {
+        UnregisterValidationInterface(node.block_template_builder.get());
+    }
     if (node.connman) {
         node.connman->Stop();
     }
@@ -269,6 +279,7 @@ void Shutdown(NodeContext &node) {
     // After the threads that potentially access these pointers have been
     // stopped, destruct and reset all to nullptr.
     node.peerman.reset();
+    node.block_template_builder.reset();
 
     // Destroy various global instances
     g_avalanche.reset();
@@ -281,6 +292,14 @@ void Shutdown(NodeContext &node) {
         DumpMempool(*node.mempool);
     }
 
+    // Don't overwrite the saved caches with the ones of an aborted startup,
+    // which may not even have been loaded yet.
+    if (node.chainman && g_script_caches_loaded &&
+        node.args->GetBoolArg("-persistscriptcache",
+                              DEFAULT_PERSIST_SCRIPT_CACHE)) {
+        DumpScriptCaches(node.args->GetDataDirNet() / "scriptcache.dat");
+    }
+
     // FlushStateToDisk generates a ChainStateFlushed callback, which we should
     // avoid missing
     if (node.chainman) {
@@ -472,6 +491,14 @@ void SetupServerArgs(NodeContext &node) {
             defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(),
             testnetChainParams->GetConsensus().defaultAssumeValid.GetHex()),
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-backgroundcoinsflush",
+        strprintf("Write the coins cache to the UTXO database on a background "
+                  "thread when it is flushed during normal operation. The "
+                  "flushed coins stay in memory and count towards -dbcache "
+                  "until written (default: %u)",
+                  DEFAULT_BACKGROUND_COINS_FLUSH),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksdir=<dir>",
                    "Specify directory to hold blocks subdirectory for *.dat "
                    "files (default: <datadir>)",
@@ -564,17 +591,39 @@ void SetupServerArgs(NodeContext &node) {
                   -GetNumCores(), MAX_SCRIPTCHECK_THREADS,
                   DEFAULT_SCRIPTCHECK_THREADS),
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-parallelinputfetch",
+        strprintf("Fetch the coins spent by a block from the UTXO database "
+                  "on up to %d threads before connecting it. The threads are "
+                  "only started when -par allows parallel script "
+                  "verification (default: %u)",
+                  MAX_INPUT_FETCH_THREADS, DEFAULT_PARALLEL_INPUT_FETCH),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-persistmempool",
                    strprintf("Whether to save the mempool on shutdown and load "
                              "on restart (default: %u)",
                              DEFAULT_PERSIST_MEMPOOL),
                    ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-persistscriptcache",
+                   strprintf("Whether to save the script execution and "
+                             "signature caches on shutdown and load them on "
+                             "restart. The caches saved by another version "
+                             "are discarded (default: %u)",
+                             DEFAULT_PERSIST_SCRIPT_CACHE),
+                   ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg(
         "-pid=<file>",
         strprintf("Specify pid file. Relative paths will be prefixed "
                   "by a net-specific datadir location. (default: %s)",
                   BITCOIN_PID_FILENAME),
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-prefetchcoins",
+        strprintf("Read the blocks about to be connected from disk and look "
+                  "up the coins they spend on background threads "
+                  "(default: %u)",
+                  DEFAULT_PREFETCH_COINS),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg(
         "-prune=<n>",
         strprintf("Reduce storage requirements by enabling pruning (deleting) "
@@ -599,6 +648,12 @@ void SetupServerArgs(NodeContext &node) {
         "-reindex",
         "Rebuild chain state and block index from the blk*.dat files on disk",
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-reindexthreads=<n>",
+        strprintf("Number of threads reading the block files during -reindex, "
+                  "1 to read them one at a time (default: %d)",
+                  DEFAULT_REINDEX_THREADS),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg(
         "-settings=<file>",
         strprintf(
@@ -762,6 +817,13 @@ void SetupServerArgs(NodeContext &node) {
             "Maximum per-connection send buffer, <n>*1000 bytes (default: %u)",
             DEFAULT_MAXSENDBUFFER),
         ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg(
+        "-netsocketthreads=<n>",
+        strprintf("Number of threads sending and receiving the data of the "
+                  "peers, each one for a share of the connections (%d to %d, "
+                  "default: %d)",
+                  1, MAX_NET_SOCKET_THREADS, DEFAULT_NET_SOCKET_THREADS),
+        ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg(
         "-maxtimeadjustment",
         strprintf("Maximum allowed median peer time offset adjustment. Local "
@@ -1281,6 +1343,14 @@ void SetupServerArgs(NodeContext &node) {
             "Set the number of threads to service RPC calls (default: %d)",
             DEFAULT_HTTP_THREADS),
         ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    argsman.AddArg(
+        "-rpceventthreads=<n>",
+        strprintf("Set the number of threads accepting the RPC and REST "
+                  "connections and parsing their requests, each with its own "
+                  "work queue. The -rpcthreads threads are spread over them "
+                  "(default: %d)",
+                  DEFAULT_HTTP_EVENT_THREADS),
+        ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg(
         "-rpccorsdomain=value",
         "Domain from which to accept cross origin requests (browser enforced)",
@@ -1843,6 +1913,11 @@ bool AppInitParameterInteraction(Config &config, const ArgsManager &args) {
                                        chainparams.DefaultConsistencyChecks());
     fCheckpointsEnabled =
         args.GetBoolArg("-checkpoints", DEFAULT_CHECKPOINTS_ENABLED);
+    fParallelInputFetch =
+        args.GetBoolArg("-parallelinputfetch", DEFAULT_PARALLEL_INPUT_FETCH);
+    fBackgroundCoinsFlush = args.GetBoolArg("-backgroundcoinsflush",
+                                            DEFAULT_BACKGROUND_COINS_FLUSH);
+    fPrefetchCoins = args.GetBoolArg("-prefetchcoins", DEFAULT_PREFETCH_COINS);
     if (fCheckpointsEnabled) {
         LogPrintf("Checkpoints will be verified.\n");
     } else {
@@ -2165,6 +2240,9 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
 
     InitSignatureCache();
     InitScriptExecutionCache();
+    if (args.GetBoolArg("-persistscriptcache", DEFAULT_PERSIST_SCRIPT_CACHE)) {
+        LoadScriptCaches(args.GetDataDirNet() / "scriptcache.dat");
+    }
 
     int script_threads = args.GetIntArg("-par", DEFAULT_SCRIPTCHECK_THREADS);
     if (script_threads <= 0) {
@@ -2617,6 +2695,11 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
         *node.mempool, args.GetBoolArg("-blocksonly", DEFAULT_BLOCKSONLY));
     RegisterValidationInterface(node.peerman.get());
 
+    assert(!node.block_template_builder);
+    node.block_template_builder =
+        std::make_unique<BlockTemplateBuilder>(config, *node.mempool);
+    RegisterValidationInterface(node.block_template_builder.get());
+
     // Encoded addresses using cashaddr instead of base58.
     // We do this by default to avoid confusion with BTC addresses.
     config.SetCashAddrEncoding(args.GetBoolArg("-usecashaddr", true));
@@ -2826,6 +2909,8 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
     connOptions.nReceiveFloodSize =
         1000 * args.GetIntArg("-maxreceivebuffer", DEFAULT_MAXRECEIVEBUFFER);
     connOptions.m_added_nodes = args.GetArgs("-addnode");
+    connOptions.m_socket_threads =
+        args.GetIntArg("-netsocketthreads", DEFAULT_NET_SOCKET_THREADS);
 
     connOptions.nMaxOutboundLimit =
         1024 * 1024 *
@@ -2960,6 +3045,7 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
     // waitforblockheight.
     RPCNotifyBlockChange(chainman.ActiveTip());
     SetRPCWarmupFinished();
+    g_script_caches_loaded = true;
 
     uiInterface.InitMessage(_("Done loading").translated);
 
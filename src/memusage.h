@@ -6,6 +6,7 @@
 #define BITCOIN_MEMUSAGE_H
 
 #include <indirectmap.h>
+#include <openhashmap.h>
 #include <prevector.h>
 
 #include <cassert>
@@ -179,6 +180,11 @@ static inline size_t DynamicUsage(const std::unordered_map<X, Y, Z> &m) {
                m.size() +
            MallocUsage(sizeof(void *) * m.bucket_count());
 }
+
+template <typename X, typename Y, typename Z, typename W>
+static inline size_t DynamicUsage(const OpenHashMap<X, Y, Z, W> &m) {
+    return m.DynamicUsage(MallocUsage);
+}
 } // namespace memusage
 
 #endif // BITCOIN_MEMUSAGE_H
@@ -38,6 +38,7 @@
 #include <cstring>
 #else
 #include <fcntl.h>
+#include <sys/uio.h>
 #endif
 
 #ifdef USE_POLL
@@ -108,6 +109,14 @@ enum BindFlags {
 // The sleep time needs to be small to avoid new sockets stalling
 static const uint64_t SELECT_TIMEOUT_MILLISECONDS = 50;
 
+// Maximum number of queued buffers passed to a single sendmsg() call
+static constexpr size_t MAX_SEND_IOVECS = 64;
+
+#ifdef USE_EPOLL
+// How often the nodes registered with epoll are checked for inactivity
+static constexpr auto EPOLL_SWEEP_INTERVAL = std::chrono::seconds{1};
+#endif
+
 const std::string NET_MESSAGE_COMMAND_OTHER = "*other*";
 
 // SHA256("netgroup")[0:8]
@@ -706,6 +715,14 @@ int V1TransportDeserializer::readHeader(const Config &config,
         return -1;
     }
 
+    // Take a buffer from the pool unless there is one left from a message
+    // that could not be received, and allocate it ahead for the message.
+    if (vRecv.capacity() == 0) {
+        vRecv = g_net_message_buffers.Get(hdrbuf.GetType(),
+                                          hdrbuf.GetVersion());
+    }
+    vRecv.reserve(std::min<size_t>(hdr.nMessageSize, MAX_PREALLOCATED_BYTES));
+
     // switch state to reading message data
     in_data = true;
 
@@ -716,14 +733,18 @@ int V1TransportDeserializer::readData(Span<const uint8_t> msg_bytes) {
     unsigned int nRemaining = hdr.nMessageSize - nDataPos;
     unsigned int nCopy = std::min<unsigned int>(nRemaining, msg_bytes.size());
 
-    if (vRecv.size() < nDataPos + nCopy) {
-        // Allocate up to 256 KiB ahead, but never more than the total message
-        // size.
-        vRecv.resize(std::min(hdr.nMessageSize, nDataPos + nCopy + 256 * 1024));
+    if (vRecv.capacity() < nDataPos + nCopy) {
+        // Grow the buffer geometrically, but never allocate more than 256 KiB
+        // or the size of the data received so far ahead, nor more than the
+        // total message size.
+        vRecv.reserve(std::min<size_t>(
+            hdr.nMessageSize,
+            std::max<size_t>(2 * nDataPos,
+                             nDataPos + nCopy + MAX_PREALLOCATED_BYTES)));
     }
 
     hasher.Write(msg_bytes.first(nCopy));
-    memcpy(&vRecv[nDataPos], msg_bytes.data(), nCopy);
+    vRecv.write(reinterpret_cast<const char *>(msg_bytes.data()), nCopy);
     nDataPos += nCopy;
 
     return nCopy;
@@ -737,6 +758,37 @@ const uint256 &V1TransportDeserializer::GetMessageHash() const {
     return data_hash;
 }
 
+NetMessageBufferPool g_net_message_buffers;
+
+CDataStream NetMessageBufferPool::Get(int type, int version) {
+    {
+        LOCK(m_mutex);
+        if (!m_buffers.empty()) {
+            CDataStream buffer = std::move(m_buffers.back());
+            m_buffers.pop_back();
+            m_bytes -= buffer.capacity();
+            buffer.Init(type, version);
+            return buffer;
+        }
+    }
+    return CDataStream(type, version);
+}
+
+void NetMessageBufferPool::Put(CDataStream &&buffer) {
+    const size_t capacity = buffer.capacity();
+    if (capacity == 0 || capacity > MAX_BUFFER_BYTES) {
+        return;
+    }
+    buffer.clear();
+
+    LOCK(m_mutex);
+    if (m_buffers.size() >= MAX_BUFFERS || m_bytes + capacity > MAX_BYTES) {
+        return;
+    }
+    m_bytes += capacity;
+    m_buffers.push_back(std::move(buffer));
+}
+
 CNetMessage
 V1TransportDeserializer::GetMessage(const Config &config,
                                     const std::chrono::microseconds time) {
@@ -782,29 +834,48 @@ V1TransportDeserializer::GetMessage(const Config &config,
     return msg;
 }
 
+static void SerializeV1Header(const Config &config, const std::string &msg_type,
+                              size_t payload_size, const uint256 &payload_hash,
+                              std::vector<uint8_t> &header) {
+    // create header
+    CMessageHeader hdr(config.GetChainParams().NetMagic(), msg_type.c_str(),
+                       payload_size);
+    memcpy(hdr.pchChecksum, payload_hash.begin(),
+           CMessageHeader::CHECKSUM_SIZE);
+
+    // serialize header
+    header.reserve(CMessageHeader::HEADER_SIZE);
+    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, header, 0, hdr};
+}
+
 void V1TransportSerializer::prepareForTransport(const Config &config,
                                                 CSerializedNetMsg &msg,
                                                 std::vector<uint8_t> &header) {
     // create dbl-sha256 checksum
     uint256 hash = Hash(msg.data);
 
-    // create header
-    CMessageHeader hdr(config.GetChainParams().NetMagic(), msg.m_type.c_str(),
-                       msg.data.size());
-    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+    SerializeV1Header(config, msg.m_type, msg.data.size(), hash, header);
+}
 
-    // serialize header
-    header.reserve(CMessageHeader::HEADER_SIZE);
-    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, header, 0, hdr};
+void V1TransportSerializer::prepareForTransport(const Config &config,
+                                                const CSharedNetMsg &msg,
+                                                std::vector<uint8_t> &header) {
+    SerializeV1Header(config, msg.m_type, msg.data->size(), msg.m_hash,
+                      header);
 }
 
+CSharedNetMsg::CSharedNetMsg(CSerializedNetMsg &&msg)
+    : data(std::make_shared<const std::vector<uint8_t>>(std::move(msg.data))),
+      m_type(std::move(msg.m_type)), m_hash(Hash(*data)) {}
+
 size_t CConnman::SocketSendData(CNode &node) const {
     size_t nSentSize = 0;
     size_t nMsgCount = 0;
 
-    for (const auto &data : node.vSendMsg) {
-        assert(data.size() > node.nSendOffset);
+    while (nMsgCount < node.vSendMsg.size()) {
+        assert(node.vSendMsg[nMsgCount].size() > node.nSendOffset);
         int nBytes = 0;
+        size_t nRequested = 0;
 
         {
             LOCK(node.cs_hSocket);
@@ -812,10 +883,33 @@ size_t CConnman::SocketSendData(CNode &node) const {
                 break;
             }
 
-            nBytes = send(
-                node.hSocket,
-                reinterpret_cast<const char *>(data.data()) + node.nSendOffset,
-                data.size() - node.nSendOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+#ifdef WIN32
+            const Span<const uint8_t> data =
+                node.vSendMsg[nMsgCount].Get().subspan(node.nSendOffset);
+            nRequested = data.size();
+            nBytes = send(node.hSocket,
+                          reinterpret_cast<const char *>(data.data()),
+                          data.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+#else
+            // Send the queued headers and payloads with a single call.
+            std::array<iovec, MAX_SEND_IOVECS> iov;
+            size_t iovcnt = 0;
+            for (size_t i = nMsgCount;
+                 i < node.vSendMsg.size() && iovcnt < iov.size(); ++i) {
+                Span<const uint8_t> data = node.vSendMsg[i].Get();
+                if (i == nMsgCount) {
+                    data = data.subspan(node.nSendOffset);
+                }
+                iov[iovcnt].iov_base = const_cast<uint8_t *>(data.data());
+                iov[iovcnt].iov_len = data.size();
+                nRequested += data.size();
+                ++iovcnt;
+            }
+            msghdr hdr{};
+            hdr.msg_iov = iov.data();
+            hdr.msg_iovlen = iovcnt;
+            nBytes = sendmsg(node.hSocket, &hdr, MSG_NOSIGNAL | MSG_DONTWAIT);
+#endif
         }
 
         if (nBytes == 0) {
@@ -839,17 +933,27 @@ size_t CConnman::SocketSendData(CNode &node) const {
         assert(nBytes > 0);
         node.m_last_send = GetTime<std::chrono::seconds>();
         node.nSendBytes += nBytes;
-        node.nSendOffset += nBytes;
         nSentSize += nBytes;
-        if (node.nSendOffset != data.size()) {
-            // could not send full message; stop sending more
-            break;
+
+        // Skip the buffers that were fully sent.
+        size_t nRemaining = nBytes;
+        while (nRemaining > 0) {
+            const size_t nSize = node.vSendMsg[nMsgCount].size();
+            if (nRemaining < nSize - node.nSendOffset) {
+                node.nSendOffset += nRemaining;
+                break;
+            }
+            nRemaining -= nSize - node.nSendOffset;
+            node.nSendOffset = 0;
+            node.nSendSize -= nSize;
+            node.fPauseSend = node.nSendSize > nSendBufferMaxSize;
+            nMsgCount++;
         }
 
-        node.nSendOffset = 0;
-        node.nSendSize -= data.size();
-        node.fPauseSend = node.nSendSize > nSendBufferMaxSize;
-        nMsgCount++;
+        if (size_t(nBytes) < nRequested) {
+            // could not send everything; stop sending more
+            break;
+        }
     }
 
     node.vSendMsg.erase(node.vSendMsg.begin(),
@@ -859,6 +963,10 @@ size_t CConnman::SocketSendData(CNode &node) const {
         assert(node.nSendOffset == 0);
         assert(node.nSendSize == 0);
     }
+#ifdef USE_EPOLL
+    // Poll for sending while the queue is not empty.
+    UpdateEpollEvents(node);
+#endif
 
     return nSentSize;
 }
@@ -1391,6 +1499,7 @@ void CConnman::CreateNodeFromAcceptedSocket(SOCKET hSocket,
         LOCK(m_nodes_mutex);
         m_nodes.push_back(pnode);
     }
+    AddNodeToSocketHandler(pnode);
 
     // We received a new connection, harvest entropy from the time (and our peer
     // count)
@@ -1555,16 +1664,23 @@ bool CConnman::InactivityCheck(const CNode &node) const {
     return false;
 }
 
-bool CConnman::GenerateSelectSet(std::set<SOCKET> &recv_set,
+bool CConnman::GenerateSelectSet(const SocketHandlerShard &shard,
+                                 std::set<SOCKET> &recv_set,
                                  std::set<SOCKET> &send_set,
                                  std::set<SOCKET> &error_set) {
-    for (const ListenSocket &hListenSocket : vhListenSocket) {
-        recv_set.insert(hListenSocket.socket);
+    if (shard.index == 0) {
+        for (const ListenSocket &hListenSocket : vhListenSocket) {
+            recv_set.insert(hListenSocket.socket);
+        }
     }
 
     {
         LOCK(m_nodes_mutex);
         for (CNode *pnode : m_nodes) {
+            if (!IsNodeInShard(*pnode, shard)) {
+                continue;
+            }
+
             // Implement the following logic:
             // * If there is data to send, select() for sending data. As this
             //   only happens when optimistic write failed, we choose to first
@@ -1603,12 +1719,191 @@ bool CConnman::GenerateSelectSet(std::set<SOCKET> &recv_set,
     return !recv_set.empty() || !send_set.empty() || !error_set.empty();
 }
 
+#ifdef USE_EPOLL
+void CConnman::UpdateEpollEvents(CNode &node) {
+    if (node.m_epoll_fd < 0) {
+        return;
+    }
+
+    // Same logic as GenerateSelectSet(): drain the send buffer before
+    // receiving more data. Errors and hang ups are always reported, the same
+    // as with poll().
+    uint32_t events = 0;
+    if (!node.vSendMsg.empty()) {
+        events = EPOLLOUT;
+    } else if (!node.fPauseRecv) {
+        events = EPOLLIN;
+    }
+    if (events == node.m_epoll_events) {
+        return;
+    }
+
+    LOCK(node.cs_hSocket);
+    // A closed socket is removed from epoll, and its descriptor can be reused.
+    if (node.hSocket == INVALID_SOCKET) {
+        return;
+    }
+    epoll_event event{};
+    event.events = events;
+    event.data.ptr = &node;
+    if (epoll_ctl(node.m_epoll_fd, EPOLL_CTL_MOD, node.hSocket, &event) != 0) {
+        LogPrint(BCLog::NET, "epoll_ctl failed for peer=%d: %s\n",
+                 node.GetId(), NetworkErrorString(WSAGetLastError()));
+        // The socket cannot be polled.
+        node.fDisconnect = true;
+        return;
+    }
+    node.m_epoll_events = events;
+}
+
+void CConnman::UpdateEpollNodes(SocketHandlerShard &shard) {
+    std::vector<CNode *> new_nodes;
+    WITH_LOCK(shard.epoll_mutex, new_nodes.swap(shard.epoll_new_nodes));
+    for (CNode *pnode : new_nodes) {
+        LOCK(pnode->cs_vSend);
+        bool registered = false;
+        {
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket != INVALID_SOCKET) {
+                epoll_event event{};
+                event.data.ptr = pnode;
+                registered = epoll_ctl(shard.epoll_fd, EPOLL_CTL_ADD,
+                                       pnode->hSocket, &event) == 0;
+                if (!registered) {
+                    LogPrint(BCLog::NET, "epoll_ctl failed for peer=%d: %s\n",
+                             pnode->GetId(),
+                             NetworkErrorString(WSAGetLastError()));
+                    pnode->fDisconnect = true;
+                }
+            }
+        }
+        if (!registered) {
+            pnode->Release();
+            continue;
+        }
+        pnode->m_epoll_fd = shard.epoll_fd;
+        pnode->m_epoll_events = 0;
+        UpdateEpollEvents(*pnode);
+        shard.epoll_nodes.push_back(pnode);
+    }
+
+    // The message handler resumes receiving without notifying this thread, so
+    // check the paused nodes.
+    for (auto it = shard.epoll_paused.begin();
+         it != shard.epoll_paused.end();) {
+        CNode *pnode = *it;
+        if (pnode->fPauseRecv && !pnode->fDisconnect) {
+            ++it;
+            continue;
+        }
+        WITH_LOCK(pnode->cs_vSend, UpdateEpollEvents(*pnode));
+        pnode->m_epoll_paused = false;
+        it = shard.epoll_paused.erase(it);
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now < shard.epoll_next_sweep) {
+        return;
+    }
+    shard.epoll_next_sweep = now + EPOLL_SWEEP_INTERVAL;
+
+    // Keep a reference on the nodes until they are disconnected, so that the
+    // epoll events can point to them.
+    for (auto it = shard.epoll_nodes.begin();
+         it != shard.epoll_nodes.end();) {
+        CNode *pnode = *it;
+        if (InactivityCheck(*pnode)) {
+            pnode->fDisconnect = true;
+        }
+        if (!pnode->fDisconnect) {
+            ++it;
+            continue;
+        }
+        {
+            LOCK2(pnode->cs_vSend, pnode->cs_hSocket);
+            if (pnode->hSocket != INVALID_SOCKET) {
+                epoll_ctl(shard.epoll_fd, EPOLL_CTL_DEL, pnode->hSocket,
+                          nullptr);
+            }
+            pnode->m_epoll_fd = -1;
+        }
+        if (pnode->m_epoll_paused) {
+            shard.epoll_paused.erase(std::find(shard.epoll_paused.begin(),
+                                               shard.epoll_paused.end(),
+                                               pnode));
+            pnode->m_epoll_paused = false;
+        }
+        pnode->Release();
+        it = shard.epoll_nodes.erase(it);
+    }
+}
+
+void CConnman::EpollSocketHandler(SocketHandlerShard &shard) {
+    UpdateEpollNodes(shard);
+
+    shard.epoll_ready.resize(
+        std::max<size_t>(shard.epoll_nodes.size() + vhListenSocket.size(), 1));
+    const int nready = epoll_wait(shard.epoll_fd, shard.epoll_ready.data(),
+                                  shard.epoll_ready.size(),
+                                  SELECT_TIMEOUT_MILLISECONDS);
+    if (nready < 0) {
+        return;
+    }
+
+    for (int i = 0; i < nready; ++i) {
+        if (interruptNet) {
+            return;
+        }
+
+        const epoll_event &event = shard.epoll_ready[i];
+        auto listen_it =
+            std::find_if(vhListenSocket.begin(), vhListenSocket.end(),
+                         [&](const ListenSocket &sock) {
+                             return &sock == event.data.ptr;
+                         });
+        if (listen_it != vhListenSocket.end()) {
+            AcceptConnection(*listen_it);
+            continue;
+        }
+
+        // The node is kept alive by the reference held by this thread.
+        CNode &node = *static_cast<CNode *>(event.data.ptr);
+        const bool paused = SocketHandlerNode(
+            node, event.events & EPOLLIN, event.events & EPOLLOUT,
+            event.events & (EPOLLERR | EPOLLHUP));
+        // Stop polling for receiving until the message handler catches up.
+        if (paused && !node.m_epoll_paused) {
+            WITH_LOCK(node.cs_vSend, UpdateEpollEvents(node));
+            node.m_epoll_paused = true;
+            shard.epoll_paused.push_back(&node);
+        }
+    }
+}
+#endif
+
+void CConnman::AddNodeToSocketHandler(CNode *pnode) {
+#ifdef USE_EPOLL
+    if (m_socket_handlers.empty()) {
+        return;
+    }
+    SocketHandlerShard &shard =
+        m_socket_handlers[size_t(pnode->GetId()) % m_socket_handlers.size()];
+    if (shard.epoll_fd < 0) {
+        return;
+    }
+    pnode->AddRef();
+    LOCK(shard.epoll_mutex);
+    shard.epoll_new_nodes.push_back(pnode);
+#endif
+}
+
 #ifdef USE_POLL
-void CConnman::SocketEvents(std::set<SOCKET> &recv_set,
+void CConnman::SocketEvents(SocketHandlerShard &shard,
+                            std::set<SOCKET> &recv_set,
                             std::set<SOCKET> &send_set,
                             std::set<SOCKET> &error_set) {
     std::set<SOCKET> recv_select_set, send_select_set, error_select_set;
-    if (!GenerateSelectSet(recv_select_set, send_select_set,
+    if (!GenerateSelectSet(shard, recv_select_set, send_select_set,
                            error_select_set)) {
         interruptNet.sleep_for(
             std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS));
@@ -1660,11 +1955,12 @@ void CConnman::SocketEvents(std::set<SOCKET> &recv_set,
     }
 }
 #else
-void CConnman::SocketEvents(std::set<SOCKET> &recv_set,
+void CConnman::SocketEvents(SocketHandlerShard &shard,
+                            std::set<SOCKET> &recv_set,
                             std::set<SOCKET> &send_set,
                             std::set<SOCKET> &error_set) {
     std::set<SOCKET> recv_select_set, send_select_set, error_select_set;
-    if (!GenerateSelectSet(recv_select_set, send_select_set,
+    if (!GenerateSelectSet(shard, recv_select_set, send_select_set,
                            error_select_set)) {
         interruptNet.sleep_for(
             std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS));
@@ -1743,9 +2039,95 @@ void CConnman::SocketEvents(std::set<SOCKET> &recv_set,
 }
 #endif
 
-void CConnman::SocketHandler() {
+bool CConnman::SocketHandlerNode(CNode &node, bool recv_ready,
+                                 bool send_ready, bool error) {
+    bool paused = false;
+    //
+    // Receive
+    //
+    if (recv_ready || error) {
+        // typical socket buffer is 8K-64K
+        uint8_t pchBuf[0x10000];
+        int32_t nBytes = 0;
+        {
+            LOCK(node.cs_hSocket);
+            if (node.hSocket == INVALID_SOCKET) {
+                return false;
+            }
+            nBytes = recv(node.hSocket, (char *)pchBuf, sizeof(pchBuf),
+                          MSG_DONTWAIT);
+        }
+        if (nBytes > 0) {
+            bool notify = false;
+            if (!node.ReceiveMsgBytes(
+                    *config, Span<const uint8_t>(pchBuf, nBytes), notify)) {
+                node.CloseSocketDisconnect();
+            }
+            RecordBytesRecv(nBytes);
+            if (notify) {
+                size_t nSizeAdded = 0;
+                auto it(node.vRecvMsg.begin());
+                for (; it != node.vRecvMsg.end(); ++it) {
+                    // vRecvMsg contains only completed CNetMessage
+                    // the single possible partially deserialized message
+                    // are held by TransportDeserializer
+                    nSizeAdded += it->m_raw_message_size;
+                }
+                {
+                    LOCK(node.cs_vProcessMsg);
+                    node.vProcessMsg.splice(node.vProcessMsg.end(),
+                                            node.vRecvMsg,
+                                            node.vRecvMsg.begin(), it);
+                    node.nProcessQueueSize += nSizeAdded;
+                    node.fPauseRecv =
+                        node.nProcessQueueSize > nReceiveFloodSize;
+                    paused = node.fPauseRecv;
+                }
+                WakeMessageHandler();
+            }
+        } else if (nBytes == 0) {
+            // socket closed gracefully
+            if (!node.fDisconnect) {
+                LogPrint(BCLog::NET, "socket closed for peer=%d\n",
+                         node.GetId());
+            }
+            node.CloseSocketDisconnect();
+        } else if (nBytes < 0) {
+            // error
+            int nErr = WSAGetLastError();
+            if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE &&
+                nErr != WSAEINTR && nErr != WSAEINPROGRESS) {
+                if (!node.fDisconnect) {
+                    LogPrint(BCLog::NET, "socket recv error for peer=%d: %s\n",
+                             node.GetId(), NetworkErrorString(nErr));
+                }
+                node.CloseSocketDisconnect();
+            }
+        }
+    }
+
+    if (send_ready) {
+        // Send data
+        size_t bytes_sent =
+            WITH_LOCK(node.cs_vSend, return SocketSendData(node));
+        if (bytes_sent) {
+            RecordBytesSent(bytes_sent);
+        }
+    }
+
+    return paused;
+}
+
+void CConnman::SocketHandler(SocketHandlerShard &shard) {
+#ifdef USE_EPOLL
+    if (shard.epoll_fd >= 0) {
+        EpollSocketHandler(shard);
+        return;
+    }
+#endif
+
     std::set<SOCKET> recv_set, send_set, error_set;
-    SocketEvents(recv_set, send_set, error_set);
+    SocketEvents(shard, recv_set, send_set, error_set);
 
     if (interruptNet) {
         return;
@@ -1754,10 +2136,12 @@ void CConnman::SocketHandler() {
     //
     // Accept new connections
     //
-    for (const ListenSocket &hListenSocket : vhListenSocket) {
-        if (hListenSocket.socket != INVALID_SOCKET &&
-            recv_set.count(hListenSocket.socket) > 0) {
-            AcceptConnection(hListenSocket);
+    if (shard.index == 0) {
+        for (const ListenSocket &hListenSocket : vhListenSocket) {
+            if (hListenSocket.socket != INVALID_SOCKET &&
+                recv_set.count(hListenSocket.socket) > 0) {
+                AcceptConnection(hListenSocket);
+            }
         }
     }
 
@@ -1767,9 +2151,11 @@ void CConnman::SocketHandler() {
     std::vector<CNode *> nodes_copy;
     {
         LOCK(m_nodes_mutex);
-        nodes_copy = m_nodes;
-        for (CNode *pnode : nodes_copy) {
-            pnode->AddRef();
+        for (CNode *pnode : m_nodes) {
+            if (IsNodeInShard(*pnode, shard)) {
+                pnode->AddRef();
+                nodes_copy.push_back(pnode);
+            }
         }
     }
     for (CNode *pnode : nodes_copy) {
@@ -1777,9 +2163,6 @@ void CConnman::SocketHandler() {
             return;
         }
 
-        //
-        // Receive
-        //
         bool recvSet = false;
         bool sendSet = false;
         bool errorSet = false;
@@ -1792,75 +2175,7 @@ void CConnman::SocketHandler() {
             sendSet = send_set.count(pnode->hSocket) > 0;
             errorSet = error_set.count(pnode->hSocket) > 0;
         }
-        if (recvSet || errorSet) {
-            // typical socket buffer is 8K-64K
-            uint8_t pchBuf[0x10000];
-            int32_t nBytes = 0;
-            {
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET) {
-                    continue;
-                }
-                nBytes = recv(pnode->hSocket, (char *)pchBuf, sizeof(pchBuf),
-                              MSG_DONTWAIT);
-            }
-            if (nBytes > 0) {
-                bool notify = false;
-                if (!pnode->ReceiveMsgBytes(
-                        *config, Span<const uint8_t>(pchBuf, nBytes), notify)) {
-                    pnode->CloseSocketDisconnect();
-                }
-                RecordBytesRecv(nBytes);
-                if (notify) {
-                    size_t nSizeAdded = 0;
-                    auto it(pnode->vRecvMsg.begin());
-                    for (; it != pnode->vRecvMsg.end(); ++it) {
-                        // vRecvMsg contains only completed CNetMessage
-                        // the single possible partially deserialized message
-                        // are held by TransportDeserializer
-                        nSizeAdded += it->m_raw_message_size;
-                    }
-                    {
-                        LOCK(pnode->cs_vProcessMsg);
-                        pnode->vProcessMsg.splice(pnode->vProcessMsg.end(),
-                                                  pnode->vRecvMsg,
-                                                  pnode->vRecvMsg.begin(), it);
-                        pnode->nProcessQueueSize += nSizeAdded;
-                        pnode->fPauseRecv =
-                            pnode->nProcessQueueSize > nReceiveFloodSize;
-                    }
-                    WakeMessageHandler();
-                }
-            } else if (nBytes == 0) {
-                // socket closed gracefully
-                if (!pnode->fDisconnect) {
-                    LogPrint(BCLog::NET, "socket closed for peer=%d\n",
-                             pnode->GetId());
-                }
-                pnode->CloseSocketDisconnect();
-            } else if (nBytes < 0) {
-                // error
-                int nErr = WSAGetLastError();
-                if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE &&
-                    nErr != WSAEINTR && nErr != WSAEINPROGRESS) {
-                    if (!pnode->fDisconnect) {
-                        LogPrint(BCLog::NET,
-                                 "socket recv error for peer=%d: %s\n",
-                                 pnode->GetId(), NetworkErrorString(nErr));
-                    }
-                    pnode->CloseSocketDisconnect();
-                }
-            }
-        }
-
-        if (sendSet) {
-            // Send data
-            size_t bytes_sent =
-                WITH_LOCK(pnode->cs_vSend, return SocketSendData(*pnode));
-            if (bytes_sent) {
-                RecordBytesSent(bytes_sent);
-            }
-        }
+        SocketHandlerNode(*pnode, recvSet, sendSet, errorSet);
 
         if (InactivityCheck(*pnode)) {
             pnode->fDisconnect = true;
@@ -1874,12 +2189,63 @@ void CConnman::SocketHandler() {
     }
 }
 
-void CConnman::ThreadSocketHandler() {
+#ifdef USE_EPOLL
+void CConnman::CreateEpoll(SocketHandlerShard &shard) {
+    shard.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (shard.epoll_fd < 0) {
+        LogPrintf("Failed to create epoll instance, using poll instead: %s\n",
+                  NetworkErrorString(WSAGetLastError()));
+    }
+    for (ListenSocket &hListenSocket : vhListenSocket) {
+        if (shard.index != 0 || shard.epoll_fd < 0 ||
+            hListenSocket.socket == INVALID_SOCKET) {
+            continue;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = &hListenSocket;
+        if (epoll_ctl(shard.epoll_fd, EPOLL_CTL_ADD, hListenSocket.socket,
+                      &event) != 0) {
+            LogPrintf("Failed to register listening socket with epoll, using "
+                      "poll instead: %s\n",
+                      NetworkErrorString(WSAGetLastError()));
+            close(shard.epoll_fd);
+            shard.epoll_fd = -1;
+        }
+    }
+}
+#endif
+
+void CConnman::ThreadSocketHandler(SocketHandlerShard &shard) {
     while (!interruptNet) {
-        DisconnectNodes();
-        NotifyNumConnectionsChanged();
-        SocketHandler();
+        // The nodes are only deleted by the first thread, the other ones keep
+        // a reference on the nodes they are handling.
+        if (shard.index == 0) {
+            DisconnectNodes();
+            NotifyNumConnectionsChanged();
+        }
+        SocketHandler(shard);
     }
+
+#ifdef USE_EPOLL
+    if (shard.epoll_fd >= 0) {
+        {
+            LOCK(shard.epoll_mutex);
+            shard.epoll_nodes.insert(shard.epoll_nodes.end(),
+                                     shard.epoll_new_nodes.begin(),
+                                     shard.epoll_new_nodes.end());
+            shard.epoll_new_nodes.clear();
+        }
+        for (CNode *pnode : shard.epoll_nodes) {
+            WITH_LOCK(pnode->cs_vSend, pnode->m_epoll_fd = -1);
+            pnode->Release();
+        }
+        shard.epoll_nodes.clear();
+        shard.epoll_paused.clear();
+        close(shard.epoll_fd);
+        shard.epoll_fd = -1;
+    }
+#endif
 }
 
 void CConnman::WakeMessageHandler() {
@@ -2590,6 +2956,7 @@ void CConnman::OpenNetworkConnection(const CAddress &addrConnect,
         LOCK(m_nodes_mutex);
         m_nodes.push_back(pnode);
     }
+    AddNodeToSocketHandler(pnode);
 }
 
 void CConnman::ThreadMessageHandler() {
@@ -2971,8 +3338,22 @@ bool CConnman::Start(CScheduler &scheduler, const Options &connOptions) {
     }
 
     // Send and receive from sockets, accept connections
-    threadSocketHandler = std::thread(&util::TraceThread, "net",
-                                      [this] { ThreadSocketHandler(); });
+    m_socket_handlers = std::vector<SocketHandlerShard>(m_socket_threads);
+    for (size_t i = 0; i < m_socket_handlers.size(); ++i) {
+        SocketHandlerShard &shard = m_socket_handlers[i];
+        shard.index = i;
+#ifdef USE_EPOLL
+        // Created before the thread starts, so the nodes can be handed over
+        // to it right away.
+        CreateEpoll(shard);
+#endif
+        shard.thread = std::thread([this, &shard] {
+            const std::string name =
+                shard.index == 0 ? "net" : strprintf("net.%d", shard.index);
+            util::TraceThread(name.c_str(),
+                              [this, &shard] { ThreadSocketHandler(shard); });
+        });
+    }
 
     if (!gArgs.GetBoolArg("-dnsseed", DEFAULT_DNSSEED)) {
         LogPrintf("DNS seeding disabled\n");
@@ -3078,8 +3459,10 @@ void CConnman::StopThreads() {
     if (threadDNSAddressSeed.joinable()) {
         threadDNSAddressSeed.join();
     }
-    if (threadSocketHandler.joinable()) {
-        threadSocketHandler.join();
+    for (SocketHandlerShard &shard : m_socket_handlers) {
+        if (shard.thread.joinable()) {
+            shard.thread.join();
+        }
     }
 }
 
@@ -3499,7 +3882,35 @@ void CConnman::PushMessage(CNode *pnode, CSerializedNetMsg &&msg) {
     // make sure we use the appropriate network transport format
     std::vector<uint8_t> serializedHeader;
     pnode->m_serializer->prepareForTransport(*config, msg, serializedHeader);
-    size_t nTotalSize = nMessageSize + serializedHeader.size();
+
+    EnqueueMessage(pnode, msg.m_type, std::move(serializedHeader),
+                   CSendBuffer{std::move(msg.data), nullptr});
+}
+
+void CConnman::PushMessage(CNode *pnode, const CSharedNetMsg &msg) {
+    LogPrint(BCLog::NET, "sending %s (%d bytes) peer=%d\n", msg.m_type,
+             msg.data->size(), pnode->GetId());
+    if (gArgs.GetBoolArg("-capturemessages", false)) {
+        CaptureMessage(pnode->addr, msg.m_type, *msg.data,
+                       /*is_incoming=*/false);
+    }
+
+    TRACE6(net, outbound_message, pnode->GetId(), pnode->m_addr_name.c_str(),
+           pnode->ConnectionTypeAsString().c_str(), msg.m_type.c_str(),
+           msg.data->size(), msg.data->data());
+
+    std::vector<uint8_t> serializedHeader;
+    pnode->m_serializer->prepareForTransport(*config, msg, serializedHeader);
+
+    EnqueueMessage(pnode, msg.m_type, std::move(serializedHeader),
+                   CSendBuffer{{}, msg.data});
+}
+
+void CConnman::EnqueueMessage(CNode *pnode, const std::string &msg_type,
+                              std::vector<uint8_t> &&header,
+                              CSendBuffer &&payload) {
+    const size_t nMessageSize = payload.size();
+    size_t nTotalSize = nMessageSize + header.size();
 
     size_t nBytesSent = 0;
     {
@@ -3507,15 +3918,15 @@ void CConnman::PushMessage(CNode *pnode, CSerializedNetMsg &&msg) {
         bool optimisticSend(pnode->vSendMsg.empty());
 
         // log total amount of bytes per message type
-        pnode->mapSendBytesPerMsgCmd[msg.m_type] += nTotalSize;
+        pnode->mapSendBytesPerMsgCmd[msg_type] += nTotalSize;
         pnode->nSendSize += nTotalSize;
 
         if (pnode->nSendSize > nSendBufferMaxSize) {
             pnode->fPauseSend = true;
         }
-        pnode->vSendMsg.push_back(std::move(serializedHeader));
+        pnode->vSendMsg.push_back(CSendBuffer{std::move(header), nullptr});
         if (nMessageSize) {
-            pnode->vSendMsg.push_back(std::move(msg.data));
+            pnode->vSendMsg.push_back(std::move(payload));
         }
 
         // If write queue empty, attempt "optimistic write"
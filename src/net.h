@@ -32,7 +32,13 @@
 #include <util/check.h>
 #include <validation.h> // For cs_main
 
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <deque>
@@ -103,6 +109,13 @@ static const bool DEFAULT_DNSSEED = true;
 static const bool DEFAULT_FIXEDSEEDS = true;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER = 1 * 1000;
+/**
+ * Default number of threads handling the sockets of the peers, each one for a
+ * subset of the connections.
+ */
+static constexpr int DEFAULT_NET_SOCKET_THREADS = 1;
+/** Maximum number of threads handling the sockets of the peers */
+static constexpr int MAX_NET_SOCKET_THREADS = 16;
 
 struct AddedNodeInfo {
     std::string strAddedNode;
@@ -126,6 +139,36 @@ struct CSerializedNetMsg {
     std::string m_type;
 };
 
+/**
+ * Serialized message sent to several peers. The payload is shared rather than
+ * copied for each of them, and its checksum is only computed once.
+ */
+struct CSharedNetMsg {
+    CSharedNetMsg() = default;
+    explicit CSharedNetMsg(CSerializedNetMsg &&msg);
+
+    std::shared_ptr<const std::vector<uint8_t>> data;
+    std::string m_type;
+    //! Hash of the payload, the checksum of the message is taken from it
+    uint256 m_hash;
+};
+
+/**
+ * Data queued to be sent to a peer: the header of a message, or its payload
+ * which may be shared with other peers.
+ */
+struct CSendBuffer {
+    std::vector<uint8_t> data;
+    //! Payload shared with other peers, sent instead of data if set
+    std::shared_ptr<const std::vector<uint8_t>> shared_data;
+
+    Span<const uint8_t> Get() const {
+        return shared_data ? Span<const uint8_t>(*shared_data)
+                           : Span<const uint8_t>(data);
+    }
+    size_t size() const { return Get().size(); }
+};
+
 const std::vector<std::string> CONNECTION_TYPE_DOC{
     "outbound-full-relay (default automatic connections)",
     "block-relay-only (does not relay transactions or addresses)",
@@ -310,6 +353,34 @@ struct CNodeStats {
     std::optional<double> m_availabilityScore;
 };
 
+/**
+ * Pool of the buffers holding the payload of the received messages. The buffer
+ * of a message is put back into the pool once the message is processed, so
+ * that the next messages can usually be received without allocating memory.
+ */
+class NetMessageBufferPool {
+public:
+    //! Maximum number of buffers kept in the pool
+    static constexpr size_t MAX_BUFFERS{256};
+    //! Larger buffers, e.g. the ones of the blocks, are freed rather than kept
+    static constexpr size_t MAX_BUFFER_BYTES{4 * 1024 * 1024};
+    //! Maximum total capacity of the buffers kept in the pool
+    static constexpr size_t MAX_BYTES{32 * 1024 * 1024};
+
+    /** Take an empty buffer from the pool, or a new one if it is empty. */
+    CDataStream Get(int type, int version) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** Put a buffer back into the pool, unless the pool is full. */
+    void Put(CDataStream &&buffer) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    Mutex m_mutex;
+    std::vector<CDataStream> m_buffers GUARDED_BY(m_mutex);
+    //! Total capacity of the buffers in the pool
+    size_t m_bytes GUARDED_BY(m_mutex){0};
+};
+
+extern NetMessageBufferPool g_net_message_buffers;
+
 /**
  * Transport protocol agnostic message container.
  * Ideally it should only contain receive time, payload,
@@ -331,6 +402,10 @@ public:
     std::string m_command;
 
     CNetMessage(CDataStream &&recv_in) : m_recv(std::move(recv_in)) {}
+    CNetMessage(CNetMessage &&) = default;
+    CNetMessage &operator=(CNetMessage &&) = default;
+    //! Give the buffer back to the pool for the next messages.
+    ~CNetMessage() { g_net_message_buffers.Put(std::move(m_recv)); }
 
     void SetVersion(int nVersionIn) { m_recv.SetVersion(nVersionIn); }
 };
@@ -356,6 +431,9 @@ public:
 
 class V1TransportDeserializer final : public TransportDeserializer {
 private:
+    //! Maximum size allocated ahead of the received message data
+    static constexpr size_t MAX_PREALLOCATED_BYTES{256 * 1024};
+
     mutable CHash256 hasher;
     mutable uint256 data_hash;
 
@@ -365,7 +443,7 @@ private:
     CDataStream hdrbuf;
     // Complete header.
     CMessageHeader hdr;
-    // Received message data.
+    // Received message data, in a buffer taken from g_net_message_buffers.
     CDataStream vRecv;
     uint32_t nHdrPos;
     uint32_t nDataPos;
@@ -430,6 +508,11 @@ public:
     virtual void prepareForTransport(const Config &config,
                                      CSerializedNetMsg &msg,
                                      std::vector<uint8_t> &header) = 0;
+    // prepare the header of a message sent to several peers, the payload is
+    // left untouched
+    virtual void prepareForTransport(const Config &config,
+                                     const CSharedNetMsg &msg,
+                                     std::vector<uint8_t> &header) = 0;
     virtual ~TransportSerializer() {}
 };
 
@@ -437,6 +520,8 @@ class V1TransportSerializer : public TransportSerializer {
 public:
     void prepareForTransport(const Config &config, CSerializedNetMsg &msg,
                              std::vector<uint8_t> &header) override;
+    void prepareForTransport(const Config &config, const CSharedNetMsg &msg,
+                             std::vector<uint8_t> &header) override;
 };
 
 /** Information about a peer */
@@ -456,7 +541,7 @@ public:
     /** Offset inside the first vSendMsg already sent */
     size_t nSendOffset GUARDED_BY(cs_vSend){0};
     uint64_t nSendBytes GUARDED_BY(cs_vSend){0};
-    std::deque<std::vector<uint8_t>> vSendMsg GUARDED_BY(cs_vSend);
+    std::deque<CSendBuffer> vSendMsg GUARDED_BY(cs_vSend);
     Mutex cs_vSend;
     Mutex cs_hSocket;
     Mutex cs_vRecv;
@@ -836,8 +921,17 @@ private:
     const ServiceFlags nLocalServices;
 
     NetPermissionFlags m_permissionFlags{NetPermissionFlags::None};
-    // Used only by SocketHandler thread
+    // Used only by the SocketHandler thread of the node
     std::list<CNetMessage> vRecvMsg;
+#ifdef USE_EPOLL
+    //! epoll instance the socket is registered with, -1 if it is not
+    int m_epoll_fd GUARDED_BY(cs_vSend){-1};
+    //! Events the socket is registered for with epoll
+    uint32_t m_epoll_events GUARDED_BY(cs_vSend){0};
+    //! Whether the node is in the paused nodes of its SocketHandler thread,
+    //! used only by that thread
+    bool m_epoll_paused{false};
+#endif
 
     // Our address, as reported by the peer
     mutable RecursiveMutex cs_addrLocal;
@@ -940,6 +1034,7 @@ public:
         std::vector<std::string> m_specified_outgoing;
         std::vector<std::string> m_added_nodes;
         bool m_i2p_accept_incoming = true;
+        int m_socket_threads = DEFAULT_NET_SOCKET_THREADS;
     };
 
     void Init(const Options &connOptions) {
@@ -978,6 +1073,8 @@ public:
             m_added_nodes = connOptions.m_added_nodes;
         }
         m_onion_binds = connOptions.onion_binds;
+        m_socket_threads = std::clamp(connOptions.m_socket_threads, 1,
+                                      MAX_NET_SOCKET_THREADS);
     }
 
     CConnman(const Config &configIn, uint64_t seed0, uint64_t seed1,
@@ -1005,6 +1102,11 @@ public:
     bool ForNode(NodeId id, std::function<bool(CNode *pnode)> func);
 
     void PushMessage(CNode *pnode, CSerializedNetMsg &&msg);
+    /**
+     * Send a message that is sent to other peers as well, without copying
+     * its payload.
+     */
+    void PushMessage(CNode *pnode, const CSharedNetMsg &msg);
 
     using NodeFn = std::function<void(CNode *)>;
     void ForEachNode(const NodeFn &func) {
@@ -1192,13 +1294,82 @@ private:
     void NotifyNumConnectionsChanged();
     /** Return true if the peer is inactive and should be disconnected. */
     bool InactivityCheck(const CNode &node) const;
-    bool GenerateSelectSet(std::set<SOCKET> &recv_set,
+
+    /**
+     * State of a thread handling the sockets of a subset of the peers. The
+     * first one also accepts the incoming connections and cleans up the
+     * disconnected nodes.
+     */
+    struct SocketHandlerShard {
+        size_t index{0};
+        std::thread thread;
+#ifdef USE_EPOLL
+        /**
+         * epoll instance the sockets are registered with. poll() is used if it
+         * could not be created.
+         */
+        int epoll_fd{-1};
+        // The following are used only by the thread.
+        std::vector<epoll_event> epoll_ready;
+        //! Nodes registered with epoll, the thread holds a reference on each
+        std::vector<CNode *> epoll_nodes;
+        //! Registered nodes which stopped receiving because their process
+        //! queue is full
+        std::vector<CNode *> epoll_paused;
+        //! When to check the registered nodes for inactivity next
+        std::chrono::steady_clock::time_point epoll_next_sweep;
+
+        Mutex epoll_mutex;
+        //! New nodes to be registered by the thread, with a reference
+        std::vector<CNode *> epoll_new_nodes GUARDED_BY(epoll_mutex);
+#endif
+    };
+
+    /** Whether the socket of a node is handled by a shard. */
+    bool IsNodeInShard(const CNode &node,
+                       const SocketHandlerShard &shard) const {
+        return size_t(node.GetId()) % m_socket_handlers.size() == shard.index;
+    }
+
+    bool GenerateSelectSet(const SocketHandlerShard &shard,
+                           std::set<SOCKET> &recv_set,
                            std::set<SOCKET> &send_set,
                            std::set<SOCKET> &error_set);
-    void SocketEvents(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set,
-                      std::set<SOCKET> &error_set);
-    void SocketHandler();
-    void ThreadSocketHandler();
+    void SocketEvents(SocketHandlerShard &shard, std::set<SOCKET> &recv_set,
+                      std::set<SOCKET> &send_set, std::set<SOCKET> &error_set);
+#ifdef USE_EPOLL
+    /**
+     * Update the events polled for the socket of a node registered with epoll,
+     * after its send queue or its receive pause state changed.
+     */
+    static void UpdateEpollEvents(CNode &node)
+        EXCLUSIVE_LOCKS_REQUIRED(node.cs_vSend);
+    /**
+     * Create the epoll instance of the shard and register the listening
+     * sockets with it.
+     */
+    void CreateEpoll(SocketHandlerShard &shard);
+    /**
+     * Register the new nodes of the shard with epoll, and unregister the
+     * disconnected ones.
+     */
+    void UpdateEpollNodes(SocketHandlerShard &shard);
+    /**
+     * Wait for the events of the sockets registered with epoll and handle
+     * them, without going through all the nodes of the shard.
+     */
+    void EpollSocketHandler(SocketHandlerShard &shard);
+#endif
+    /** Hand a node added to m_nodes over to the thread handling its socket. */
+    void AddNodeToSocketHandler(CNode *pnode);
+    /**
+     * Receive and send data on the socket of a node, as polled.
+     * @returns whether receiving got paused because the process queue is full.
+     */
+    bool SocketHandlerNode(CNode &node, bool recv_ready, bool send_ready,
+                           bool error);
+    void SocketHandler(SocketHandlerShard &shard);
+    void ThreadSocketHandler(SocketHandlerShard &shard);
     void ThreadDNSAddressSeed();
 
     uint64_t CalculateKeyedNetGroup(const CAddress &ad) const;
@@ -1226,6 +1397,12 @@ private:
 
     size_t SocketSendData(CNode &node) const
         EXCLUSIVE_LOCKS_REQUIRED(node.cs_vSend);
+    /**
+     * Queue the header and payload of a message for sending, and try to send
+     * them right away if nothing else is queued.
+     */
+    void EnqueueMessage(CNode *pnode, const std::string &msg_type,
+                        std::vector<uint8_t> &&header, CSendBuffer &&payload);
     void DumpAddresses();
 
     // Network stats
@@ -1375,8 +1552,14 @@ private:
      */
     std::unique_ptr<i2p::sam::Session> m_i2p_sam_session;
 
+    /**
+     * Threads handling the sockets of the peers. The connections are spread
+     * over them by node id.
+     */
+    int m_socket_threads{DEFAULT_NET_SOCKET_THREADS};
+    std::vector<SocketHandlerShard> m_socket_handlers;
+
     std::thread threadDNSAddressSeed;
-    std::thread threadSocketHandler;
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
     std::thread threadMessageHandler;
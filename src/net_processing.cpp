@@ -57,6 +57,7 @@ using node::fImporting;
 using node::fPruneMode;
 using node::fReindex;
 using node::ReadBlockFromDisk;
+using node::ReadRawBlockFromDisk;
 
 /** How long to cache transactions in mapRelay for normal relay */
 static constexpr auto RELAY_TX_CACHE_TIME = 15min;
@@ -180,6 +181,11 @@ static constexpr DataRequestParameters PROOF_REQUEST_PARAMS{
  * for compatibility.
  */
 static const unsigned int MAX_GETDATA_SZ = 1000;
+/**
+ * Maximum number of transactions queued by a peer which are validated together
+ * with the one being processed.
+ */
+static constexpr size_t MAX_TX_BATCH_SIZE{32};
 /**
  * Number of blocks that can be requested at any given time from a single peer.
  */
@@ -600,6 +606,17 @@ private:
 
     void ProcessOrphanTx(const Config &config, std::set<TxId> &orphan_work_set)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans);
+    /**
+     * Take the tx messages queued right behind the one being processed, up to
+     * MAX_TX_BATCH_SIZE transactions in total, so that they are validated as
+     * a batch.
+     */
+    void TakeQueuedTransactions(CNode &pfrom,
+                                std::vector<CTransactionRef> &txns);
+    /** Handle the mempool acceptance result of a tx received from a peer. */
+    void ProcessTxResult(CNode &pfrom, Peer &peer, const CTransactionRef &ptx,
+                         const MempoolAcceptResult &result)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans);
     /** Process a single headers message from a peer. */
     void ProcessHeadersMessage(const Config &config, CNode &pfrom,
                                const Peer &peer,
@@ -2232,6 +2249,31 @@ static std::shared_ptr<const CBlock>
 static std::shared_ptr<const CBlockHeaderAndShortTxIDs>
     most_recent_compact_block GUARDED_BY(cs_most_recent_block);
 static uint256 most_recent_block_hash GUARDED_BY(cs_most_recent_block);
+// The messages for the most recent block are serialized once and shared by all
+// the peers they are sent to. The block message is only built on request.
+static std::shared_ptr<const CSharedNetMsg>
+    most_recent_block_msg GUARDED_BY(cs_most_recent_block);
+static std::shared_ptr<const CSharedNetMsg>
+    most_recent_compact_block_msg GUARDED_BY(cs_most_recent_block);
+
+/**
+ * Get the block message for the most recent block, serializing it if this is
+ * the first time it is requested.
+ * @returns nullptr if the block is not the most recent one anymore.
+ */
+static std::shared_ptr<const CSharedNetMsg>
+GetMostRecentBlockMsg(const BlockHash &hash) {
+    LOCK(cs_most_recent_block);
+    if (!most_recent_block || most_recent_block_hash != hash) {
+        return nullptr;
+    }
+    if (!most_recent_block_msg) {
+        most_recent_block_msg = std::make_shared<const CSharedNetMsg>(
+            CNetMsgMaker(PROTOCOL_VERSION)
+                .Make(NetMsgType::BLOCK, *most_recent_block));
+    }
+    return most_recent_block_msg;
+}
 
 /**
  * Maintain state about the best-seen block and fast-announce a compact block
@@ -2242,6 +2284,8 @@ void PeerManagerImpl::NewPoWValidBlock(
     std::shared_ptr<const CBlockHeaderAndShortTxIDs> pcmpctblock =
         std::make_shared<const CBlockHeaderAndShortTxIDs>(*pblock);
     const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    auto cmpctblock_msg = std::make_shared<const CSharedNetMsg>(
+        msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock));
 
     LOCK(cs_main);
 
@@ -2258,14 +2302,15 @@ void PeerManagerImpl::NewPoWValidBlock(
         most_recent_block_hash = hashBlock;
         most_recent_block = pblock;
         most_recent_compact_block = pcmpctblock;
+        most_recent_block_msg.reset();
+        most_recent_compact_block_msg = cmpctblock_msg;
     }
 
     m_connman.ForEachNode(
-        [this, &pcmpctblock, pindex, &msgMaker,
+        [this, &cmpctblock_msg, pindex,
          &hashBlock](CNode *pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
             AssertLockHeld(::cs_main);
 
-            // TODO: Avoid the repeated-serialization here
             if (pnode->GetCommonVersion() < INVALID_CB_NO_BAN_VERSION ||
                 pnode->fDisconnect) {
                 return;
@@ -2281,8 +2326,7 @@ void PeerManagerImpl::NewPoWValidBlock(
                          "%s sending header-and-ids %s to peer=%d\n",
                          "PeerManager::NewPoWValidBlock", hashBlock.ToString(),
                          pnode->GetId());
-                m_connman.PushMessage(
-                    pnode, msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock));
+                m_connman.PushMessage(pnode, *cmpctblock_msg);
                 state.pindexBestHeaderSent = pindex;
             }
         });
@@ -2580,7 +2624,7 @@ void PeerManagerImpl::ProcessGetBlockData(const Config &config, CNode &pfrom,
     std::shared_ptr<const CBlock> pblock;
     if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
         pblock = a_recent_block;
-    } else {
+    } else if (!inv.IsMsgBlk()) {
         // Send block from disk
         std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
         if (!ReadBlockFromDisk(*pblockRead, pindex,
@@ -2590,8 +2634,29 @@ void PeerManagerImpl::ProcessGetBlockData(const Config &config, CNode &pfrom,
         pblock = pblockRead;
     }
     if (inv.IsMsgBlk()) {
-        m_connman.PushMessage(&pfrom,
-                              msgMaker.Make(NetMsgType::BLOCK, *pblock));
+        if (pblock) {
+            // The most recent block is requested by many peers at once, send
+            // them all the same serialized message.
+            std::shared_ptr<const CSharedNetMsg> block_msg =
+                GetMostRecentBlockMsg(hash);
+            if (block_msg) {
+                m_connman.PushMessage(&pfrom, *block_msg);
+            } else {
+                m_connman.PushMessage(
+                    &pfrom, msgMaker.Make(NetMsgType::BLOCK, *pblock));
+            }
+        } else {
+            // Send the block from disk as it is stored: the serialization is
+            // the same, so there is no need to deserialize it. The bytes are
+            // read straight into the message buffer.
+            CSerializedNetMsg msg;
+            msg.m_type = NetMsgType::BLOCK;
+            if (!ReadRawBlockFromDisk(msg.data, pindex,
+                                      m_chainparams.DiskMagic())) {
+                assert(!"cannot load block from disk");
+            }
+            m_connman.PushMessage(&pfrom, std::move(msg));
+        }
     } else if (inv.IsMsgFilteredBlk()) {
         bool sendMerkleBlock = false;
         CMerkleBlock merkleBlock;
@@ -3179,6 +3244,157 @@ void PeerManagerImpl::ProcessOrphanTx(const Config &config,
     }
 }
 
+void PeerManagerImpl::TakeQueuedTransactions(
+    CNode &pfrom, std::vector<CTransactionRef> &txns) {
+    LOCK(pfrom.cs_vProcessMsg);
+    while (txns.size() < MAX_TX_BATCH_SIZE && !pfrom.vProcessMsg.empty()) {
+        CNetMessage &msg = pfrom.vProcessMsg.front();
+        if (msg.m_command != NetMsgType::TX || !msg.m_valid_netmagic ||
+            !msg.m_valid_header || !msg.m_valid_checksum) {
+            break;
+        }
+
+        CTransactionRef ptx;
+        try {
+            // Leave the message untouched if it can't be deserialized, so the
+            // error is reported when it gets processed on its own.
+            CDataStream stream{msg.m_recv};
+            stream.SetVersion(pfrom.GetCommonVersion());
+            stream >> ptx;
+        } catch (const std::exception &) {
+            break;
+        }
+
+        if (gArgs.GetBoolArg("-capturemessages", false)) {
+            CaptureMessage(pfrom.addr, msg.m_command,
+                           MakeUCharSpan(msg.m_recv), /*is_incoming=*/true);
+        }
+        pfrom.nProcessQueueSize -= msg.m_raw_message_size;
+        pfrom.vProcessMsg.pop_front();
+        txns.push_back(std::move(ptx));
+    }
+    pfrom.fPauseRecv =
+        pfrom.nProcessQueueSize > m_connman.GetReceiveFloodSize();
+}
+
+void PeerManagerImpl::ProcessTxResult(CNode &pfrom, Peer &peer,
+                                      const CTransactionRef &ptx,
+                                      const MempoolAcceptResult &result) {
+    AssertLockHeld(cs_main);
+    AssertLockHeld(g_cs_orphans);
+    const CTransaction &tx = *ptx;
+    const TxValidationState &state = result.m_state;
+
+    if (result.m_result_type == MempoolAcceptResult::ResultType::VALID) {
+        // As this version of the transaction was acceptable, we can forget
+        // about any requests for it.
+        m_txrequest.ForgetInvId(tx.GetId());
+        RelayTransaction(tx.GetId());
+        m_orphanage.AddChildrenToWorkSet(tx, peer.m_orphan_work_set);
+
+        pfrom.m_last_tx_time = GetTime<std::chrono::seconds>();
+
+        LogPrint(BCLog::MEMPOOL,
+                 "AcceptToMemoryPool: peer=%d: accepted %s "
+                 "(poolsz %u txn, %u kB)\n",
+                 pfrom.GetId(), tx.GetId().ToString(), m_mempool.size(),
+                 m_mempool.DynamicMemoryUsage() / 1000);
+    } else if (state.GetResult() == TxValidationResult::TX_MISSING_INPUTS) {
+        // It may be the case that the orphans parents have all been
+        // rejected.
+        bool fRejectedParents = false;
+
+        // Deduplicate parent txids, so that we don't have to loop over
+        // the same parent txid more than once down below.
+        std::vector<TxId> unique_parents;
+        unique_parents.reserve(tx.vin.size());
+        for (const CTxIn &txin : tx.vin) {
+            // We start with all parents, and then remove duplicates below.
+            unique_parents.push_back(txin.prevout.GetTxId());
+        }
+        std::sort(unique_parents.begin(), unique_parents.end());
+        unique_parents.erase(
+            std::unique(unique_parents.begin(), unique_parents.end()),
+            unique_parents.end());
+        for (const TxId &parent_txid : unique_parents) {
+            if (m_recent_rejects.contains(parent_txid)) {
+                fRejectedParents = true;
+                break;
+            }
+        }
+        if (!fRejectedParents) {
+            const auto current_time{GetTime<std::chrono::microseconds>()};
+
+            for (const TxId &parent_txid : unique_parents) {
+                // FIXME: MSG_TX should use a TxHash, not a TxId.
+                pfrom.AddKnownTx(parent_txid);
+                if (!AlreadyHaveTx(parent_txid)) {
+                    AddTxAnnouncement(pfrom, parent_txid, current_time);
+                }
+            }
+
+            if (m_orphanage.AddTx(ptx, pfrom.GetId())) {
+                AddToCompactExtraTransactions(ptx);
+            }
+
+            // Once added to the orphan pool, a tx is considered
+            // AlreadyHave, and we shouldn't request it anymore.
+            m_txrequest.ForgetInvId(tx.GetId());
+
+            // DoS prevention: do not allow m_orphanage to grow
+            // unbounded (see CVE-2012-3789)
+            unsigned int nMaxOrphanTx = (unsigned int)std::max(
+                int64_t(0),
+                gArgs.GetIntArg("-maxorphantx",
+                                DEFAULT_MAX_ORPHAN_TRANSACTIONS));
+            unsigned int nEvicted = m_orphanage.LimitOrphans(nMaxOrphanTx);
+            if (nEvicted > 0) {
+                LogPrint(BCLog::MEMPOOL,
+                         "orphanage overflow, removed %u tx\n", nEvicted);
+            }
+        } else {
+            LogPrint(BCLog::MEMPOOL,
+                     "not keeping orphan with rejected parents %s\n",
+                     tx.GetId().ToString());
+            // We will continue to reject this tx since it has rejected
+            // parents so avoid re-requesting it from other peers.
+            m_recent_rejects.insert(tx.GetId());
+            m_txrequest.ForgetInvId(tx.GetId());
+        }
+    } else {
+        m_recent_rejects.insert(tx.GetId());
+        m_txrequest.ForgetInvId(tx.GetId());
+
+        if (RecursiveDynamicUsage(*ptx) < 100000) {
+            AddToCompactExtraTransactions(ptx);
+        }
+    }
+
+    // If a tx has been detected by m_recent_rejects, we will have reached
+    // this point and the tx will have been ignored. Because we haven't
+    // submitted the tx to our mempool, we won't have computed a DoS
+    // score for it or determined exactly why we consider it invalid.
+    //
+    // This means we won't penalize any peer subsequently relaying a DoSy
+    // tx (even if we penalized the first peer who gave it to us) because
+    // we have to account for m_recent_rejects showing false positives. In
+    // other words, we shouldn't penalize a peer if we aren't *sure* they
+    // submitted a DoSy tx.
+    //
+    // Note that m_recent_rejects doesn't just record DoSy or invalid
+    // transactions, but any tx not accepted by the mempool, which may be
+    // due to node policy (vs. consensus). So we can't blanket penalize a
+    // peer simply for relaying a tx that our m_recent_rejects has caught,
+    // regardless of false positives.
+
+    if (state.IsInvalid()) {
+        LogPrint(BCLog::MEMPOOLREJ,
+                 "%s from peer=%d was not accepted: %s\n",
+                 tx.GetHash().ToString(), pfrom.GetId(), state.ToString());
+        MaybePunishNodeForTx(pfrom.GetId(), state);
+    }
+}
+
 bool PeerManagerImpl::PrepareBlockFilterRequest(
     CNode &peer, BlockFilterType filter_type, uint32_t start_height,
     const BlockHash &stop_hash, uint32_t max_height_diff,
@@ -4382,147 +4598,70 @@ void PeerManagerImpl::ProcessMessage(
 
         CTransactionRef ptx;
         vRecv >> ptx;
-        const CTransaction &tx = *ptx;
-        const TxId &txid = tx.GetId();
-        pfrom.AddKnownTx(txid);
-
-        LOCK2(cs_main, g_cs_orphans);
-
-        m_txrequest.ReceivedResponse(pfrom.GetId(), txid);
-
-        if (AlreadyHaveTx(txid)) {
-            if (pfrom.HasPermission(NetPermissionFlags::ForceRelay)) {
-                // Always relay transactions received from peers with
-                // forcerelay permission, even if they were already in the
-                // mempool, allowing the node to function as a gateway for
-                // nodes hidden behind it.
-                if (!m_mempool.exists(tx.GetId())) {
-                    LogPrintf("Not relaying non-mempool transaction %s from "
-                              "forcerelay peer=%d\n",
-                              tx.GetId().ToString(), pfrom.GetId());
-                } else {
-                    LogPrintf("Force relaying tx %s from peer=%d\n",
-                              tx.GetId().ToString(), pfrom.GetId());
-                    RelayTransaction(tx.GetId());
-                }
-            }
-            return;
+        // Peers send the transactions they announced together in a row.
+        // Validate the ones that are already queued along with this one, so
+        // that their scripts are checked in parallel.
+        std::vector<CTransactionRef> txns{ptx};
+        TakeQueuedTransactions(pfrom, txns);
+        for (const CTransactionRef &queued_tx : txns) {
+            pfrom.AddKnownTx(queued_tx->GetId());
         }
 
-        const MempoolAcceptResult result = m_chainman.ProcessTransaction(ptx);
-        const TxValidationState &state = result.m_state;
-
-        if (result.m_result_type == MempoolAcceptResult::ResultType::VALID) {
-            // As this version of the transaction was acceptable, we can forget
-            // about any requests for it.
-            m_txrequest.ForgetInvId(tx.GetId());
-            RelayTransaction(tx.GetId());
-            m_orphanage.AddChildrenToWorkSet(tx, peer->m_orphan_work_set);
+        LOCK2(cs_main, g_cs_orphans);
 
-            pfrom.m_last_tx_time = GetTime<std::chrono::seconds>();
+        std::vector<CTransactionRef> txns_new;
+        std::set<TxId> txids_new;
+        for (const CTransactionRef &queued_tx : txns) {
+            const CTransaction &tx = *queued_tx;
+            const TxId &txid = tx.GetId();
 
-            LogPrint(BCLog::MEMPOOL,
-                     "AcceptToMemoryPool: peer=%d: accepted %s "
-                     "(poolsz %u txn, %u kB)\n",
-                     pfrom.GetId(), tx.GetId().ToString(), m_mempool.size(),
-                     m_mempool.DynamicMemoryUsage() / 1000);
+            m_txrequest.ReceivedResponse(pfrom.GetId(), txid);
 
-            // Recursively process any orphan transactions that depended on this
-            // one
-            ProcessOrphanTx(config, peer->m_orphan_work_set);
-        } else if (state.GetResult() == TxValidationResult::TX_MISSING_INPUTS) {
-            // It may be the case that the orphans parents have all been
-            // rejected.
-            bool fRejectedParents = false;
-
-            // Deduplicate parent txids, so that we don't have to loop over
-            // the same parent txid more than once down below.
-            std::vector<TxId> unique_parents;
-            unique_parents.reserve(tx.vin.size());
-            for (const CTxIn &txin : tx.vin) {
-                // We start with all parents, and then remove duplicates below.
-                unique_parents.push_back(txin.prevout.GetTxId());
-            }
-            std::sort(unique_parents.begin(), unique_parents.end());
-            unique_parents.erase(
-                std::unique(unique_parents.begin(), unique_parents.end()),
-                unique_parents.end());
-            for (const TxId &parent_txid : unique_parents) {
-                if (m_recent_rejects.contains(parent_txid)) {
-                    fRejectedParents = true;
-                    break;
-                }
+            if (txids_new.count(txid)) {
+                continue;
             }
-            if (!fRejectedParents) {
-                const auto current_time{GetTime<std::chrono::microseconds>()};
-
-                for (const TxId &parent_txid : unique_parents) {
-                    // FIXME: MSG_TX should use a TxHash, not a TxId.
-                    pfrom.AddKnownTx(parent_txid);
-                    if (!AlreadyHaveTx(parent_txid)) {
-                        AddTxAnnouncement(pfrom, parent_txid, current_time);
-                    }
-                }
 
-                if (m_orphanage.AddTx(ptx, pfrom.GetId())) {
-                    AddToCompactExtraTransactions(ptx);
-                }
-
-                // Once added to the orphan pool, a tx is considered
-                // AlreadyHave, and we shouldn't request it anymore.
-                m_txrequest.ForgetInvId(tx.GetId());
-
-                // DoS prevention: do not allow m_orphanage to grow
-                // unbounded (see CVE-2012-3789)
-                unsigned int nMaxOrphanTx = (unsigned int)std::max(
-                    int64_t(0),
-                    gArgs.GetIntArg("-maxorphantx",
-                                    DEFAULT_MAX_ORPHAN_TRANSACTIONS));
-                unsigned int nEvicted = m_orphanage.LimitOrphans(nMaxOrphanTx);
-                if (nEvicted > 0) {
-                    LogPrint(BCLog::MEMPOOL,
-                             "orphanage overflow, removed %u tx\n", nEvicted);
+            if (AlreadyHaveTx(txid)) {
+                if (pfrom.HasPermission(NetPermissionFlags::ForceRelay)) {
+                    // Always relay transactions received from peers with
+                    // forcerelay permission, even if they were already in the
+                    // mempool, allowing the node to function as a gateway for
+                    // nodes hidden behind it.
+                    if (!m_mempool.exists(tx.GetId())) {
+                        LogPrintf(
+                            "Not relaying non-mempool transaction %s from "
+                            "forcerelay peer=%d\n",
+                            tx.GetId().ToString(), pfrom.GetId());
+                    } else {
+                        LogPrintf("Force relaying tx %s from peer=%d\n",
+                                  tx.GetId().ToString(), pfrom.GetId());
+                        RelayTransaction(tx.GetId());
+                    }
                 }
-            } else {
-                LogPrint(BCLog::MEMPOOL,
-                         "not keeping orphan with rejected parents %s\n",
-                         tx.GetId().ToString());
-                // We will continue to reject this tx since it has rejected
-                // parents so avoid re-requesting it from other peers.
-                m_recent_rejects.insert(tx.GetId());
-                m_txrequest.ForgetInvId(tx.GetId());
+                continue;
             }
-        } else {
-            m_recent_rejects.insert(tx.GetId());
-            m_txrequest.ForgetInvId(tx.GetId());
 
-            if (RecursiveDynamicUsage(*ptx) < 100000) {
-                AddToCompactExtraTransactions(ptx);
-            }
+            txns_new.push_back(queued_tx);
+            txids_new.insert(txid);
         }
 
-        // If a tx has been detected by m_recent_rejects, we will have reached
-        // this point and the tx will have been ignored. Because we haven't
-        // submitted the tx to our mempool, we won't have computed a DoS
-        // score for it or determined exactly why we consider it invalid.
-        //
-        // This means we won't penalize any peer subsequently relaying a DoSy
-        // tx (even if we penalized the first peer who gave it to us) because
-        // we have to account for m_recent_rejects showing false positives. In
-        // other words, we shouldn't penalize a peer if we aren't *sure* they
-        // submitted a DoSy tx.
-        //
-        // Note that m_recent_rejects doesn't just record DoSy or invalid
-        // transactions, but any tx not accepted by the mempool, which may be
-        // due to node policy (vs. consensus). So we can't blanket penalize a
-        // peer simply for relaying a tx that our m_recent_rejects has caught,
-        // regardless of false positives.
+        if (txns_new.empty()) {
+            return;
+        }
 
-        if (state.IsInvalid()) {
-            LogPrint(BCLog::MEMPOOLREJ,
-                     "%s from peer=%d was not accepted: %s\n",
-                     tx.GetHash().ToString(), pfrom.GetId(), state.ToString());
-            MaybePunishNodeForTx(pfrom.GetId(), state);
+        const std::vector<MempoolAcceptResult> results =
+            m_chainman.ProcessTransactions(txns_new);
+        bool any_accepted = false;
+        for (size_t i = 0; i < txns_new.size(); ++i) {
+            ProcessTxResult(pfrom, *peer, txns_new[i], results[i]);
+            any_accepted |= results[i].m_result_type ==
+                            MempoolAcceptResult::ResultType::VALID;
+        }
+
+        // Recursively process any orphan transactions that depended on the
+        // accepted ones
+        if (any_accepted) {
+            ProcessOrphanTx(config, peer->m_orphan_work_set);
         }
         return;
     }
@@ -6689,12 +6828,8 @@ bool PeerManagerImpl::SendMessages(const Config &config, CNode *pto) {
                         LOCK(cs_most_recent_block);
                         if (most_recent_block_hash ==
                             pBestIndex->GetBlockHash()) {
-                            CBlockHeaderAndShortTxIDs cmpctblock(
-                                *most_recent_block);
                             m_connman.PushMessage(
-                                pto, msgMaker.Make(nSendFlags,
-                                                   NetMsgType::CMPCTBLOCK,
-                                                   cmpctblock));
+                                pto, *most_recent_compact_block_msg);
                             fGotBlockFromCache = true;
                         }
                     }
@@ -18,17 +18,22 @@
 #include <shutdown.h>
 #include <streams.h>
 #include <undo.h>
+#include <util/strencodings.h>
 #include <util/system.h>
+#include <util/thread.h>
+#include <util/time.h>
 #include <validation.h>
 
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
 namespace node {
 std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
 bool fPruneMode = false;
 uint64_t nPruneTarget = 0;
 
-static FILE *OpenUndoFile(const FlatFilePos &pos, bool fReadOnly = false);
-
 static FlatFileSeq BlockFileSeq();
 static FlatFileSeq UndoFileSeq();
 
@@ -568,7 +573,7 @@ FILE *OpenBlockFile(const FlatFilePos &pos, bool fReadOnly) {
 }
 
 /** Open an undo file (rev?????.dat) */
-static FILE *OpenUndoFile(const FlatFilePos &pos, bool fReadOnly) {
+FILE *OpenUndoFile(const FlatFilePos &pos, bool fReadOnly) {
     return UndoFileSeq().Open(pos, fReadOnly);
 }
 
@@ -773,6 +778,78 @@ bool ReadBlockFromDisk(CBlock &block, const CBlockIndex *pindex,
     return true;
 }
 
+bool ReadRawBlockFromDisk(std::vector<uint8_t> &block, const FlatFilePos &pos,
+                          const CMessageHeader::MessageMagic &message_start) {
+    if (pos.nPos < STORAGE_HEADER_BYTES) {
+        return error("%s: Invalid block position %s", __func__,
+                     pos.ToString());
+    }
+
+    // Open history file to read, from the header in front of the block
+    const FlatFilePos header_pos(pos.nFile, pos.nPos - STORAGE_HEADER_BYTES);
+    CAutoFile filein(OpenBlockFile(header_pos, true), SER_DISK,
+                     CLIENT_VERSION);
+    if (filein.IsNull()) {
+        return error("%s: OpenBlockFile failed for %s", __func__,
+                     pos.ToString());
+    }
+
+    try {
+        CMessageHeader::MessageMagic block_start;
+        unsigned int block_size;
+        filein >> block_start >> block_size;
+        if (block_start != message_start) {
+            return error("%s: Block magic mismatch for %s: %s versus "
+                         "expected %s",
+                         __func__, pos.ToString(), HexStr(block_start),
+                         HexStr(message_start));
+        }
+
+        // Don't trust the size read from disk to allocate the buffer.
+        if (block_size > GetConfig().GetMaxBlockSize()) {
+            return error("%s: Block size %u exceeds the maximum for %s",
+                         __func__, block_size, pos.ToString());
+        }
+
+        block.resize(block_size);
+        filein.read(reinterpret_cast<char *>(block.data()), block_size);
+    } catch (const std::exception &e) {
+        return error("%s: Read from block file failed: %s for %s", __func__,
+                     e.what(), pos.ToString());
+    }
+
+    return true;
+}
+
+bool ReadRawBlockFromDisk(std::vector<uint8_t> &block,
+                          const CBlockIndex *pindex,
+                          const CMessageHeader::MessageMagic &message_start) {
+    const FlatFilePos block_pos{
+        WITH_LOCK(cs_main, return pindex->GetBlockPos())};
+
+    if (!ReadRawBlockFromDisk(block, block_pos, message_start)) {
+        return false;
+    }
+
+    // Only the header needs to be deserialized to check the block is the one
+    // expected.
+    CBlockHeader header;
+    try {
+        VectorReader(SER_DISK, CLIENT_VERSION, block, 0) >> header;
+    } catch (const std::exception &e) {
+        return error("%s: Deserialize error - %s at %s", __func__, e.what(),
+                     block_pos.ToString());
+    }
+    if (header.GetHash() != pindex->GetBlockHash()) {
+        return error("ReadRawBlockFromDisk(std::vector<uint8_t>&, "
+                     "CBlockIndex*): GetHash() doesn't match index for %s at "
+                     "%s",
+                     pindex->ToString(), block_pos.ToString());
+    }
+
+    return true;
+}
+
 bool ReadTxFromDisk(CMutableTransaction &tx, const FlatFilePos &pos) {
     // Open history file to read
     CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
@@ -850,6 +927,201 @@ struct CImportingNow {
     }
 };
 
+namespace {
+/**
+ * Maximum serialized size of the blocks read ahead of the import from a
+ * single block file during -reindex.
+ */
+static constexpr size_t MAX_REINDEX_BUFFER_BYTES = 32 * 1024 * 1024;
+
+/**
+ * Reads the block files on several threads during -reindex. Locating and
+ * deserializing the blocks and running the context free checks on them is
+ * done in parallel, one file per thread, while the blocks are handed out in
+ * file order for the block index to be rebuilt exactly as if the files were
+ * read one after the other.
+ */
+class BlockFileReader {
+public:
+    BlockFileReader(const Config &config, int num_files, int num_threads)
+        : m_config(config), m_files(num_files) {
+        for (int i = 0; i < std::min(num_threads, num_files); ++i) {
+            m_threads.emplace_back(&util::TraceThread, "reindex",
+                                   [this] { ThreadRead(); });
+        }
+    }
+
+    ~BlockFileReader() {
+        WITH_LOCK(m_mutex, m_stop = true);
+        m_cv.notify_all();
+        for (std::thread &thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    /**
+     * Wait for the next block of a file.
+     * @returns false once all the blocks of the file were returned.
+     */
+    bool Next(int file, std::shared_ptr<CBlock> &block, FlatFilePos &pos)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        {
+            WAIT_LOCK(m_mutex, lock);
+            File &f = m_files[file];
+            m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                return f.done || !f.blocks.empty();
+            });
+            if (f.blocks.empty()) {
+                return false;
+            }
+            BufferedBlock &next = f.blocks.front();
+            block = std::move(next.block);
+            pos = next.pos;
+            f.bytes -= next.size;
+            f.blocks.pop_front();
+        }
+        m_cv.notify_all();
+        return true;
+    }
+
+    /** Whether the file could be opened, once all its blocks were read. */
+    bool Opened(int file) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        return WITH_LOCK(m_mutex, return m_files[file].opened);
+    }
+
+private:
+    struct BufferedBlock {
+        std::shared_ptr<CBlock> block;
+        FlatFilePos pos;
+        size_t size;
+    };
+
+    struct File {
+        std::deque<BufferedBlock> blocks;
+        //! Serialized size of the blocks.
+        size_t bytes{0};
+        bool opened{false};
+        bool done{false};
+    };
+
+    void ThreadRead() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        const CChainParams &params = m_config.GetChainParams();
+        const BlockValidationOptions options(m_config);
+        while (true) {
+            int file;
+            {
+                LOCK(m_mutex);
+                if (m_stop || m_next_file == int(m_files.size())) {
+                    return;
+                }
+                file = m_next_file++;
+            }
+
+            FlatFilePos pos(file, 0);
+            FILE *fileIn = OpenBlockFile(pos, true);
+            WITH_LOCK(m_mutex, m_files[file].opened = fileIn != nullptr);
+            if (fileIn) {
+                ReadExternalBlockFile(
+                    fileIn, params, &pos,
+                    [&](const std::shared_ptr<CBlock> &block) {
+                        // Compute the merkle root ahead of AcceptBlock. A
+                        // failure is reported when the block is accepted.
+                        BlockValidationState state;
+                        CheckBlock(*block, state, params.GetConsensus(),
+                                   options);
+                        return Push(file, block, pos);
+                    });
+            }
+
+            WITH_LOCK(m_mutex, m_files[file].done = true);
+            m_cv.notify_all();
+        }
+    }
+
+    /**
+     * Buffer a block, waiting while the file has too many blocks buffered
+     * already.
+     * @returns false if reading should stop.
+     */
+    bool Push(int file, const std::shared_ptr<CBlock> &block,
+              const FlatFilePos &pos) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        const size_t size = ::GetSerializeSize(*block, PROTOCOL_VERSION);
+        {
+            WAIT_LOCK(m_mutex, lock);
+            File &f = m_files[file];
+            m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                return m_stop || f.blocks.empty() ||
+                       f.bytes + size <= MAX_REINDEX_BUFFER_BYTES;
+            });
+            if (m_stop) {
+                return false;
+            }
+            f.blocks.push_back({block, pos, size});
+            f.bytes += size;
+        }
+        m_cv.notify_all();
+        return true;
+    }
+
+    const Config &m_config;
+
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<File> m_files GUARDED_BY(m_mutex);
+    //! Next file to be read by a thread.
+    int m_next_file GUARDED_BY(m_mutex){0};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_threads;
+};
+} // namespace
+
+/**
+ * Rebuild the block index from the block files, reading them on several
+ * threads.
+ * @returns false if a shutdown was requested.
+ */
+static bool ReindexBlockFiles(const Config &config, Chainstate &chainstate,
+                              int num_threads) {
+    int num_files = 0;
+    while (fs::exists(GetBlockPosFilename(FlatFilePos(num_files, 0)))) {
+        ++num_files;
+    }
+
+    BlockFileReader reader(config, num_files, num_threads);
+    for (int nFile = 0; nFile < num_files; ++nFile) {
+        LogPrintf("Reindexing block file blk%05u.dat...\n",
+                  (unsigned int)nFile);
+        int64_t nStart = GetTimeMillis();
+        int nLoaded = 0;
+        bool fContinue = true;
+        std::shared_ptr<CBlock> pblock;
+        FlatFilePos pos;
+        while (reader.Next(nFile, pblock, pos)) {
+            // Keep draining the file after an error, like the rest of the
+            // file is skipped when reading it directly.
+            if (fContinue) {
+                try {
+                    fContinue = chainstate.LoadExternalBlock(config, pblock,
+                                                             &pos, nLoaded);
+                } catch (const std::exception &e) {
+                    LogPrintf("%s: Deserialize or I/O error - %s\n",
+                              __func__, e.what());
+                }
+            }
+        }
+        if (!reader.Opened(nFile)) {
+            // This error is logged in OpenBlockFile
+            break;
+        }
+        LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded,
+                  GetTimeMillis() - nStart);
+        if (ShutdownRequested()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void ThreadImport(const Config &config, ChainstateManager &chainman,
                   std::vector<fs::path> vImportFiles, const ArgsManager &args) {
     ScheduleBatchPriority();
@@ -860,7 +1132,15 @@ void ThreadImport(const Config &config, ChainstateManager &chainman,
         CImportingNow imp;
 
         // -reindex
-        if (fReindex) {
+        const int reindex_threads =
+            args.GetIntArg("-reindexthreads", DEFAULT_REINDEX_THREADS);
+        if (fReindex && reindex_threads > 1) {
+            if (!ReindexBlockFiles(config, chainman.ActiveChainstate(),
+                                   reindex_threads)) {
+                LogPrintf("Shutdown requested. Exit %s\n", __func__);
+                return;
+            }
+        } else if (fReindex) {
             int nFile = 0;
             while (true) {
                 FlatFilePos pos(nFile, 0);
@@ -883,6 +1163,8 @@ void ThreadImport(const Config &config, ChainstateManager &chainman,
                 }
                 nFile++;
             }
+        }
+        if (fReindex) {
             WITH_LOCK(
                 ::cs_main,
                 chainman.m_blockman.m_block_tree_db->WriteReindexing(false));
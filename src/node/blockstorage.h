@@ -36,6 +36,8 @@ struct Params;
 
 namespace node {
 static constexpr bool DEFAULT_STOPAFTERBLOCKIMPORT{false};
+/** Default number of threads reading the block files during -reindex. */
+static constexpr int DEFAULT_REINDEX_THREADS{4};
 
 /** The pre-allocation chunk size for blk?????.dat files (since 0.8) */
 static constexpr unsigned int BLOCKFILE_CHUNK_SIZE = 0x1000000; // 16 MiB
@@ -43,6 +45,12 @@ static constexpr unsigned int BLOCKFILE_CHUNK_SIZE = 0x1000000; // 16 MiB
 static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 /** The maximum size of a blk?????.dat file (since 0.8) */
 static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
+/**
+ * Size of the header in front of each block and undo data in the files: the
+ * disk magic and the size of the data.
+ */
+static constexpr unsigned int STORAGE_HEADER_BYTES =
+    CMessageHeader::MESSAGE_START_SIZE + sizeof(unsigned int);
 
 extern std::atomic_bool fImporting;
 extern std::atomic_bool fReindex;
@@ -206,6 +214,8 @@ void CleanupBlockRevFiles();
 
 /** Open a block file (blk?????.dat) */
 FILE *OpenBlockFile(const FlatFilePos &pos, bool fReadOnly = false);
+/** Open an undo file (rev?????.dat) */
+FILE *OpenUndoFile(const FlatFilePos &pos, bool fReadOnly = false);
 /** Translation to a filesystem path. */
 fs::path GetBlockPosFilename(const FlatFilePos &pos);
 
@@ -220,6 +230,15 @@ bool ReadBlockFromDisk(CBlock &block, const FlatFilePos &pos,
 bool ReadBlockFromDisk(CBlock &block, const CBlockIndex *pindex,
                        const Consensus::Params &consensusParams);
 bool UndoReadFromDisk(CBlockUndo &blockundo, const CBlockIndex *pindex);
+/**
+ * Read the serialized block stored at pos as is, without deserializing it, e.g.
+ * to send it to a peer.
+ */
+bool ReadRawBlockFromDisk(std::vector<uint8_t> &block, const FlatFilePos &pos,
+                          const CMessageHeader::MessageMagic &message_start);
+bool ReadRawBlockFromDisk(std::vector<uint8_t> &block,
+                          const CBlockIndex *pindex,
+                          const CMessageHeader::MessageMagic &message_start);
 
 /** Functions for disk access for txs */
 bool ReadTxFromDisk(CMutableTransaction &tx, const FlatFilePos &pos);
@@ -0,0 +1,291 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/coinsprefetch.h>
+
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <consensus/validation.h>
+#include <primitives/block.h>
+#include <serialize.h>
+#include <txdb.h>
+#include <util/thread.h>
+#include <util/time.h>
+#include <validation.h>
+#include <version.h>
+
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+
+namespace node {
+
+CoinsPrefetcher::CoinsPrefetcher(CCoinsViewBackgroundFlush &view,
+                                 const Consensus::Params &params)
+    : m_view(view), m_params(params) {}
+
+CoinsPrefetcher::~CoinsPrefetcher() {
+    {
+        LOCK(m_mutex);
+        m_stop = true;
+        m_queue.clear();
+    }
+    m_cv.notify_all();
+    for (std::thread &thread : m_threads) {
+        thread.join();
+    }
+}
+
+void CoinsPrefetcher::Prefetch(
+    const std::vector<std::pair<BlockHash, FlatFilePos>> &blocks,
+    uint64_t excessive_block_size) {
+    {
+        LOCK(m_mutex);
+        m_excessive_block_size = excessive_block_size;
+
+        // Drop the blocks that are not going to be connected anymore, e.g.
+        // after a reorg.
+        std::set<BlockHash> upcoming;
+        for (const auto &block : blocks) {
+            upcoming.insert(block.first);
+        }
+        for (auto it = m_ready.begin(); it != m_ready.end();) {
+            if (upcoming.count(it->first)) {
+                ++it;
+            } else {
+                EraseReady(it++);
+            }
+        }
+        for (auto it = m_queue.begin(); it != m_queue.end();) {
+            if (upcoming.count(it->first)) {
+                ++it;
+            } else {
+                m_pending.erase(it->first);
+                it = m_queue.erase(it);
+            }
+        }
+
+        for (const auto &[block_hash, pos] : blocks) {
+            if (m_pending.size() + m_ready.size() >= MAX_PREFETCH_BLOCKS) {
+                break;
+            }
+            if (m_pending.count(block_hash) || m_ready.count(block_hash)) {
+                continue;
+            }
+            m_pending.insert(block_hash);
+            m_queue.emplace_back(block_hash, pos);
+        }
+        if (m_queue.empty()) {
+            return;
+        }
+        if (m_threads.empty()) {
+            for (int i = 0; i < COINS_PREFETCH_THREADS; ++i) {
+                m_threads.emplace_back(&util::TraceThread, "coinsprefetch",
+                                       [this] { ThreadPrefetch(); });
+            }
+        }
+    }
+    m_cv.notify_all();
+}
+
+std::shared_ptr<const CBlock>
+CoinsPrefetcher::TakeBlock(const BlockHash &block_hash) {
+    std::shared_ptr<const CBlock> block;
+    {
+        WAIT_LOCK(m_mutex, lock);
+        // If the block is still queued, reading it right away is faster than
+        // waiting for the threads to get to it.
+        auto queued = std::find_if(
+            m_queue.begin(), m_queue.end(),
+            [&](const auto &entry) { return entry.first == block_hash; });
+        if (queued != m_queue.end()) {
+            m_queue.erase(queued);
+            m_pending.erase(block_hash);
+            return nullptr;
+        }
+
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return m_pending.count(block_hash) == 0;
+        });
+        auto it = m_ready.find(block_hash);
+        if (it == m_ready.end() || !it->second.block) {
+            return nullptr;
+        }
+        // Keep the coins around until ConnectBlock takes them.
+        block = std::move(it->second.block);
+        m_ready_bytes -= it->second.block_size;
+        it->second.block_size = 0;
+    }
+    m_cv.notify_all();
+    return block;
+}
+
+size_t CoinsPrefetcher::TakeCoins(const BlockHash &block_hash,
+                                  CCoinsViewCache &cache) {
+    PrefetchedBlock prefetched;
+    {
+        LOCK(m_mutex);
+        auto it = m_ready.find(block_hash);
+        if (it == m_ready.end()) {
+            // Too late, don't bother reading the coins if the block is still
+            // queued.
+            if (m_pending.erase(block_hash)) {
+                m_queue.erase(
+                    std::remove_if(m_queue.begin(), m_queue.end(),
+                                   [&](const auto &queued) {
+                                       return queued.first == block_hash;
+                                   }),
+                    m_queue.end());
+            }
+            return 0;
+        }
+        prefetched = std::move(it->second);
+        EraseReady(it);
+    }
+    m_cv.notify_all();
+
+    // Unless the view has not been written to since the coins were read, some
+    // of them may have been spent since.
+    if (prefetched.generation % 2 ||
+        prefetched.generation != m_view.GetGeneration()) {
+        return 0;
+    }
+
+    const size_t cache_size = cache.GetCacheSize();
+    for (auto &[outpoint, coin] : prefetched.coins) {
+        cache.InsertFetchedCoin(outpoint, std::move(coin));
+    }
+    return cache.GetCacheSize() - cache_size;
+}
+
+void CoinsPrefetcher::Interrupt() {
+    WAIT_LOCK(m_mutex, lock);
+    m_queue.clear();
+    m_pending.clear();
+    m_ready.clear();
+    m_ready_bytes = 0;
+    m_cv.notify_all();
+    m_cv.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return m_active == 0;
+    });
+}
+
+void CoinsPrefetcher::WaitForIdle() {
+    WAIT_LOCK(m_mutex, lock);
+    m_cv.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return m_queue.empty() && m_active == 0;
+    });
+}
+
+void CoinsPrefetcher::ThreadPrefetch() {
+    while (true) {
+        BlockHash block_hash;
+        FlatFilePos pos;
+        uint64_t excessive_block_size;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            // Don't read further ahead while enough blocks are waiting to be
+            // connected.
+            m_cv.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                return m_stop || (!m_queue.empty() &&
+                                  m_ready_bytes < MAX_PREFETCH_BLOCK_BYTES);
+            });
+            if (m_stop) {
+                return;
+            }
+            std::tie(block_hash, pos) = m_queue.front();
+            m_queue.pop_front();
+            excessive_block_size = m_excessive_block_size;
+            ++m_active;
+        }
+
+        PrefetchedBlock prefetched =
+            ReadBlock(block_hash, pos, excessive_block_size);
+
+        {
+            LOCK(m_mutex);
+            --m_active;
+            if (m_pending.erase(block_hash)) {
+                m_ready_bytes += prefetched.block_size;
+                m_ready.emplace(block_hash, std::move(prefetched));
+            }
+        }
+        m_cv.notify_all();
+    }
+}
+
+void CoinsPrefetcher::EraseReady(
+    std::map<BlockHash, PrefetchedBlock>::iterator it) {
+    m_ready_bytes -= it->second.block_size;
+    m_ready.erase(it);
+}
+
+CoinsPrefetcher::PrefetchedBlock
+CoinsPrefetcher::ReadBlock(const BlockHash &block_hash, const FlatFilePos &pos,
+                           uint64_t excessive_block_size) {
+    // Read the generation before the coins, so that a write racing with the
+    // reads below is detected when the coins are taken.
+    PrefetchedBlock prefetched{m_view.GetGeneration(), nullptr, 0, {}};
+
+    const int64_t time_start = GetTimeMicros();
+    auto pblock = std::make_shared<CBlock>();
+    if (!ReadBlockFromDisk(*pblock, pos, m_params) ||
+        pblock->GetHash() != block_hash) {
+        return prefetched;
+    }
+    const CBlock &block = *pblock;
+    const int64_t time_read = GetTimeMicros();
+
+    // Compute the merkle root and run the other context free checks now, so
+    // that ConnectBlock can skip them. The transaction hashes were computed
+    // while deserializing. A failure is reported when the block is connected.
+    BlockValidationState state;
+    CheckBlock(block, state, m_params,
+               BlockValidationOptions(excessive_block_size));
+    const int64_t time_checked = GetTimeMicros();
+
+    prefetched.block_size = ::GetSerializeSize(block, PROTOCOL_VERSION);
+    prefetched.block = std::move(pblock);
+
+    if (prefetched.generation % 2) {
+        // A write is in progress, the coins could not be used anyway.
+        return prefetched;
+    }
+
+    // Outputs created by the block itself are not in the view yet.
+    std::unordered_set<TxId, SaltedTxIdHasher> txids;
+    for (const auto &ptx : block.vtx) {
+        txids.insert(ptx->GetId());
+    }
+
+    for (const auto &ptx : block.vtx) {
+        if (ptx->IsCoinBase()) {
+            continue;
+        }
+        if (WITH_LOCK(m_mutex, return m_stop)) {
+            break;
+        }
+        for (const CTxIn &in : ptx->vin) {
+            if (txids.count(in.prevout.GetTxId())) {
+                continue;
+            }
+            Coin coin;
+            if (m_view.GetCoin(in.prevout, coin)) {
+                prefetched.coins.emplace_back(in.prevout, std::move(coin));
+            }
+        }
+    }
+
+    const int64_t time_coins = GetTimeMicros();
+
+    LogPrint(BCLog::BENCH,
+             "    - Prefetched block %s: read %.2fms, check %.2fms, %u coins "
+             "%.2fms\n",
+             block_hash.ToString(), (time_read - time_start) * 0.001,
+             (time_checked - time_read) * 0.001, prefetched.coins.size(),
+             (time_coins - time_checked) * 0.001);
+    return prefetched;
+}
+
+} // namespace node
@@ -0,0 +1,134 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_COINSPREFETCH_H
+#define BITCOIN_NODE_COINSPREFETCH_H
+
+#include <coins.h>
+#include <flatfile.h>
+#include <primitives/blockhash.h>
+#include <sync.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class CBlock;
+class CCoinsViewBackgroundFlush;
+
+namespace Consensus {
+struct Params;
+}
+
+namespace node {
+
+/** Number of threads looking up coins for upcoming blocks. */
+static constexpr int COINS_PREFETCH_THREADS = 2;
+/** Maximum number of blocks queued or holding prefetched coins. */
+static constexpr size_t MAX_PREFETCH_BLOCKS = 16;
+/**
+ * Maximum serialized size of the blocks read ahead and not taken yet. No new
+ * block is read past this limit until the blocks are connected.
+ */
+static constexpr size_t MAX_PREFETCH_BLOCK_BYTES = 64 * 1024 * 1024;
+
+/**
+ * Reads the blocks that are about to be connected from disk on background
+ * threads, runs the context free checks on them and looks up the coins they
+ * spend, so that connecting a block does not have to wait for the disk and
+ * the next blocks get ready while it is being validated.
+ *
+ * The coins are read from the view right below the coins tip cache. They stay
+ * valid as long as that view has not been written to since they were read:
+ * a coin that is missing from the tip cache has the same value in the view
+ * below until the tip is flushed again. Coins read before the latest flush are
+ * dropped rather than moved into the cache.
+ */
+class CoinsPrefetcher {
+public:
+    CoinsPrefetcher(CCoinsViewBackgroundFlush &view,
+                    const Consensus::Params &params);
+    ~CoinsPrefetcher();
+
+    /**
+     * Queue the blocks that are going to be connected next, in order. Blocks
+     * that are already queued or prefetched are skipped, and the ones that are
+     * not in the list anymore are dropped.
+     */
+    void Prefetch(const std::vector<std::pair<BlockHash, FlatFilePos>> &blocks,
+                  uint64_t excessive_block_size)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Take the block read ahead of time, waiting for it if it is being read.
+     * The block has passed CheckBlock() if it is marked as checked.
+     * @returns nullptr if the block was not read ahead, in which case the
+     * caller has to read it itself.
+     */
+    std::shared_ptr<const CBlock> TakeBlock(const BlockHash &block_hash)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Move the coins prefetched for a block into the cache right above the
+     * view, if they are still valid. Coins already in the cache are kept.
+     * @returns the number of coins added to the cache.
+     */
+    size_t TakeCoins(const BlockHash &block_hash, CCoinsViewCache &cache)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Drop all the queued and prefetched blocks and wait for the threads to
+     * stop reading from the view.
+     */
+    void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Wait until all the queued blocks have been read. */
+    void WaitForIdle() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct PrefetchedBlock {
+        //! View generation the coins were read at.
+        uint64_t generation;
+        std::shared_ptr<const CBlock> block;
+        //! Serialized size of the block, if it was not taken yet.
+        size_t block_size;
+        std::vector<std::pair<COutPoint, Coin>> coins;
+    };
+
+    void ThreadPrefetch() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    PrefetchedBlock ReadBlock(const BlockHash &block_hash,
+                              const FlatFilePos &pos,
+                              uint64_t excessive_block_size)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void EraseReady(std::map<BlockHash, PrefetchedBlock>::iterator it)
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    CCoinsViewBackgroundFlush &m_view;
+    const Consensus::Params &m_params;
+
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::pair<BlockHash, FlatFilePos>> m_queue GUARDED_BY(m_mutex);
+    //! Blocks queued or being read. The result of a read is dropped if the
+    //! block was removed from this set in the meantime.
+    std::set<BlockHash> m_pending GUARDED_BY(m_mutex);
+    std::map<BlockHash, PrefetchedBlock> m_ready GUARDED_BY(m_mutex);
+    //! Serialized size of the blocks in m_ready.
+    size_t m_ready_bytes GUARDED_BY(m_mutex){0};
+    uint64_t m_excessive_block_size GUARDED_BY(m_mutex){0};
+    //! Number of blocks being read by the threads.
+    int m_active GUARDED_BY(m_mutex){0};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_threads;
+};
+
+} // namespace node
+
+#endif // BITCOIN_NODE_COINSPREFETCH_H
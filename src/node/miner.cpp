@@ -22,14 +22,17 @@
 #include <pow/pow.h>
 #include <primitives/transaction.h>
 #include <timedata.h>
+#include <util/hasher.h>
 #include <util/moneystr.h>
 #include <util/system.h>
 #include <validation.h>
 #include <versionbits.h>
 
 #include <algorithm>
+#include <iterator>
 #include <queue>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 namespace node {
@@ -113,6 +116,29 @@ void BlockAssembler::resetBlock() {
     // These counters do not include coinbase tx.
     nBlockTx = 0;
     nFees = Amount::zero();
+
+    fHitBlockLimits = false;
+}
+
+void BlockAssembler::initBlock(const CBlockIndex *pindexPrev) {
+    CBlock *const pblock = &pblocktemplate->block;
+
+    nHeight = pindexPrev->nHeight + 1;
+
+    pblock->nVersion =
+        ComputeBlockVersion(pindexPrev, chainParams.GetConsensus());
+    // -regtest only: allow overriding block.nVersion with
+    // -blockversion=N to test forking scenarios
+    if (chainParams.MineBlocksOnDemand()) {
+        pblock->nVersion = gArgs.GetIntArg("-blockversion", pblock->nVersion);
+    }
+
+    pblock->nTime = GetAdjustedTime();
+    nMedianTimePast = pindexPrev->GetMedianTimePast();
+    nLockTimeCutoff =
+        (STANDARD_LOCKTIME_VERIFY_FLAGS & LOCKTIME_MEDIAN_TIME_PAST)
+            ? nMedianTimePast
+            : pblock->GetBlockTime();
 }
 
 std::optional<int64_t> BlockAssembler::m_last_block_num_txs{std::nullopt};
@@ -129,35 +155,211 @@ BlockAssembler::CreateNewBlock(const CScript &scriptPubKeyIn) {
         return nullptr;
     }
 
-    // Pointer for convenience.
-    CBlock *const pblock = &pblocktemplate->block;
-
     // Add dummy coinbase tx as first transaction.  It is updated at the end.
     pblocktemplate->entries.emplace_back(CTransactionRef(), -SATOSHI, -1);
 
     LOCK2(cs_main, m_mempool.cs);
     CBlockIndex *pindexPrev = m_chainstate.m_chain.Tip();
     assert(pindexPrev != nullptr);
-    nHeight = pindexPrev->nHeight + 1;
+    initBlock(pindexPrev);
 
-    const Consensus::Params &consensusParams = chainParams.GetConsensus();
+    addTxs();
 
-    pblock->nVersion = ComputeBlockVersion(pindexPrev, consensusParams);
-    // -regtest only: allow overriding block.nVersion with
-    // -blockversion=N to test forking scenarios
-    if (chainParams.MineBlocksOnDemand()) {
-        pblock->nVersion = gArgs.GetIntArg("-blockversion", pblock->nVersion);
-    }
+    int64_t nTime1 = GetTimeMicros();
 
-    pblock->nTime = GetAdjustedTime();
-    nMedianTimePast = pindexPrev->GetMedianTimePast();
-    nLockTimeCutoff =
-        (STANDARD_LOCKTIME_VERIFY_FLAGS & LOCKTIME_MEDIAN_TIME_PAST)
-            ? nMedianTimePast
-            : pblock->GetBlockTime();
+    finalizeBlock(pindexPrev, scriptPubKeyIn);
+
+    int64_t nTime2 = GetTimeMicros();
+
+    LogPrintf(
+        "CreateNewBlock(): total size: %u txs: %u fees: %ld sigChecks %d\n",
+        GetSerializeSize(pblocktemplate->block, PROTOCOL_VERSION), nBlockTx,
+        nFees, nBlockSigChecks);
+    LogPrint(
+        BCLog::BENCH,
+        "CreateNewBlock() addTxs: %.2fms, validity: %.2fms (total %.2fms)\n",
+        0.001 * (nTime1 - nTimeStart), 0.001 * (nTime2 - nTime1),
+        0.001 * (nTime2 - nTimeStart));
+
+    return std::move(pblocktemplate);
+}
+
+std::unique_ptr<CBlockTemplate> BlockAssembler::SelectTransactions() {
+    int64_t nTimeStart = GetTimeMicros();
+
+    resetBlock();
+
+    pblocktemplate.reset(new CBlockTemplate());
+    // Add dummy coinbase tx as first transaction, like in CreateNewBlock.
+    pblocktemplate->entries.emplace_back(CTransactionRef(), -SATOSHI, -1);
+
+    LOCK2(cs_main, m_mempool.cs);
+    CBlockIndex *pindexPrev = m_chainstate.m_chain.Tip();
+    assert(pindexPrev != nullptr);
+    initBlock(pindexPrev);
+    pblocktemplate->block.hashPrevBlock = pindexPrev->GetBlockHash();
 
     addTxs();
 
+    LogPrint(BCLog::BENCH, "SelectTransactions() %u txs: %.2fms\n", nBlockTx,
+             0.001 * (GetTimeMicros() - nTimeStart));
+
+    return std::move(pblocktemplate);
+}
+
+bool BlockAssembler::UpdateTransactions(
+    CBlockTemplate &selection, const std::vector<CTransactionRef> &added,
+    const std::set<TxId> &removed) {
+    int64_t nTimeStart = GetTimeMicros();
+
+    resetBlock();
+
+    LOCK(cs_main);
+    CBlockIndex *pindexPrev = m_chainstate.m_chain.Tip();
+    assert(pindexPrev != nullptr);
+    if (selection.block.hashPrevBlock != pindexPrev->GetBlockHash()) {
+        return false;
+    }
+
+    if (!removed.empty()) {
+        // The descendants of a removed transaction are removed along with it,
+        // but their notifications may not have been received yet.
+        for (auto it = std::next(selection.entries.begin());
+             it != selection.entries.end(); ++it) {
+            if (removed.count(it->tx->GetId())) {
+                continue;
+            }
+            for (const CTxIn &in : it->tx->vin) {
+                if (removed.count(in.prevout.GetTxId())) {
+                    return false;
+                }
+            }
+        }
+
+        selection.entries.erase(
+            std::remove_if(std::next(selection.entries.begin()),
+                           selection.entries.end(),
+                           [&removed](const CBlockTemplateEntry &entry) {
+                               return removed.count(entry.tx->GetId()) > 0;
+                           }),
+            selection.entries.end());
+    }
+
+    // The transactions kept in the selection were already checked against
+    // this tip.
+    std::unordered_set<TxId, SaltedTxIdHasher> included;
+    included.reserve(selection.entries.size() + added.size());
+    for (auto it = std::next(selection.entries.begin());
+         it != selection.entries.end(); ++it) {
+        nBlockSize += it->tx->GetTotalSize();
+        ++nBlockTx;
+        nBlockSigChecks += it->sigChecks;
+        nFees += it->fees;
+        included.insert(it->tx->GetId());
+    }
+
+    // Select the added transactions straight into the selection.
+    pblocktemplate.reset(new CBlockTemplate());
+    pblocktemplate->entries.swap(selection.entries);
+    initBlock(pindexPrev);
+
+    bool fAllAdded = true;
+    size_t nAdded = 0;
+    {
+        LOCK(m_mempool.cs);
+        for (const CTransactionRef &tx : added) {
+            if (included.count(tx->GetId())) {
+                continue;
+            }
+
+            auto mi = m_mempool.GetIter(tx->GetId());
+            if (!mi) {
+                // It has been removed since.
+                continue;
+            }
+            const CTxMemPoolEntry &entry = **mi;
+
+            if (entry.GetModifiedFeeRate() < blockMinFeeRate) {
+                continue;
+            }
+
+            bool hasMissingParents = false;
+            for (const CTxMemPoolEntry &parent :
+                 entry.GetMemPoolParentsConst()) {
+                if (!included.count(parent.GetTx().GetId())) {
+                    hasMissingParents = true;
+                    break;
+                }
+            }
+            if (hasMissingParents) {
+                continue;
+            }
+
+            if (!TestTxFits(entry.GetTxSize(), entry.GetSigChecks())) {
+                fAllAdded = false;
+                break;
+            }
+
+            if (!CheckTx(entry.GetTx())) {
+                continue;
+            }
+
+            AddToBlock(entry);
+            included.insert(tx->GetId());
+            ++nAdded;
+        }
+    }
+
+    selection.entries.swap(pblocktemplate->entries);
+    pblocktemplate.reset();
+
+    LogPrint(BCLog::BENCH,
+             "UpdateTransactions() %u txs added, %u removed: %.2fms\n",
+             nAdded, removed.size(), 0.001 * (GetTimeMicros() - nTimeStart));
+
+    return fAllAdded;
+}
+
+std::unique_ptr<CBlockTemplate>
+BlockAssembler::CreateNewBlock(const CBlockTemplate &selection,
+                               const CScript &scriptPubKeyIn) {
+    int64_t nTimeStart = GetTimeMicros();
+
+    resetBlock();
+
+    LOCK(cs_main);
+    CBlockIndex *pindexPrev = m_chainstate.m_chain.Tip();
+    assert(pindexPrev != nullptr);
+    if (selection.block.hashPrevBlock != pindexPrev->GetBlockHash()) {
+        return nullptr;
+    }
+
+    pblocktemplate.reset(new CBlockTemplate());
+    pblocktemplate->entries = selection.entries;
+    for (auto it = std::next(pblocktemplate->entries.begin());
+         it != pblocktemplate->entries.end(); ++it) {
+        nBlockSize += it->tx->GetTotalSize();
+        ++nBlockTx;
+        nBlockSigChecks += it->sigChecks;
+        nFees += it->fees;
+    }
+    initBlock(pindexPrev);
+
+    finalizeBlock(pindexPrev, scriptPubKeyIn);
+
+    LogPrint(BCLog::BENCH, "CreateNewBlock() %u txs, validity: %.2fms\n",
+             nBlockTx, 0.001 * (GetTimeMicros() - nTimeStart));
+
+    return std::move(pblocktemplate);
+}
+
+void BlockAssembler::finalizeBlock(CBlockIndex *pindexPrev,
+                                   const CScript &scriptPubKeyIn) {
+    // Pointer for convenience.
+    CBlock *const pblock = &pblocktemplate->block;
+
+    const Consensus::Params &consensusParams = chainParams.GetConsensus();
+
     if (IsMagneticAnomalyEnabled(consensusParams, pindexPrev)) {
         // If magnetic anomaly is enabled, we make sure transaction are
         // canonically ordered.
@@ -173,8 +375,6 @@ BlockAssembler::CreateNewBlock(const CScript &scriptPubKeyIn) {
         pblock->vtx.push_back(entry.tx);
     }
 
-    int64_t nTime1 = GetTimeMicros();
-
     m_last_block_num_txs = nBlockTx;
     m_last_block_size = nBlockSize;
 
@@ -207,12 +407,6 @@ BlockAssembler::CreateNewBlock(const CScript &scriptPubKeyIn) {
     pblocktemplate->entries[0].fees = -1 * nFees;
     pblock->vtx[0] = pblocktemplate->entries[0].tx;
 
-    uint64_t nSerializeSize = GetSerializeSize(*pblock, PROTOCOL_VERSION);
-
-    LogPrintf(
-        "CreateNewBlock(): total size: %u txs: %u fees: %ld sigChecks %d\n",
-        nSerializeSize, nBlockTx, nFees, nBlockSigChecks);
-
     // Fill in header.
     pblock->hashPrevBlock = pindexPrev->GetBlockHash();
     UpdateTime(pblock, chainParams, pindexPrev);
@@ -229,15 +423,6 @@ BlockAssembler::CreateNewBlock(const CScript &scriptPubKeyIn) {
         throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s",
                                            __func__, state.ToString()));
     }
-    int64_t nTime2 = GetTimeMicros();
-
-    LogPrint(
-        BCLog::BENCH,
-        "CreateNewBlock() addTxs: %.2fms, validity: %.2fms (total %.2fms)\n",
-        0.001 * (nTime1 - nTimeStart), 0.001 * (nTime2 - nTime1),
-        0.001 * (nTime2 - nTimeStart));
-
-    return std::move(pblocktemplate);
 }
 
 bool BlockAssembler::TestTxFits(uint64_t txSize, int64_t txSigChecks) const {
@@ -351,6 +536,7 @@ void BlockAssembler::addTxs() {
 
         // Check whether the tx will exceed the block limits.
         if (!TestTxFits(entry.GetTxSize(), entry.GetSigChecks())) {
+            fHitBlockLimits = true;
             ++nConsecutiveFailed;
             if (nConsecutiveFailed > MAX_CONSECUTIVE_FAILURES &&
                 nBlockSize > nMaxGeneratedBlockSize - 1000) {
@@ -400,6 +586,115 @@ void BlockAssembler::addTxs() {
     }
 }
 
+/**
+ * Maximum number of mempool changes recorded between two calls to
+ * BlockTemplateBuilder::GetBlockTemplate. Past this, a new template is built
+ * instead.
+ */
+static constexpr size_t MAX_TEMPLATE_PENDING_CHANGES{100000};
+
+BlockTemplateBuilder::BlockTemplateBuilder(const Config &config,
+                                           const CTxMemPool &mempool)
+    : m_config(config), m_mempool(mempool) {}
+
+std::shared_ptr<const CBlockTemplate>
+BlockTemplateBuilder::GetBlockTemplate(Chainstate &chainstate,
+                                       const CScript &scriptPubKeyIn) {
+    LOCK(cs_main);
+
+    std::vector<CTransactionRef> added;
+    std::set<TxId> removed;
+    bool invalidated;
+    {
+        LOCK(m_mutex);
+        added.swap(m_added);
+        removed.swap(m_removed);
+        invalidated = std::exchange(m_invalidated, false);
+        m_active = true;
+    }
+
+    const CBlockIndex *pindexPrev = chainstate.m_chain.Tip();
+    assert(pindexPrev != nullptr);
+    const auto now = GetTime<std::chrono::seconds>();
+    BlockAssembler assembler(m_config, chainstate, m_mempool);
+
+    if (m_selection && !invalidated &&
+        m_selection->block.hashPrevBlock == pindexPrev->GetBlockHash()) {
+        if (!m_stale && (!added.empty() || !removed.empty())) {
+            // A transaction left out because of the block limits could make
+            // it in once another one is removed, or be better than an added
+            // one.
+            m_stale = true;
+            if (!m_hit_block_limits) {
+                m_stale = !assembler.UpdateTransactions(*m_selection, added,
+                                                        removed);
+                m_template.reset();
+            }
+        }
+        if (!m_stale || now < m_last_rebuild + MIN_TEMPLATE_REBUILD_INTERVAL) {
+            if (!m_template || scriptPubKeyIn != m_script) {
+                m_template = FinalizeSelection(assembler, scriptPubKeyIn);
+            }
+            return m_template;
+        }
+    }
+
+    m_template.reset();
+    m_selection = assembler.SelectTransactions();
+    m_stale = false;
+    m_hit_block_limits = assembler.HitBlockLimits();
+    m_last_rebuild = now;
+    m_template = FinalizeSelection(assembler, scriptPubKeyIn);
+    return m_template;
+}
+
+std::shared_ptr<const CBlockTemplate>
+BlockTemplateBuilder::FinalizeSelection(BlockAssembler &assembler,
+                                        const CScript &scriptPubKeyIn) {
+    // Don't keep the selection around if it does not make a valid block.
+    std::unique_ptr<CBlockTemplate> selection = std::move(m_selection);
+    std::shared_ptr<const CBlockTemplate> pblocktemplate =
+        assembler.CreateNewBlock(*selection, scriptPubKeyIn);
+    m_selection = std::move(selection);
+    m_script = scriptPubKeyIn;
+    return pblocktemplate;
+}
+
+void BlockTemplateBuilder::Invalidate() {
+    LOCK(m_mutex);
+    m_invalidated = true;
+}
+
+bool BlockTemplateBuilder::ShouldRecordChange() {
+    if (!m_active || m_invalidated) {
+        return false;
+    }
+    if (m_added.size() + m_removed.size() >= MAX_TEMPLATE_PENDING_CHANGES) {
+        m_added.clear();
+        m_removed.clear();
+        m_invalidated = true;
+        return false;
+    }
+    return true;
+}
+
+void BlockTemplateBuilder::TransactionAddedToMempool(
+    const CTransactionRef &tx, uint64_t mempool_sequence) {
+    LOCK(m_mutex);
+    if (ShouldRecordChange()) {
+        m_added.push_back(tx);
+    }
+}
+
+void BlockTemplateBuilder::TransactionRemovedFromMempool(
+    const CTransactionRef &tx, MemPoolRemovalReason reason,
+    uint64_t mempool_sequence) {
+    LOCK(m_mutex);
+    if (ShouldRecordChange()) {
+        m_removed.insert(tx->GetId());
+    }
+}
+
 static const std::vector<uint8_t>
 getExcessiveBlockSizeSig(uint64_t nExcessiveBlockSize) {
     std::string cbmsg = "/EB" + getSubVersionEB(nExcessiveBlockSize) + "/";
@@ -8,19 +8,24 @@
 
 #include <consensus/amount.h>
 #include <primitives/block.h>
+#include <script/script.h>
+#include <sync.h>
 #include <txmempool.h>
+#include <validationinterface.h>
 
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <set>
+#include <vector>
 
 class CBlockIndex;
 class CChainParams;
 class Config;
-class CScript;
 
 namespace Consensus {
 struct Params;
@@ -28,6 +33,12 @@ struct Params;
 
 namespace node {
 static const bool DEFAULT_PRINTPRIORITY = false;
+/**
+ * Minimum time between two templates built from the whole mempool on the same
+ * tip by the BlockTemplateBuilder, when the previous template cannot be
+ * updated incrementally.
+ */
+static constexpr std::chrono::seconds MIN_TEMPLATE_REBUILD_INTERVAL{5};
 
 struct CBlockTemplateEntry {
     CTransactionRef tx;
@@ -60,6 +71,8 @@ private:
     uint64_t nBlockTx;
     uint64_t nBlockSigChecks;
     Amount nFees;
+    // Whether some transactions did not fit in the block
+    bool fHitBlockLimits;
 
     // Chain context for the block
     int nHeight;
@@ -89,6 +102,43 @@ public:
     std::unique_ptr<CBlockTemplate>
     CreateNewBlock(const CScript &scriptPubKeyIn);
 
+    /**
+     * Select the transactions of a block on the current tip like
+     * CreateNewBlock, without creating the coinbase nor checking the block.
+     * Only the entries after the dummy coinbase one and the previous block
+     * hash of the result are set.
+     */
+    std::unique_ptr<CBlockTemplate> SelectTransactions();
+
+    /**
+     * Update in place the transactions selected on the current tip: remove
+     * the removed transactions and select the added ones that are still in
+     * the mempool, with the same rules as in CreateNewBlock. The result
+     * matches a new selection as long as all the candidates fit in the block.
+     * The selection is left valid when this fails, but misses some changes.
+     * @returns false if the tip changed, the descendants of a removed
+     * transaction are still selected or an added transaction does not fit in
+     * the block, in which case the transactions have to be selected again.
+     */
+    bool UpdateTransactions(CBlockTemplate &selection,
+                            const std::vector<CTransactionRef> &added,
+                            const std::set<TxId> &removed);
+
+    /**
+     * Construct a new block template with coinbase to scriptPubKeyIn from the
+     * transactions selected by SelectTransactions.
+     * @returns nullptr if the tip changed since the selection.
+     */
+    std::unique_ptr<CBlockTemplate>
+    CreateNewBlock(const CBlockTemplate &selection,
+                   const CScript &scriptPubKeyIn);
+
+    /**
+     * Whether some transactions were left out of the last template because
+     * they did not fit in the block.
+     */
+    bool HitBlockLimits() const { return fHitBlockLimits; }
+
     uint64_t GetMaxGeneratedBlockSize() const { return nMaxGeneratedBlockSize; }
 
     static std::optional<int64_t> m_last_block_num_txs;
@@ -98,6 +148,15 @@ private:
     // utility functions
     /** Clear the block's state and prepare for assembling a new block */
     void resetBlock();
+    /** Set the chain context and header fields for a block on pindexPrev */
+    void initBlock(const CBlockIndex *pindexPrev)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /**
+     * Order the transactions, create the coinbase and fill in the header of
+     * the block, then check it is valid.
+     */
+    void finalizeBlock(CBlockIndex *pindexPrev, const CScript &scriptPubKeyIn)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     /** Add a tx to the block */
     void AddToBlock(const CTxMemPoolEntry &entry);
 
@@ -115,6 +174,80 @@ private:
     bool CheckTx(const CTransaction &tx) const;
 };
 
+/**
+ * Keeps a block template up to date with the mempool, so that it can be polled
+ * often without selecting the transactions from the whole mempool each time.
+ *
+ * The transactions added to and removed from the mempool since the last call
+ * are applied to the selected transactions while all the candidates fit in
+ * the block. Otherwise, and when the tip changes, the transactions are
+ * selected again, at most once every MIN_TEMPLATE_REBUILD_INTERVAL on the same
+ * tip. The block is only finalized and checked when the selection changed
+ * since the previous call, and the template is shared with the callers.
+ */
+class BlockTemplateBuilder final : public CValidationInterface {
+public:
+    BlockTemplateBuilder(const Config &config, const CTxMemPool &mempool);
+
+    /**
+     * Get a template for a block on the tip of the chainstate, with the
+     * coinbase paying to scriptPubKeyIn.
+     */
+    std::shared_ptr<const CBlockTemplate>
+    GetBlockTemplate(Chainstate &chainstate, const CScript &scriptPubKeyIn)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Build a new template on the next call, e.g. because the fee delta of a
+     * transaction changed.
+     */
+    void Invalidate() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+protected:
+    void TransactionAddedToMempool(const CTransactionRef &tx,
+                                   uint64_t mempool_sequence) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void TransactionRemovedFromMempool(const CTransactionRef &tx,
+                                       MemPoolRemovalReason reason,
+                                       uint64_t mempool_sequence) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    /**
+     * Whether a mempool change should be recorded. Changes are not recorded
+     * when a new template is going to be built anyway.
+     */
+    bool ShouldRecordChange() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    /**
+     * Create the template for the selected transactions, with the coinbase
+     * paying to scriptPubKeyIn.
+     */
+    std::shared_ptr<const CBlockTemplate>
+    FinalizeSelection(BlockAssembler &assembler, const CScript &scriptPubKeyIn)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    const Config &m_config;
+    const CTxMemPool &m_mempool;
+
+    //! The selected transactions, see BlockAssembler::SelectTransactions.
+    std::unique_ptr<CBlockTemplate> m_selection GUARDED_BY(cs_main);
+    //! The template last handed out, unless the selection changed since.
+    std::shared_ptr<const CBlockTemplate> m_template GUARDED_BY(cs_main);
+    CScript m_script GUARDED_BY(cs_main);
+    //! Whether the selection misses some mempool changes.
+    bool m_stale GUARDED_BY(cs_main){false};
+    //! Whether the block limits were reached when selecting the transactions.
+    bool m_hit_block_limits GUARDED_BY(cs_main){false};
+    std::chrono::seconds m_last_rebuild GUARDED_BY(cs_main){0};
+
+    Mutex m_mutex;
+    //! Mempool changes since the last call, recorded once a template exists.
+    std::vector<CTransactionRef> m_added GUARDED_BY(m_mutex);
+    std::set<TxId> m_removed GUARDED_BY(m_mutex);
+    bool m_active GUARDED_BY(m_mutex){false};
+    bool m_invalidated GUARDED_BY(m_mutex){false};
+};
+
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock *pblock, const CBlockIndex *pindexPrev,
                          uint64_t nExcessiveBlockSize,
@@ -0,0 +1,377 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_OPENHASHMAP_H
+#define BITCOIN_OPENHASHMAP_H
+
+#include <support/allocators/pool.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Hash map using open addressing with linear probing, intended as a drop-in
+ * replacement for the subset of std::unordered_map used by the coins cache.
+ *
+ * The table itself is a flat array of one control byte per slot (empty,
+ * deleted, or a 7 bit fingerprint of the hash) and a parallel array of
+ * pointers to the entries. Lookups only touch the control bytes until a
+ * fingerprint matches, so a miss rarely dereferences an entry at all.
+ *
+ * Entries are carved out of a PoolResource owned by the map, rather than being
+ * allocated one by one on the heap. Entries
+ * never move once inserted: references and pointers to them stay valid until
+ * the entry is erased, like for std::unordered_map. Iterators are invalidated
+ * by any insertion that causes the table to grow, but not by erasure, so the
+ * `map.erase(it++)` idiom keeps working.
+ *
+ * clear() releases all the memory owned by the map, including the entry pool.
+ */
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class OpenHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+
+private:
+    static constexpr uint8_t CTRL_EMPTY = 0x80;
+    static constexpr uint8_t CTRL_DELETED = 0xfe;
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    static bool IsFull(uint8_t ctrl) { return (ctrl & 0x80) == 0; }
+
+    /** Open addressing table. */
+    std::unique_ptr<uint8_t[]> m_ctrl;
+    std::unique_ptr<value_type *[]> m_slots;
+    size_t m_capacity{0};
+    size_t m_size{0};
+    size_t m_deleted{0};
+
+    /** Storage for the entries. */
+    PoolResource<sizeof(value_type), alignof(value_type)> m_pool;
+
+    Hash m_hash;
+    KeyEqual m_equal;
+
+    template <bool IsConst> class Iter {
+        friend class OpenHashMap;
+        friend class Iter<!IsConst>;
+        using map_pointer =
+            std::conditional_t<IsConst, const OpenHashMap *, OpenHashMap *>;
+
+        map_pointer m_map{nullptr};
+        size_t m_pos{0};
+
+        Iter(map_pointer map, size_t pos) : m_map(map), m_pos(pos) {}
+
+        void SkipEmpty() {
+            while (m_pos < m_map->m_capacity && !IsFull(m_map->m_ctrl[m_pos])) {
+                ++m_pos;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = OpenHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer =
+            std::conditional_t<IsConst, const value_type *, value_type *>;
+        using reference =
+            std::conditional_t<IsConst, const value_type &, value_type &>;
+
+        Iter() = default;
+        template <bool C = IsConst, typename = std::enable_if_t<C>>
+        Iter(const Iter<false> &other) : m_map(other.m_map), m_pos(other.m_pos) {}
+
+        reference operator*() const { return *m_map->m_slots[m_pos]; }
+        pointer operator->() const { return m_map->m_slots[m_pos]; }
+
+        Iter &operator++() {
+            ++m_pos;
+            SkipEmpty();
+            return *this;
+        }
+        Iter operator++(int) {
+            Iter copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        template <bool C> bool operator==(const Iter<C> &other) const {
+            return m_pos == other.m_pos;
+        }
+        template <bool C> bool operator!=(const Iter<C> &other) const {
+            return m_pos != other.m_pos;
+        }
+    };
+
+public:
+    using iterator = Iter<false>;
+    using const_iterator = Iter<true>;
+
+    explicit OpenHashMap(const Hash &hash = Hash(),
+                         const KeyEqual &equal = KeyEqual())
+        : m_hash(hash), m_equal(equal) {}
+    ~OpenHashMap() { clear(); }
+
+    OpenHashMap(const OpenHashMap &) = delete;
+    OpenHashMap &operator=(const OpenHashMap &) = delete;
+
+    /** Take the entries of other, which is left empty. */
+    OpenHashMap(OpenHashMap &&other) noexcept
+        : m_ctrl(std::move(other.m_ctrl)), m_slots(std::move(other.m_slots)),
+          m_capacity(std::exchange(other.m_capacity, 0)),
+          m_size(std::exchange(other.m_size, 0)),
+          m_deleted(std::exchange(other.m_deleted, 0)),
+          m_pool(std::move(other.m_pool)), m_hash(other.m_hash),
+          m_equal(other.m_equal) {}
+    OpenHashMap &operator=(OpenHashMap &&other) = delete;
+
+    iterator begin() {
+        iterator it(this, 0);
+        it.SkipEmpty();
+        return it;
+    }
+    const_iterator begin() const {
+        const_iterator it(this, 0);
+        it.SkipEmpty();
+        return it;
+    }
+    iterator end() { return iterator(this, m_capacity); }
+    const_iterator end() const { return const_iterator(this, m_capacity); }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    /** Number of slots in the table. */
+    size_t capacity() const { return m_capacity; }
+
+    iterator find(const Key &key) {
+        return iterator(this, FindPos(key, m_hash(key)));
+    }
+    const_iterator find(const Key &key) const {
+        return const_iterator(this, FindPos(key, m_hash(key)));
+    }
+    size_t count(const Key &key) const { return find(key) != end(); }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args &&...args) {
+        void *storage = m_pool.Allocate();
+        value_type *value;
+        try {
+            value = ::new (storage) value_type(std::forward<Args>(args)...);
+        } catch (...) {
+            m_pool.Deallocate(storage);
+            throw;
+        }
+        const size_t hash = m_hash(value->first);
+        const size_t pos = FindPos(value->first, hash);
+        if (pos != m_capacity) {
+            DestroyNode(value);
+            return {iterator(this, pos), false};
+        }
+        return {iterator(this, InsertNew(value, hash)), true};
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key &key, Args &&...args) {
+        const size_t hash = m_hash(key);
+        const size_t pos = FindPos(key, hash);
+        if (pos != m_capacity) {
+            return {iterator(this, pos), false};
+        }
+        void *storage = m_pool.Allocate();
+        value_type *value;
+        try {
+            value = ::new (storage)
+                value_type(std::piecewise_construct, std::forward_as_tuple(key),
+                           std::forward_as_tuple(std::forward<Args>(args)...));
+        } catch (...) {
+            m_pool.Deallocate(storage);
+            throw;
+        }
+        return {iterator(this, InsertNew(value, hash)), true};
+    }
+
+    T &operator[](const Key &key) { return try_emplace(key).first->second; }
+
+    /** Erase the entry at it, and return an iterator to the next entry. */
+    iterator erase(const_iterator it) {
+        const size_t pos = it.m_pos;
+        assert(pos < m_capacity && IsFull(m_ctrl[pos]));
+        DestroyNode(m_slots[pos]);
+        m_slots[pos] = nullptr;
+        // A slot followed by an empty one never interrupts a probe sequence,
+        // so it can be marked empty instead of leaving a tombstone.
+        if (m_ctrl[(pos + 1) & (m_capacity - 1)] == CTRL_EMPTY) {
+            m_ctrl[pos] = CTRL_EMPTY;
+        } else {
+            m_ctrl[pos] = CTRL_DELETED;
+            ++m_deleted;
+        }
+        --m_size;
+        iterator next(this, pos + 1);
+        next.SkipEmpty();
+        return next;
+    }
+    iterator erase(iterator it) { return erase(const_iterator(it)); }
+    size_t erase(const Key &key) {
+        const_iterator it = find(key);
+        if (it == end()) {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    /** Destroy all entries and release all the memory owned by the map. */
+    void clear() {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (IsFull(m_ctrl[i])) {
+                m_slots[i]->~value_type();
+            }
+        }
+        m_ctrl.reset();
+        m_slots.reset();
+        m_capacity = 0;
+        m_size = 0;
+        m_deleted = 0;
+        m_pool.Release();
+    }
+
+    /** Make room for at least n entries without growing the table. */
+    void reserve(size_t n) {
+        size_t capacity = std::max(m_capacity, MIN_CAPACITY);
+        while (!FitsLoad(n, capacity)) {
+            capacity *= 2;
+        }
+        if (capacity != m_capacity) {
+            Rehash(capacity);
+        }
+    }
+
+    /** Heap memory owned by the map, excluding the entries' own. */
+    template <typename Usage> size_t DynamicUsage(Usage malloc_usage) const {
+        size_t usage = 0;
+        if (m_capacity > 0) {
+            usage += malloc_usage(m_capacity * sizeof(uint8_t)) +
+                     malloc_usage(m_capacity * sizeof(value_type *));
+        }
+        return usage + m_pool.DynamicUsage(malloc_usage);
+    }
+
+private:
+    /** Keep the table at most 7/8 full, counting tombstones. */
+    static bool FitsLoad(size_t used, size_t capacity) {
+        return used * 8 <= capacity * 7;
+    }
+
+    static uint8_t Fingerprint(size_t hash) { return hash & 0x7f; }
+    size_t StartPos(size_t hash) const {
+        return (hash >> 7) & (m_capacity - 1);
+    }
+
+    /** Return the slot holding key, or m_capacity if it is not present. */
+    size_t FindPos(const Key &key, size_t hash) const {
+        if (m_size == 0) {
+            return m_capacity;
+        }
+        const uint8_t fp = Fingerprint(hash);
+        const size_t mask = m_capacity - 1;
+        for (size_t pos = StartPos(hash);; pos = (pos + 1) & mask) {
+            const uint8_t ctrl = m_ctrl[pos];
+            if (ctrl == CTRL_EMPTY) {
+                return m_capacity;
+            }
+            if (ctrl == fp && m_equal(m_slots[pos]->first, key)) {
+                return pos;
+            }
+        }
+    }
+
+    /** Insert an entry whose key is known not to be present. */
+    size_t InsertNew(value_type *value, size_t hash) {
+        if (!FitsLoad(m_size + m_deleted + 1, m_capacity)) {
+            try {
+                Grow();
+            } catch (...) {
+                DestroyNode(value);
+                throw;
+            }
+        }
+        const size_t pos = FindFreePos(hash);
+        if (m_ctrl[pos] == CTRL_DELETED) {
+            --m_deleted;
+        }
+        m_ctrl[pos] = Fingerprint(hash);
+        m_slots[pos] = value;
+        ++m_size;
+        return pos;
+    }
+
+    size_t FindFreePos(size_t hash) const {
+        const size_t mask = m_capacity - 1;
+        size_t pos = StartPos(hash);
+        while (IsFull(m_ctrl[pos])) {
+            pos = (pos + 1) & mask;
+        }
+        return pos;
+    }
+
+    void Grow() {
+        if (m_capacity == 0) {
+            Rehash(MIN_CAPACITY);
+        } else if (FitsLoad(2 * (m_size + 1), m_capacity)) {
+            // Mostly tombstones: clean them up without growing.
+            Rehash(m_capacity);
+        } else {
+            Rehash(2 * m_capacity);
+        }
+    }
+
+    void Rehash(size_t new_capacity) {
+        assert((new_capacity & (new_capacity - 1)) == 0);
+        auto new_ctrl = std::make_unique<uint8_t[]>(new_capacity);
+        auto new_slots = std::make_unique<value_type *[]>(new_capacity);
+        std::fill_n(new_ctrl.get(), new_capacity, CTRL_EMPTY);
+
+        std::swap(m_ctrl, new_ctrl);
+        std::swap(m_slots, new_slots);
+        const size_t old_capacity = m_capacity;
+        m_capacity = new_capacity;
+        m_deleted = 0;
+
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (!IsFull(new_ctrl[i])) {
+                continue;
+            }
+            value_type *value = new_slots[i];
+            const size_t hash = m_hash(value->first);
+            const size_t pos = FindFreePos(hash);
+            m_ctrl[pos] = Fingerprint(hash);
+            m_slots[pos] = value;
+        }
+    }
+
+    void DestroyNode(value_type *value) {
+        value->~value_type();
+        m_pool.Deallocate(value);
+    }
+};
+
+#endif // BITCOIN_OPENHASHMAP_H
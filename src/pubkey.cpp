@@ -9,6 +9,8 @@
 #include <secp256k1_recovery.h>
 #include <secp256k1_schnorr.h>
 
+#include <cstring>
+
 namespace {
 /* Global secp256k1_context object used for verification. */
 secp256k1_context *secp256k1_context_verify = nullptr;
@@ -224,6 +226,84 @@ bool CPubKey::VerifySchnorr(const uint256 &hash,
     return VerifySchnorr(hash, sig);
 }
 
+/**
+ * Size of the scratch space used by the multiexponentiation. Larger batches
+ * are split by libsecp256k1 so that each part fits into it.
+ */
+static constexpr size_t SCHNORR_BATCH_SCRATCH_SIZE = 1 << 20;
+
+namespace {
+/**
+ * Scratch space of the multiexponentiation, allocated once per thread and
+ * reused by all the batches verified on that thread. The space is not tied to
+ * a context, so it is managed through secp256k1_context_no_precomp and can
+ * outlive secp256k1_context_verify.
+ */
+class SchnorrBatchScratch {
+private:
+    secp256k1_scratch_space *scratch;
+
+public:
+    SchnorrBatchScratch()
+        : scratch(secp256k1_scratch_space_create(
+              secp256k1_context_no_precomp, SCHNORR_BATCH_SCRATCH_SIZE)) {}
+    ~SchnorrBatchScratch() {
+        if (scratch) {
+            secp256k1_scratch_space_destroy(secp256k1_context_no_precomp,
+                                            scratch);
+        }
+    }
+
+    SchnorrBatchScratch(const SchnorrBatchScratch &) = delete;
+    SchnorrBatchScratch &operator=(const SchnorrBatchScratch &) = delete;
+
+    secp256k1_scratch_space *get() const { return scratch; }
+};
+} // namespace
+
+bool SchnorrBatchVerifier::Add(const CPubKey &pubkey, const uint256 &hash,
+                               const std::vector<uint8_t> &vchSig) {
+    if (vchSig.size() != CPubKey::SCHNORR_SIZE || !pubkey.IsValid()) {
+        return false;
+    }
+
+    secp256k1_pubkey parsed;
+    static_assert(sizeof(parsed) == sizeof(Entry::pubkey),
+                  "Unexpected secp256k1_pubkey size");
+    if (!secp256k1_ec_pubkey_parse(secp256k1_context_verify, &parsed,
+                                   pubkey.data(), pubkey.size())) {
+        return false;
+    }
+
+    Entry &entry = entries.emplace_back();
+    std::memcpy(entry.pubkey.data(), &parsed, sizeof(parsed));
+    entry.hash = hash;
+    std::copy(vchSig.begin(), vchSig.end(), entry.sig.begin());
+    return true;
+}
+
+bool SchnorrBatchVerifier::Verify() const {
+    if (entries.empty()) {
+        return true;
+    }
+
+    std::vector<secp256k1_pubkey> pubkeys(entries.size());
+    std::vector<const secp256k1_pubkey *> pubkeyptrs(entries.size());
+    std::vector<const uint8_t *> sigptrs(entries.size());
+    std::vector<const uint8_t *> hashptrs(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        std::memcpy(&pubkeys[i], entries[i].pubkey.data(), sizeof(pubkeys[i]));
+        pubkeyptrs[i] = &pubkeys[i];
+        sigptrs[i] = entries[i].sig.data();
+        hashptrs[i] = entries[i].hash.begin();
+    }
+
+    static thread_local SchnorrBatchScratch scratch;
+    return secp256k1_schnorr_verify_batch(
+        secp256k1_context_verify, scratch.get(), sigptrs.data(),
+        hashptrs.data(), pubkeyptrs.data(), entries.size());
+}
+
 bool CPubKey::RecoverCompact(const uint256 &hash,
                              const std::vector<uint8_t> &vchSig) {
     if (vchSig.size() != COMPACT_SIGNATURE_SIZE) {
@@ -13,6 +13,7 @@
 
 #include <boost/range/adaptor/sliced.hpp>
 
+#include <array>
 #include <stdexcept>
 #include <vector>
 
@@ -195,6 +196,43 @@ public:
                 const ChainCode &cc) const;
 };
 
+/**
+ * Collects Schnorr signatures so that they can be verified all at once, which
+ * is significantly faster than verifying them one by one.
+ */
+class SchnorrBatchVerifier {
+private:
+    struct Entry {
+        //! Parsed secp256k1_pubkey, kept opaque to avoid leaking libsecp256k1
+        //! types in this header.
+        std::array<uint8_t, 64> pubkey;
+        uint256 hash;
+        std::array<uint8_t, CPubKey::SCHNORR_SIZE> sig;
+    };
+
+    std::vector<Entry> entries;
+
+public:
+    /**
+     * Queue a Schnorr signature (=64 bytes) for verification.
+     * Returns false if the signature can be found invalid without verifying
+     * it, i.e. if it is not 64 bytes long or the public key is not fully
+     * valid. The signature is not queued in this case.
+     */
+    bool Add(const CPubKey &pubkey, const uint256 &hash,
+             const std::vector<uint8_t> &vchSig);
+
+    /**
+     * Verify all the queued signatures. Returns true iff all of them are
+     * valid, but does not tell which one is invalid otherwise.
+     */
+    bool Verify() const;
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    void clear() { entries.clear(); }
+};
+
 struct CExtPubKey {
     uint8_t nDepth;
     uint8_t vchFingerprint[4];
@@ -32,10 +32,15 @@
 
 using node::GetTransaction;
 using node::NodeContext;
+using node::OpenBlockFile;
+using node::OpenUndoFile;
 using node::ReadBlockFromDisk;
+using node::STORAGE_HEADER_BYTES;
 
 // Allow a max of 15 outpoints to be queried at once.
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15;
+// Allow a max of 1000 blocks to be streamed at once.
+static const size_t MAX_REST_BLOCKS = 1000;
 
 enum class RetFormat {
     UNDEF,
@@ -344,9 +349,13 @@ static bool rest_block(const Config &config, const std::any &context,
         case RetFormat::JSON: {
             UniValue objBlock = blockToJSON(chainman.m_blockman, block, tip,
                                             pblockindex, showTxDetails);
-            std::string strJSON = objBlock.write() + "\n";
             req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
+            objBlock.write(
+                [req](const std::string &chunk) {
+                    req->WriteReplyChunk(chunk);
+                },
+                JSONRPC_REPLY_CHUNK_SIZE);
+            req->WriteReply(HTTP_OK, "\n");
             return true;
         }
 
@@ -370,6 +379,188 @@ static bool rest_block_notxdetails(Config &config, const std::any &context,
     return rest_block(config, context, req, strURIPart, false);
 }
 
+/**
+ * Block or undo file the data of a /rest/blocks/ reply is taken from. The
+ * headers in front of the data are checked before it is sent as is.
+ */
+struct RestBlockFile {
+    //! Used to read the headers
+    CAutoFile headers;
+    //! Used to append the data to the reply
+    std::unique_ptr<HTTPReplyFile> data;
+
+    RestBlockFile(FILE *headersIn, FILE *dataIn)
+        : headers(headersIn, SER_DISK, CLIENT_VERSION),
+          data(HTTPReplyFile::Open(dataIn)) {}
+};
+
+struct RestBlockRecord {
+    //! nullptr for a record without data
+    const RestBlockFile *file;
+    uint64_t offset;
+    uint64_t length;
+};
+
+/**
+ * Locate the block or undo data stored at pos, including the header in front
+ * of it and, for the undo data, the checksum behind it.
+ */
+static bool
+FindBlockRecord(std::map<int, std::unique_ptr<RestBlockFile>> &files,
+                bool undo, const FlatFilePos &pos,
+                const CMessageHeader::MessageMagic &magic,
+                RestBlockRecord &record) {
+    std::unique_ptr<RestBlockFile> &file = files[pos.nFile];
+    if (!file) {
+        const FlatFilePos file_pos(pos.nFile, 0);
+        file = undo ? std::make_unique<RestBlockFile>(
+                          OpenUndoFile(file_pos, true),
+                          OpenUndoFile(file_pos, true))
+                    : std::make_unique<RestBlockFile>(
+                          OpenBlockFile(file_pos, true),
+                          OpenBlockFile(file_pos, true));
+    }
+    if (file->headers.IsNull() || !file->data ||
+        pos.nPos < STORAGE_HEADER_BYTES) {
+        return false;
+    }
+
+    const unsigned int offset = pos.nPos - STORAGE_HEADER_BYTES;
+    CMessageHeader::MessageMagic record_magic;
+    unsigned int size;
+    try {
+        if (fseek(file->headers.Get(), offset, SEEK_SET)) {
+            return false;
+        }
+        file->headers >> record_magic >> size;
+    } catch (const std::exception &) {
+        return false;
+    }
+    if (record_magic != magic) {
+        return false;
+    }
+
+    record = {file.get(), offset,
+              uint64_t(STORAGE_HEADER_BYTES) + size +
+                  (undo ? sizeof(uint256) : 0)};
+    return true;
+}
+
+/**
+ * Stream consecutive blocks of the active chain, optionally followed each by
+ * their undo data, as they are stored in the block and undo files: every block
+ * and undo data is preceded by the disk magic and its size, and the undo data
+ * is followed by its checksum. The undo data of the genesis block is empty,
+ * with a null checksum. The data is sent straight from the files.
+ */
+static bool rest_blocks(Config &config, const std::any &context,
+                        HTTPRequest *req, const std::string &strURIPart) {
+    if (!CheckWarmup(req)) {
+        return false;
+    }
+
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    const bool undo = path.size() == 3 && path[0] == "undo";
+    if (undo) {
+        path.erase(path.begin());
+    }
+    if (path.size() != 2) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       "No block count specified. Use "
+                       "/rest/blocks/[undo/]<hash>/<count>.bin.");
+    }
+    if (rf != RetFormat::BINARY) {
+        return RESTERR(req, HTTP_NOT_FOUND,
+                       "output format not found (available: .bin)");
+    }
+
+    uint256 rawHash;
+    if (!ParseHashStr(path[0], rawHash)) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + path[0]);
+    }
+    const BlockHash hash(rawHash);
+
+    const long count = strtol(path[1].c_str(), nullptr, 10);
+    if (count < 1 || size_t(count) > MAX_REST_BLOCKS) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       "Block count out of range: " + path[1]);
+    }
+
+    std::vector<std::pair<FlatFilePos, FlatFilePos>> positions;
+    {
+        ChainstateManager *maybe_chainman = GetChainman(context, req);
+        if (!maybe_chainman) {
+            return false;
+        }
+        ChainstateManager &chainman = *maybe_chainman;
+        LOCK(cs_main);
+        const CChain &active_chain = chainman.ActiveChain();
+        const CBlockIndex *pindex = chainman.m_blockman.LookupBlockIndex(hash);
+        if (!pindex || !active_chain.Contains(pindex)) {
+            return RESTERR(req, HTTP_NOT_FOUND, path[0] + " not found");
+        }
+        for (; pindex && positions.size() < size_t(count);
+             pindex = active_chain.Next(pindex)) {
+            if (!pindex->nStatus.hasData() ||
+                (undo && pindex->pprev && !pindex->nStatus.hasUndo())) {
+                return RESTERR(req, HTTP_NOT_FOUND,
+                               pindex->GetBlockHash().GetHex() +
+                                   " not available (pruned data)");
+            }
+            positions.emplace_back(pindex->GetBlockPos(),
+                                   pindex->GetUndoPos());
+        }
+    }
+
+    // Check all the data can be sent before starting the reply.
+    const CMessageHeader::MessageMagic &magic =
+        config.GetChainParams().DiskMagic();
+    std::map<int, std::unique_ptr<RestBlockFile>> block_files;
+    std::map<int, std::unique_ptr<RestBlockFile>> undo_files;
+    std::vector<RestBlockRecord> records;
+    records.reserve(positions.size() * (undo ? 2 : 1));
+    for (const auto &[block_pos, undo_pos] : positions) {
+        records.emplace_back();
+        if (!FindBlockRecord(block_files, false, block_pos, magic,
+                             records.back())) {
+            return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR,
+                           "Failed to read block data");
+        }
+        if (!undo) {
+            continue;
+        }
+        records.push_back({nullptr, 0, 0});
+        if (!undo_pos.IsNull() &&
+            !FindBlockRecord(undo_files, true, undo_pos, magic,
+                             records.back())) {
+            return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR,
+                           "Failed to read undo data");
+        }
+    }
+
+    CDataStream empty_record(SER_DISK, CLIENT_VERSION);
+    empty_record << magic << uint32_t(0) << uint256();
+    for (const RestBlockRecord &record : records) {
+        if (!record.file) {
+            req->WriteReplyChunk(empty_record.str());
+        } else if (!req->WriteReplyFileRange(*record.file->data, record.offset,
+                                              record.length)) {
+            // Some data may have been appended already, don't send it.
+            req->WriteHeader("Connection", "close");
+            req->WriteReply(HTTP_INTERNAL_SERVER_ERROR);
+            return false;
+        }
+    }
+
+    req->WriteHeader("Content-Type", "application/octet-stream");
+    req->WriteReply(HTTP_OK);
+    return true;
+}
+
 static bool rest_chaininfo(Config &config, const std::any &context,
                            HTTPRequest *req, const std::string &strURIPart) {
     if (!CheckWarmup(req)) {
@@ -447,9 +638,13 @@ static bool rest_mempool_contents(Config &config, const std::any &context,
         case RetFormat::JSON: {
             UniValue mempoolObject = MempoolToJSON(*mempool, true);
 
-            std::string strJSON = mempoolObject.write() + "\n";
             req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
+            mempoolObject.write(
+                [req](const std::string &chunk) {
+                    req->WriteReplyChunk(chunk);
+                },
+                JSONRPC_REPLY_CHUNK_SIZE);
+            req->WriteReply(HTTP_OK, "\n");
             return true;
         }
         default: {
@@ -829,6 +1024,7 @@ static const struct {
     {"/rest/mempool/info", rest_mempool_info},
     {"/rest/mempool/contents", rest_mempool_contents},
     {"/rest/headers/", rest_headers},
+    {"/rest/blocks/", rest_blocks},
     {"/rest/getutxos", rest_getutxos},
     {"/rest/blockhashbyheight/", rest_blockhash_by_height},
 };
@@ -570,38 +570,31 @@ static std::vector<RPCResult> MempoolEntryDescription() {
     };
 }
 
-static void entryToJSON(const CTxMemPool &pool, UniValue &info,
-                        const CTxMemPoolEntry &e)
-    EXCLUSIVE_LOCKS_REQUIRED(pool.cs) {
-    AssertLockHeld(pool.cs);
-
+static void entryToJSON(UniValue &info, const MempoolSnapshotEntry &e) {
     const bool deprecated_ancestors_descendants =
         IsDeprecatedRPCEnabled(gArgs, "mempool_ancestors_descendants");
 
     UniValue fees(UniValue::VOBJ);
-    fees.pushKV("base", e.GetFee());
-    fees.pushKV("modified", e.GetModifiedFee());
+    fees.pushKV("base", e.info.fee);
+    fees.pushKV("modified", e.info.fee + e.info.nFeeDelta);
     if (deprecated_ancestors_descendants) {
-        fees.pushKV("ancestor", e.GetModFeesWithAncestors());
-        fees.pushKV("descendant", e.GetModFeesWithDescendants());
+        fees.pushKV("ancestor", e.mod_fees_with_ancestors);
+        fees.pushKV("descendant", e.mod_fees_with_descendants);
     }
     info.pushKV("fees", fees);
 
-    info.pushKV("size", (int)e.GetTxSize());
-    info.pushKV("time", count_seconds(e.GetTime()));
-    info.pushKV("height", (int)e.GetHeight());
+    info.pushKV("size", (int)e.info.vsize);
+    info.pushKV("time", count_seconds(e.info.m_time));
+    info.pushKV("height", (int)e.height);
     if (deprecated_ancestors_descendants) {
-        info.pushKV("descendantcount", e.GetCountWithDescendants());
-        info.pushKV("descendantsize", e.GetSizeWithDescendants());
-        info.pushKV("ancestorcount", e.GetCountWithAncestors());
-        info.pushKV("ancestorsize", e.GetSizeWithAncestors());
+        info.pushKV("descendantcount", e.count_with_descendants);
+        info.pushKV("descendantsize", e.size_with_descendants);
+        info.pushKV("ancestorcount", e.count_with_ancestors);
+        info.pushKV("ancestorsize", e.size_with_ancestors);
     }
-    const CTransaction &tx = e.GetTx();
     std::set<std::string> setDepends;
-    for (const CTxIn &txin : tx.vin) {
-        if (pool.exists(txin.prevout.GetTxId())) {
-            setDepends.insert(txin.prevout.GetTxId().ToString());
-        }
+    for (const TxId &parent : e.parents) {
+        setDepends.insert(parent.ToString());
     }
 
     UniValue depends(UniValue::VARR);
@@ -612,12 +605,20 @@ static void entryToJSON(const CTxMemPool &pool, UniValue &info,
     info.pushKV("depends", depends);
 
     UniValue spent(UniValue::VARR);
-    for (const CTxMemPoolEntry &child : e.GetMemPoolChildrenConst()) {
-        spent.push_back(child.GetTx().GetId().ToString());
+    for (const TxId &child : e.children) {
+        spent.push_back(child.ToString());
     }
 
     info.pushKV("spentby", spent);
-    info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetId()));
+    info.pushKV("unbroadcast", e.unbroadcast);
+}
+
+static void entryToJSON(const CTxMemPool &pool, UniValue &info,
+                        const CTxMemPoolEntry &e)
+    EXCLUSIVE_LOCKS_REQUIRED(pool.cs) {
+    AssertLockHeld(pool.cs);
+    const bool unbroadcast = pool.IsUnbroadcastTx(e.GetTx().GetId());
+    entryToJSON(info, MempoolSnapshotEntry(e, unbroadcast));
 }
 
 UniValue MempoolToJSON(const CTxMemPool &pool, bool verbose,
@@ -628,16 +629,17 @@ UniValue MempoolToJSON(const CTxMemPool &pool, bool verbose,
                 RPC_INVALID_PARAMETER,
                 "Verbose results cannot contain mempool sequence values.");
         }
-        LOCK(pool.cs);
+        // The snapshot is immutable, so the mempool lock is not held while
+        // the result is built.
+        const ConstMempoolSnapshotRef snapshot = pool.GetSnapshot();
         UniValue o(UniValue::VOBJ);
-        for (const CTxMemPoolEntry &e : pool.mapTx) {
-            const TxId &txid = e.GetTx().GetId();
+        for (const auto &e : snapshot->GetEntries()) {
             UniValue info(UniValue::VOBJ);
-            entryToJSON(pool, info, e);
+            entryToJSON(info, *e);
             // Mempool has unique entries so there is no advantage in using
             // UniValue::pushKV, which checks if the key already exists in O(N).
             // UniValue::__pushKV is used instead which currently is O(1).
-            o.__pushKV(txid.ToString(), info);
+            o.__pushKV(e->info.tx->GetId().ToString(), info);
         }
         return o;
     } else {
@@ -3316,25 +3318,25 @@ UniValue CreateUTXOSnapshot(NodeContext &node, Chainstate &chainstate,
 void RegisterBlockchainRPCCommands(CRPCTable &t) {
     // clang-format off
     static const CRPCCommand commands[] = {
-        //  category            actor (function)
-        //  ------------------  ----------------------
-        { "blockchain",         getbestblockhash,                  },
-        { "blockchain",         getblock,                          },
+        //  category            actor (function)                   read only
+        //  ------------------  ----------------------             ---------
+        { "blockchain",         getbestblockhash,                  true },
+        { "blockchain",         getblock,                          true },
         { "blockchain",         getblockfrompeer,                  },
-        { "blockchain",         getblockchaininfo,                 },
-        { "blockchain",         getblockcount,                     },
-        { "blockchain",         getblockhash,                      },
-        { "blockchain",         getblockheader,                    },
-        { "blockchain",         getblockstats,                     },
-        { "blockchain",         getchaintips,                      },
-        { "blockchain",         getchaintxstats,                   },
-        { "blockchain",         getdifficulty,                     },
-        { "blockchain",         getmempoolancestors,               },
-        { "blockchain",         getmempooldescendants,             },
-        { "blockchain",         getmempoolentry,                   },
-        { "blockchain",         getmempoolinfo,                    },
-        { "blockchain",         getrawmempool,                     },
-        { "blockchain",         gettxout,                          },
+        { "blockchain",         getblockchaininfo,                 true },
+        { "blockchain",         getblockcount,                     true },
+        { "blockchain",         getblockhash,                      true },
+        { "blockchain",         getblockheader,                    true },
+        { "blockchain",         getblockstats,                     true },
+        { "blockchain",         getchaintips,                      true },
+        { "blockchain",         getchaintxstats,                   true },
+        { "blockchain",         getdifficulty,                     true },
+        { "blockchain",         getmempoolancestors,               true },
+        { "blockchain",         getmempooldescendants,             true },
+        { "blockchain",         getmempoolentry,                   true },
+        { "blockchain",         getmempoolinfo,                    true },
+        { "blockchain",         getrawmempool,                     true },
+        { "blockchain",         gettxout,                          true },
         { "blockchain",         gettxoutsetinfo,                   },
         { "blockchain",         pruneblockchain,                   },
         { "blockchain",         savemempool,                       },
@@ -608,6 +608,12 @@ static RPCHelpMan prioritisetransaction() {
 
             EnsureAnyMemPool(request.context)
                 .PrioritiseTransaction(txid, nAmount);
+
+            // The transaction may be selected differently now.
+            const NodeContext &node = EnsureAnyNodeContext(request.context);
+            if (node.block_template_builder) {
+                node.block_template_builder->Invalidate();
+            }
             return true;
         },
     };
@@ -820,6 +826,11 @@ static RPCHelpMan getblocktemplate() {
             const JSONRPCRequest &request) -> UniValue {
             NodeContext &node = EnsureAnyNodeContext(request.context);
             ChainstateManager &chainman = EnsureChainman(node);
+            // Make sure the template builder has been notified of the latest
+            // mempool changes.
+            if (node.block_template_builder) {
+                SyncWithValidationInterfaceQueue();
+            }
             LOCK(cs_main);
 
             const CChainParams &chainparams = config.GetChainParams();
@@ -945,6 +956,9 @@ static RPCHelpMan getblocktemplate() {
                         }
                     }
                 }
+                if (node.block_template_builder) {
+                    SyncWithValidationInterfaceQueue();
+                }
                 ENTER_CRITICAL_SECTION(cs_main);
 
                 if (!IsRPCRunning()) {
@@ -958,8 +972,12 @@ static RPCHelpMan getblocktemplate() {
             // Update block
             static CBlockIndex *pindexPrev;
             static int64_t nStart;
-            static std::unique_ptr<CBlockTemplate> pblocktemplate;
+            static std::shared_ptr<const CBlockTemplate> pblocktemplate;
+            // The builder keeps its template up to date with the mempool and
+            // only builds a new one when the mempool changed, so it is cheap
+            // to ask it on every call.
             if (pindexPrev != active_chain.Tip() ||
+                node.block_template_builder ||
                 (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast &&
                  GetTime() - nStart > 5)) {
                 // Clear pindexPrev so future calls make a new block, despite
@@ -972,11 +990,18 @@ static RPCHelpMan getblocktemplate() {
                 CBlockIndex *pindexPrevNew = active_chain.Tip();
                 nStart = GetTime();
 
-                // Create new block
+                // Create new block, or update the previous one with the
+                // mempool changes
                 CScript scriptDummy = CScript() << OP_TRUE;
-                pblocktemplate =
-                    BlockAssembler(config, active_chainstate, mempool)
-                        .CreateNewBlock(scriptDummy);
+                if (node.block_template_builder) {
+                    pblocktemplate =
+                        node.block_template_builder->GetBlockTemplate(
+                            active_chainstate, scriptDummy);
+                } else {
+                    pblocktemplate =
+                        BlockAssembler(config, active_chainstate, mempool)
+                            .CreateNewBlock(scriptDummy);
+                }
                 if (!pblocktemplate) {
                     throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
                 }
@@ -987,11 +1012,12 @@ static RPCHelpMan getblocktemplate() {
 
             CHECK_NONFATAL(pindexPrev);
             // pointer for convenience
-            CBlock *pblock = &pblocktemplate->block;
+            const CBlock *pblock = &pblocktemplate->block;
 
-            // Update nTime
-            UpdateTime(pblock, chainparams, pindexPrev);
-            pblock->nNonce = 0;
+            // Update nTime, in a copy of the header since the template can be
+            // shared with the block template builder.
+            CBlockHeader header = pblock->GetBlockHeader();
+            UpdateTime(&header, chainparams, pindexPrev);
 
             UniValue aCaps(UniValue::VARR);
             aCaps.push_back("proposal");
@@ -1062,7 +1088,7 @@ static RPCHelpMan getblocktemplate() {
             coinbasetxn.pushKV("minerfund", minerFund);
 
             arith_uint256 hashTarget =
-                arith_uint256().SetCompact(pblock->nBits);
+                arith_uint256().SetCompact(header.nBits);
 
             UniValue aMutable(UniValue::VARR);
             aMutable.push_back("time");
@@ -1072,9 +1098,9 @@ static RPCHelpMan getblocktemplate() {
             UniValue result(UniValue::VOBJ);
             result.pushKV("capabilities", aCaps);
 
-            result.pushKV("version", pblock->nVersion);
+            result.pushKV("version", header.nVersion);
 
-            result.pushKV("previousblockhash", pblock->hashPrevBlock.GetHex());
+            result.pushKV("previousblockhash", header.hashPrevBlock.GetHex());
             result.pushKV("transactions", transactions);
             result.pushKV("coinbaseaux", aux);
             result.pushKV("coinbasetxn", coinbasetxn);
@@ -1094,8 +1120,8 @@ static RPCHelpMan getblocktemplate() {
                 result.pushKV("sigoplimit", sigCheckLimit);
             }
             result.pushKV("sizelimit", DEFAULT_MAX_BLOCK_SIZE);
-            result.pushKV("curtime", pblock->GetBlockTime());
-            result.pushKV("bits", strprintf("%08x", pblock->nBits));
+            result.pushKV("curtime", header.GetBlockTime());
+            result.pushKV("bits", strprintf("%08x", header.nBits));
             result.pushKV("height", int64_t(pindexPrev->nHeight) + 1);
 
             return result;
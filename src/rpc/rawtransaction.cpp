@@ -2090,17 +2090,17 @@ RPCHelpMan analyzepsbt() {
 void RegisterRawTransactionRPCCommands(CRPCTable &t) {
     // clang-format off
     static const CRPCCommand commands[] = {
-        //  category            actor (function)
-        //  ------------------  ----------------------
-        { "rawtransactions",    getrawtransaction,          },
-        { "rawtransactions",    createrawtransaction,       },
-        { "rawtransactions",    decoderawtransaction,       },
-        { "rawtransactions",    decodescript,               },
+        //  category            actor (function)            read only
+        //  ------------------  ----------------------      ---------
+        { "rawtransactions",    getrawtransaction,          true },
+        { "rawtransactions",    createrawtransaction,       true },
+        { "rawtransactions",    decoderawtransaction,       true },
+        { "rawtransactions",    decodescript,               true },
         { "rawtransactions",    sendrawtransaction,         },
         { "rawtransactions",    combinerawtransaction,      },
         { "rawtransactions",    signrawtransactionwithkey,  },
         { "rawtransactions",    testmempoolaccept,          },
-        { "rawtransactions",    decodepsbt,                 },
+        { "rawtransactions",    decodepsbt,                 true },
         { "rawtransactions",    combinepsbt,                },
         { "rawtransactions",    finalizepsbt,               },
         { "rawtransactions",    createpsbt,                 },
@@ -54,6 +54,19 @@ std::string JSONRPCReply(const UniValue &result, const UniValue &error,
     return reply.write() + "\n";
 }
 
+void JSONRPCWriteReply(const UniValue &result, const UniValue &error,
+                       const UniValue &id,
+                       const std::function<void(const std::string &)> &sink) {
+    // Keep the key order of JSONRPCReplyObj().
+    sink("{\"result\":");
+    if (!error.isNull()) {
+        sink(NullUniValue.write());
+    } else {
+        result.write(sink, JSONRPC_REPLY_CHUNK_SIZE);
+    }
+    sink(",\"error\":" + error.write() + ",\"id\":" + id.write() + "}\n");
+}
+
 UniValue JSONRPCError(int code, const std::string &message) {
     UniValue error(UniValue::VOBJ);
     error.pushKV("code", code);
@@ -8,14 +8,29 @@
 #include <univalue.h>
 
 #include <any>
+#include <functional>
 #include <string>
 
+/**
+ * Size of the chunks large JSON-RPC replies are serialized in, instead of
+ * building the whole reply as a single string. The chunks are appended to the
+ * reply buffer, they are not sent separately.
+ */
+static constexpr size_t JSONRPC_REPLY_CHUNK_SIZE = 64 * 1024;
+
 UniValue JSONRPCRequestObj(const std::string &strMethod, const UniValue &params,
                            const UniValue &id);
 UniValue JSONRPCReplyObj(const UniValue &result, const UniValue &error,
                          const UniValue &id);
 std::string JSONRPCReply(const UniValue &result, const UniValue &error,
                          const UniValue &id);
+/**
+ * Same as JSONRPCReply(), but the reply is passed to sink in chunks as it is
+ * serialized, and the result is not copied into a reply object.
+ */
+void JSONRPCWriteReply(const UniValue &result, const UniValue &error,
+                       const UniValue &id,
+                       const std::function<void(const std::string &)> &sink);
 UniValue JSONRPCError(int code, const std::string &message);
 
 /** Generate a new RPC authentication cookie and write it to disk */
@@ -7,6 +7,7 @@
 #include <rpc/server.h>
 
 #include <config.h>
+#include <httpserver.h>
 #include <rpc/util.h>
 #include <shutdown.h>
 #include <sync.h>
@@ -16,7 +17,10 @@
 #include <boost/algorithm/string/split.hpp>
 #include <boost/signals2/signal.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <memory> // for unique_ptr
 #include <mutex>
 #include <set>
@@ -92,6 +96,16 @@ UniValue RPCServer::ExecuteCommand(const Config &config,
     return tableRPC.execute(config, request);
 }
 
+bool RPCServer::IsReadOnlyCommand(const std::string &method) const {
+    {
+        auto commandsReadView = commands.getReadView();
+        if (commandsReadView->count(method)) {
+            return false;
+        }
+    }
+    return tableRPC.isReadOnly(method);
+}
+
 void RPCServer::RegisterCommand(std::unique_ptr<RPCCommand> command) {
     if (command != nullptr) {
         const std::string &commandName = command->GetName();
@@ -277,6 +291,32 @@ static RPCHelpMan getrpcinfo() {
                        }},
                       {RPCResult::Type::STR, "logpath",
                        "The complete file path to the debug log"},
+                      {RPCResult::Type::ARR,
+                       "http_work_queues",
+                       "The work queue of each HTTP event thread",
+                       {
+                           {RPCResult::Type::OBJ,
+                            "",
+                            "",
+                            {
+                                {RPCResult::Type::NUM, "depth",
+                                 "The number of requests waiting to be "
+                                 "handled"},
+                                {RPCResult::Type::NUM, "max_depth",
+                                 "The maximum number of waiting requests"},
+                                {RPCResult::Type::NUM, "handled",
+                                 "The number of requests handled"},
+                                {RPCResult::Type::NUM, "rejected",
+                                 "The number of requests rejected because "
+                                 "the queue was full"},
+                                {RPCResult::Type::NUM, "avg_wait_time",
+                                 "The average time the handled requests "
+                                 "waited in the queue, in microseconds"},
+                                {RPCResult::Type::NUM, "avg_handle_time",
+                                 "The average time it took to handle the "
+                                 "requests, in microseconds"},
+                            }},
+                       }},
                   }},
         RPCExamples{HelpExampleCli("getrpcinfo", "") +
                     HelpExampleRpc("getrpcinfo", "")},
@@ -300,6 +340,22 @@ static RPCHelpMan getrpcinfo() {
             UniValue log_path(UniValue::VSTR, path);
             result.pushKV("logpath", log_path);
 
+            UniValue work_queues(UniValue::VARR);
+            for (const HTTPWorkQueueStats &stats : GetHTTPWorkQueueStats()) {
+                const uint64_t handled = std::max<uint64_t>(stats.handled, 1);
+                UniValue entry(UniValue::VOBJ);
+                entry.pushKV("depth", uint64_t(stats.depth));
+                entry.pushKV("max_depth", uint64_t(stats.max_depth));
+                entry.pushKV("handled", stats.handled);
+                entry.pushKV("rejected", stats.rejected);
+                entry.pushKV("avg_wait_time",
+                             count_microseconds(stats.wait_time) / handled);
+                entry.pushKV("avg_handle_time",
+                             count_microseconds(stats.handle_time) / handled);
+                work_queues.push_back(entry);
+            }
+            result.pushKV("http_work_queues", work_queues);
+
             return result;
         }};
 }
@@ -430,14 +486,103 @@ static UniValue JSONRPCExecOne(const Config &config, RPCServer &rpcServer,
     return rpc_result;
 }
 
-std::string JSONRPCExecBatch(const Config &config, RPCServer &rpcServer,
-                             const JSONRPCRequest &jreq, const UniValue &vReq) {
-    UniValue ret(UniValue::VARR);
-    for (size_t i = 0; i < vReq.size(); i++) {
-        ret.push_back(JSONRPCExecOne(config, rpcServer, jreq, vReq[i]));
+static bool IsReadOnlyCall(const RPCServer &rpcServer, const UniValue &req) {
+    if (!req.isObject()) {
+        return false;
+    }
+    const UniValue &method = find_value(req, "method");
+    return method.isStr() && rpcServer.IsReadOnlyCommand(method.get_str());
+}
+
+/**
+ * Calls of a batch executed in parallel. The threads pick the next call to
+ * execute until there is none left. The state is shared with the threads that
+ * help with the execution, which may only start once all the calls have been
+ * executed: they must then exit without accessing the batch.
+ */
+struct ParallelBatchCalls {
+    const Config &config;
+    RPCServer &rpcServer;
+    const JSONRPCRequest &jreq;
+    const UniValue &vReq;
+    std::vector<UniValue> &replies;
+    const size_t end;
+    std::atomic<size_t> next;
+
+    Mutex mutex;
+    std::condition_variable cond;
+    size_t executed GUARDED_BY(mutex){0};
+
+    ParallelBatchCalls(const Config &_config, RPCServer &_rpcServer,
+                       const JSONRPCRequest &_jreq, const UniValue &_vReq,
+                       std::vector<UniValue> &_replies, size_t begin,
+                       size_t _end)
+        : config(_config), rpcServer(_rpcServer), jreq(_jreq), vReq(_vReq),
+          replies(_replies), end(_end), next(begin) {}
+
+    void Run() EXCLUSIVE_LOCKS_REQUIRED(!mutex) {
+        size_t count = 0;
+        for (size_t i = next++; i < end; i = next++, ++count) {
+            replies[i] = JSONRPCExecOne(config, rpcServer, jreq, vReq[i]);
+        }
+        if (count > 0) {
+            LOCK(mutex);
+            executed += count;
+            cond.notify_all();
+        }
+    }
+};
+
+/**
+ * Execute the calls [begin, end) of a batch in parallel, using the current
+ * thread and the HTTP worker threads which are available.
+ */
+static void JSONRPCExecParallel(const Config &config, RPCServer &rpcServer,
+                                const JSONRPCRequest &jreq,
+                                const UniValue &vReq,
+                                std::vector<UniValue> &replies, size_t begin,
+                                size_t end) {
+    auto calls = std::make_shared<ParallelBatchCalls>(
+        config, rpcServer, jreq, vReq, replies, begin, end);
+    // The current thread executes calls as well, so it never waits for a
+    // worker thread that is not available.
+    for (size_t i = begin + 1; i < end; ++i) {
+        if (!QueueHTTPWork([calls] { calls->Run(); })) {
+            break;
+        }
     }
+    calls->Run();
 
-    return ret.write() + "\n";
+    WAIT_LOCK(calls->mutex, lock);
+    calls->cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(calls->mutex) {
+        return calls->executed == end - begin;
+    });
+}
+
+void JSONRPCExecBatch(const Config &config, RPCServer &rpcServer,
+                      const JSONRPCRequest &jreq, const UniValue &vReq,
+                      const std::function<void(const std::string &)> &sink) {
+    std::vector<UniValue> replies(vReq.size());
+    size_t i = 0;
+    while (i < vReq.size()) {
+        size_t end = i;
+        while (end < vReq.size() && IsReadOnlyCall(rpcServer, vReq[end])) {
+            ++end;
+        }
+        if (end - i > 1) {
+            JSONRPCExecParallel(config, rpcServer, jreq, vReq, replies, i, end);
+            i = end;
+        } else {
+            replies[i] = JSONRPCExecOne(config, rpcServer, jreq, vReq[i]);
+            ++i;
+        }
+    }
+
+    UniValue ret(UniValue::VARR);
+    ret.push_backV(replies);
+
+    ret.write(sink, JSONRPC_REPLY_CHUNK_SIZE);
+    sink("\n");
 }
 
 /**
@@ -544,6 +689,16 @@ static bool ExecuteCommand(const Config &config, const CRPCCommand &command,
     }
 }
 
+bool CRPCTable::isReadOnly(const std::string &method) const {
+    auto it = mapCommands.find(method);
+    if (it == mapCommands.end() || it->second.empty()) {
+        return false;
+    }
+    return std::all_of(
+        it->second.begin(), it->second.end(),
+        [](const CRPCCommand *command) { return command->read_only; });
+}
+
 std::vector<std::string> CRPCTable::listCommands() const {
     std::vector<std::string> commandList;
     for (const auto &i : mapCommands) {
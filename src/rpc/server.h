@@ -53,6 +53,12 @@ public:
     UniValue ExecuteCommand(const Config &config,
                             const JSONRPCRequest &request) const;
 
+    /**
+     * Whether a method only has read only handlers, which makes it safe to
+     * execute in parallel with other read only calls.
+     */
+    bool IsReadOnlyCommand(const std::string &method) const;
+
     /**
      * Register an RPC command.
      */
@@ -160,7 +166,8 @@ public:
           unique_id(_unique_id) {}
 
     //! Simplified constructor taking plain RpcMethodFnType function pointer.
-    CRPCCommand(std::string _category, RpcMethodFnType _fn)
+    CRPCCommand(std::string _category, RpcMethodFnType _fn,
+                bool _read_only = false)
         : CRPCCommand(
               _category, _fn().m_name,
               [_fn](const Config &config, const JSONRPCRequest &request,
@@ -168,13 +175,19 @@ public:
                   result = _fn().HandleRequest(config, request);
                   return true;
               },
-              _fn().GetArgNames(), intptr_t(_fn)) {}
+              _fn().GetArgNames(), intptr_t(_fn)) {
+        read_only = _read_only;
+    }
 
     std::string category;
     std::string name;
     Actor actor;
     std::vector<std::string> argNames;
     intptr_t unique_id;
+    //! The command doesn't change the state of the node and is safe to run
+    //! concurrently with other commands, so the read only calls of a batch
+    //! can be executed in parallel.
+    bool read_only{false};
 };
 
 /**
@@ -197,6 +210,11 @@ public:
      */
     UniValue execute(const Config &config, const JSONRPCRequest &request) const;
 
+    /**
+     * Whether a method is registered and all its handlers are read only.
+     */
+    bool isReadOnly(const std::string &method) const;
+
     /**
      * Returns a list of registered commands
      * @returns List of registered commands.
@@ -233,8 +251,15 @@ extern CRPCTable tableRPC;
 void StartRPC();
 void InterruptRPC();
 void StopRPC();
-std::string JSONRPCExecBatch(const Config &config, RPCServer &rpcServer,
-                             const JSONRPCRequest &req, const UniValue &vReq);
+/**
+ * Execute a batch of requests and pass the reply to sink in chunks as it is
+ * serialized. The read only calls which follow each other in the batch are
+ * executed in parallel by the HTTP worker threads that are available, the
+ * other calls are executed in order once all the previous calls completed.
+ */
+void JSONRPCExecBatch(const Config &config, RPCServer &rpcServer,
+                      const JSONRPCRequest &req, const UniValue &vReq,
+                      const std::function<void(const std::string &)> &sink);
 
 /**
  * Retrieves any serialization flags requested in command line argument
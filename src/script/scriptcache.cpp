@@ -4,13 +4,18 @@
 
 #include <script/scriptcache.h>
 
+#include <clientversion.h>
 #include <crypto/sha256.h>
 #include <cuckoocache.h>
+#include <fs.h>
+#include <logging.h>
 #include <primitives/transaction.h>
 #include <random.h>
 #include <script/sigcache.h>
+#include <streams.h>
 #include <sync.h>
 #include <util/system.h>
+#include <util/time.h>
 #include <validation.h>
 
 /**
@@ -72,15 +77,25 @@ public:
 static CuckooCache::cache<ScriptCacheElement, ScriptCacheHasher>
     g_scriptExecutionCache;
 static CSHA256 g_scriptExecutionCacheHasher;
+static uint256 g_scriptExecutionCacheNonce;
+//! When g_scriptExecutionCacheNonce was generated.
+static int64_t g_scriptExecutionCacheNonceTime;
 
-void InitScriptExecutionCache() {
-    // Setup the salted hasher
-    uint256 nonce = GetRandHash();
+static void SetScriptExecutionCacheNonce(const uint256 &nonce,
+                                         int64_t nonce_time) {
+    g_scriptExecutionCacheNonce = nonce;
+    g_scriptExecutionCacheNonceTime = nonce_time;
     // We want the nonce to be 64 bytes long to force the hasher to process
     // this chunk, which makes later hash computations more efficient. We
     // just write our 32-byte entropy twice to fill the 64 bytes.
+    g_scriptExecutionCacheHasher = CSHA256();
     g_scriptExecutionCacheHasher.Write(nonce.begin(), 32);
     g_scriptExecutionCacheHasher.Write(nonce.begin(), 32);
+}
+
+void InitScriptExecutionCache() {
+    // Setup the salted hasher
+    SetScriptExecutionCacheNonce(GetRandHash(), GetTime());
     // nMaxCacheSize is unsigned. If -maxscriptcachesize is set to zero,
     // setup_bytes creates the minimum possible cache (2 elements).
     size_t nMaxCacheSize =
@@ -125,3 +140,126 @@ void AddKeyInScriptCache(ScriptCacheKey key, int nSigChecks) {
     ScriptCacheElement elem(key, nSigChecks);
     g_scriptExecutionCache.insert(elem);
 }
+
+static const uint64_t SCRIPT_CACHE_DUMP_VERSION = 1;
+
+bool DumpScriptCaches(const fs::path &path) {
+    int64_t start = GetTimeMicros();
+
+    std::vector<ScriptCacheElement> elements;
+    {
+        LOCK(cs_main);
+        g_scriptExecutionCache.for_each(
+            [&](const ScriptCacheElement &elem) { elements.push_back(elem); });
+    }
+
+    try {
+        fs::path path_new = path;
+        path_new += ".new";
+        FILE *filestr = fsbridge::fopen(path_new, "wb");
+        if (!filestr) {
+            return false;
+        }
+
+        CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+
+        uint64_t version = SCRIPT_CACHE_DUMP_VERSION;
+        file << version;
+        // The entries are only valid for the script interpreter that computed
+        // them, so record which build wrote them.
+        file << int32_t(CLIENT_VERSION) << FormatFullVersion();
+
+        file << g_scriptExecutionCacheNonce << g_scriptExecutionCacheNonceTime;
+        file << uint64_t(elements.size());
+        for (const ScriptCacheElement &elem : elements) {
+            file << elem.key << int32_t(elem.nSigChecks);
+        }
+
+        DumpSignatureCache(file);
+
+        if (!FileCommit(file.Get())) {
+            throw std::runtime_error("FileCommit failed");
+        }
+        file.fclose();
+        if (!RenameOver(path_new, path)) {
+            throw std::runtime_error("Rename failed");
+        }
+        LogPrintf("Dumped script caches: %gs\n",
+                  (GetTimeMicros() - start) * 0.000001);
+    } catch (const std::exception &e) {
+        LogPrintf("Failed to dump script caches: %s. Continuing anyway.\n",
+                  e.what());
+        return false;
+    }
+    return true;
+}
+
+bool LoadScriptCaches(const fs::path &path,
+                      std::chrono::seconds max_nonce_age) {
+    CAutoFile file(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        LogPrintf("Failed to open script caches file from disk. Continuing "
+                  "anyway.\n");
+        return false;
+    }
+
+    size_t script_count = 0;
+    size_t sig_count = 0;
+    try {
+        uint64_t version;
+        file >> version;
+        if (version != SCRIPT_CACHE_DUMP_VERSION) {
+            return false;
+        }
+
+        // A script cached as valid by another build may not be valid for this
+        // one, e.g. after an interpreter fix, so don't trust its entries.
+        int32_t client_version;
+        std::string full_version;
+        file >> client_version >> LIMITED_STRING(full_version, 256);
+        if (client_version != CLIENT_VERSION ||
+            full_version != FormatFullVersion()) {
+            LogPrintf("Discarding the script caches written by version %s\n",
+                      full_version);
+            return false;
+        }
+
+        uint256 nonce;
+        int64_t nonce_time;
+        uint64_t num;
+        file >> nonce >> nonce_time >> num;
+        // Entries computed with an old nonce are dropped, the caches keep
+        // their fresh nonce instead.
+        const bool keep =
+            nonce_time >= GetTime() - count_seconds(max_nonce_age);
+        {
+            LOCK(cs_main);
+            if (keep) {
+                SetScriptExecutionCacheNonce(nonce, nonce_time);
+            }
+            while (num) {
+                --num;
+                ScriptCacheElement elem;
+                int32_t nSigChecks;
+                file >> elem.key >> nSigChecks;
+                elem.nSigChecks = nSigChecks;
+                if (keep) {
+                    g_scriptExecutionCache.insert(elem);
+                    ++script_count;
+                }
+            }
+        }
+
+        sig_count = LoadSignatureCache(file, max_nonce_age);
+    } catch (const std::exception &e) {
+        LogPrintf("Failed to deserialize script caches data on disk: %s. "
+                  "Continuing anyway.\n",
+                  e.what());
+        return false;
+    }
+
+    LogPrintf("Imported script caches from disk: %u script execution and %u "
+              "signature cache entries\n",
+              script_count, sig_count);
+    return true;
+}
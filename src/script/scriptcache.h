@@ -6,8 +6,10 @@
 #define BITCOIN_SCRIPT_SCRIPTCACHE_H
 
 #include <array>
+#include <chrono>
 #include <cstdint>
 
+#include <serialize.h>
 #include <sync.h>
 
 // Actually declared in validation.cpp; can't include because of circular
@@ -16,6 +18,10 @@ extern RecursiveMutex cs_main;
 
 class CTransaction;
 
+namespace fs {
+class path;
+}
+
 /**
  * The script cache is a map using a key/value element, that caches the
  * success of executing a specific transaction's input scripts under a
@@ -39,6 +45,8 @@ public:
         return rhs.data == data;
     }
 
+    SERIALIZE_METHODS(ScriptCacheKey, obj) { READWRITE(obj.data); }
+
     friend class ScriptCacheHasher;
 };
 
@@ -48,6 +56,13 @@ public:
 static const unsigned int DEFAULT_MAX_SCRIPT_CACHE_SIZE = 32;
 // Maximum sig cache size allowed
 static const int64_t MAX_MAX_SCRIPT_CACHE_SIZE = 16384;
+/** Default for -persistscriptcache */
+static const bool DEFAULT_PERSIST_SCRIPT_CACHE = false;
+/**
+ * Maximum age of the nonces of persisted caches. The nonce is on disk along
+ * with the cache, so it is replaced by a fresh one after this long.
+ */
+static constexpr std::chrono::hours MAX_SCRIPT_CACHE_NONCE_AGE{24 * 14};
 
 /** Initializes the script-execution cache */
 void InitScriptExecutionCache();
@@ -65,4 +80,20 @@ bool IsKeyInScriptCache(ScriptCacheKey key, bool erase, int &nSigChecksOut)
 void AddKeyInScriptCache(ScriptCacheKey key, int nSigChecks)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/**
+ * Write the script execution and signature caches, along with their nonces,
+ * to a file.
+ */
+bool DumpScriptCaches(const fs::path &path);
+
+/**
+ * Load the caches written by DumpScriptCaches. Entries computed with nonces
+ * older than max_nonce_age are dropped, and the whole file is discarded if it
+ * was written by another version. Must be called right after the caches are
+ * initialized, before they are used.
+ */
+bool LoadScriptCaches(
+    const fs::path &path,
+    std::chrono::seconds max_nonce_age = MAX_SCRIPT_CACHE_NONCE_AGE);
+
 #endif // BITCOIN_SCRIPT_SCRIPTCACHE_H
@@ -8,8 +8,10 @@
 #include <cuckoocache.h>
 #include <pubkey.h>
 #include <random.h>
+#include <streams.h>
 #include <uint256.h>
 #include <util/system.h>
+#include <util/time.h>
 
 #include <boost/thread/lock_types.hpp>
 #include <boost/thread/shared_mutex.hpp>
@@ -25,6 +27,9 @@ class CSignatureCache {
 private:
     //! Entries are SHA256(nonce || signature hash || public key || signature):
     CSHA256 m_salted_hasher;
+    uint256 m_nonce;
+    //! When the nonce was generated.
+    int64_t m_nonce_time;
     typedef CuckooCache::cache<CuckooCache::KeyOnly<uint256>,
                                SignatureCacheHasher>
         map_type;
@@ -32,11 +37,19 @@ private:
     boost::shared_mutex cs_sigcache;
 
 public:
-    CSignatureCache() {
-        uint256 nonce = GetRandHash();
+    CSignatureCache() { SetNonce(GetRandHash(), GetTime()); }
+
+    /**
+     * Only valid while the cache is empty, as the entries computed with the
+     * previous nonce would never be found again.
+     */
+    void SetNonce(const uint256 &nonce, int64_t nonce_time) {
+        m_nonce = nonce;
+        m_nonce_time = nonce_time;
         // We want the nonce to be 64 bytes long to force the hasher to process
         // this chunk, which makes later hash computations more efficient. We
         // just write our 32-byte entropy twice to fill the 64 bytes.
+        m_salted_hasher = CSHA256();
         m_salted_hasher.Write(nonce.begin(), 32);
         m_salted_hasher.Write(nonce.begin(), 32);
     }
@@ -61,6 +74,35 @@ public:
         setValid.insert(entry);
     }
     uint32_t setup_bytes(size_t n) { return setValid.setup_bytes(n); }
+
+    void Dump(CAutoFile &file) {
+        std::vector<uint256> entries;
+        {
+            boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+            setValid.for_each([&](const uint256 &entry) {
+                entries.push_back(entry);
+            });
+        }
+        file << m_nonce << m_nonce_time << entries;
+    }
+
+    size_t Load(CAutoFile &file, std::chrono::seconds max_nonce_age) {
+        uint256 nonce;
+        int64_t nonce_time;
+        std::vector<uint256> entries;
+        file >> nonce >> nonce_time >> entries;
+        if (nonce_time < GetTime() - count_seconds(max_nonce_age)) {
+            // Keep the fresh nonce, the entries can't be migrated to it.
+            return 0;
+        }
+
+        SetNonce(nonce, nonce_time);
+        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+        for (const uint256 &entry : entries) {
+            setValid.insert(entry);
+        }
+        return entries.size();
+    }
 };
 
 /**
@@ -90,6 +132,14 @@ void InitSignatureCache() {
               (nElems * sizeof(uint256)) >> 20, nMaxCacheSize >> 20, nElems);
 }
 
+void DumpSignatureCache(CAutoFile &file) {
+    signatureCache.Dump(file);
+}
+
+size_t LoadSignatureCache(CAutoFile &file, std::chrono::seconds max_nonce_age) {
+    return signatureCache.Load(file, max_nonce_age);
+}
+
 template <typename F>
 bool RunMemoizedCheck(const std::vector<uint8_t> &vchSig, const CPubKey &pubkey,
                       const uint256 &sighash, bool storeOrErase, const F &fun) {
@@ -117,6 +167,11 @@ bool CachingTransactionSignatureChecker::IsCached(
 bool CachingTransactionSignatureChecker::VerifySignature(
     const std::vector<uint8_t> &vchSig, const CPubKey &pubkey,
     const uint256 &sighash) const {
+    if (batch && vchSig.size() == CPubKey::SCHNORR_SIZE) {
+        return RunMemoizedCheck(vchSig, pubkey, sighash, store, [&] {
+            return batch->Add(pubkey, sighash, vchSig);
+        });
+    }
     return RunMemoizedCheck(vchSig, pubkey, sighash, store, [&] {
         return TransactionSignatureChecker::VerifySignature(vchSig, pubkey,
                                                             sighash);
@@ -9,6 +9,7 @@
 #include <script/interpreter.h>
 #include <util/hasher.h>
 
+#include <chrono>
 #include <vector>
 
 // DoS prevention: limit cache size to 32MB (over 1000000 entries on 64-bit
@@ -18,11 +19,20 @@ static const unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 32;
 // Maximum sig cache size allowed
 static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
 
+class CAutoFile;
 class CPubKey;
+class SchnorrBatchVerifier;
 
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker {
 private:
     bool store;
+    /**
+     * When set, Schnorr signatures that are not found in the cache are queued
+     * into this batch and assumed valid. The caller is then responsible for
+     * verifying the batch before trusting the result of the script
+     * evaluation. Never used when storing into the cache.
+     */
+    SchnorrBatchVerifier *batch;
 
     bool IsCached(const std::vector<uint8_t> &vchSig, const CPubKey &vchPubKey,
                   const uint256 &sighash) const;
@@ -31,9 +41,10 @@ public:
     CachingTransactionSignatureChecker(const CTransaction *txToIn,
                                        unsigned int nInIn,
                                        const Amount amountIn, bool storeIn,
-                                       PrecomputedTransactionData &txdataIn)
+                                       PrecomputedTransactionData &txdataIn,
+                                       SchnorrBatchVerifier *batchIn = nullptr)
         : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn),
-          store(storeIn) {}
+          store(storeIn), batch(storeIn ? nullptr : batchIn) {}
 
     bool VerifySignature(const std::vector<uint8_t> &vchSig,
                          const CPubKey &vchPubKey,
@@ -44,4 +55,16 @@ public:
 
 void InitSignatureCache();
 
+/** Write the entries of the signature cache and its nonce to a file. */
+void DumpSignatureCache(CAutoFile &file);
+
+/**
+ * Insert the entries written by DumpSignatureCache into the signature cache,
+ * along with the nonce they were computed with. If the nonce is older than
+ * max_nonce_age, the entries are dropped and the cache keeps its own fresh
+ * nonce instead. Must be called before the cache is used.
+ * @returns the number of entries loaded.
+ */
+size_t LoadSignatureCache(CAutoFile &file, std::chrono::seconds max_nonce_age);
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
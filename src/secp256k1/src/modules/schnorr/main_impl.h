@@ -30,6 +30,111 @@ int secp256k1_schnorr_verify(
     return secp256k1_schnorr_sig_verify(&ctx->ecmult_ctx, sig64, &q, msghash32);
 }
 
+typedef struct {
+    const secp256k1_context *ctx;
+    const unsigned char *const *sig64;
+    const unsigned char *const *msghash32;
+    const secp256k1_pubkey *const *pubkeys;
+    unsigned char seed[32];
+} secp256k1_schnorr_verify_batch_ecmult_data;
+
+/* Callback feeding R_i with weight a_i and P_i with weight a_i * e_i to the
+ * multiexponentiation, at index 2 * i and 2 * i + 1 respectively. */
+static int secp256k1_schnorr_verify_batch_ecmult_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    secp256k1_schnorr_verify_batch_ecmult_data *ecmult_data = (secp256k1_schnorr_verify_batch_ecmult_data *) data;
+    size_t i = idx / 2;
+
+    secp256k1_schnorr_batch_randomizer(sc, ecmult_data->seed, i);
+    if (idx % 2 == 0) {
+        secp256k1_fe rx;
+        if (!secp256k1_fe_set_b32(&rx, ecmult_data->sig64[i])) {
+            return 0;
+        }
+
+        /* Decompress R with R.y a quadratic residue. */
+        return secp256k1_ge_set_xquad(pt, &rx);
+    } else {
+        secp256k1_scalar e;
+        if (!secp256k1_pubkey_load(ecmult_data->ctx, pt, ecmult_data->pubkeys[i])) {
+            return 0;
+        }
+
+        secp256k1_schnorr_compute_e(&e, ecmult_data->sig64[i], pt, ecmult_data->msghash32[i]);
+        secp256k1_scalar_mul(sc, sc, &e);
+        return 1;
+    }
+}
+
+int secp256k1_schnorr_verify_batch(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    const unsigned char *const *sig64,
+    const unsigned char *const *msghash32,
+    const secp256k1_pubkey *const *pubkeys,
+    size_t n_sigs
+) {
+    secp256k1_schnorr_verify_batch_ecmult_data ecmult_data;
+    secp256k1_sha256 sha;
+    secp256k1_scalar s, a, sum;
+    secp256k1_gej rj;
+    size_t i;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(n_sigs == 0 || sig64 != NULL);
+    ARG_CHECK(n_sigs == 0 || msghash32 != NULL);
+    ARG_CHECK(n_sigs == 0 || pubkeys != NULL);
+    ARG_CHECK(n_sigs <= SIZE_MAX / 2);
+
+    /* The randomizers are derived from all the inputs, so that no signature
+     * can be crafted to cancel out an invalid one in the batch. */
+    secp256k1_sha256_initialize(&sha);
+    for (i = 0; i < n_sigs; i++) {
+        secp256k1_ge p;
+        unsigned char buf[33];
+        size_t size = 0;
+
+        if (!secp256k1_pubkey_load(ctx, &p, pubkeys[i])) {
+            return 0;
+        }
+        secp256k1_eckey_pubkey_serialize(&p, buf, &size, 1);
+        VERIFY_CHECK(size == 33);
+
+        secp256k1_sha256_write(&sha, sig64[i], 64);
+        secp256k1_sha256_write(&sha, msghash32[i], 32);
+        secp256k1_sha256_write(&sha, buf, 33);
+    }
+    secp256k1_sha256_finalize(&sha, ecmult_data.seed);
+
+    /* Compute -sum(a_i * s_i), the weight of G. */
+    secp256k1_scalar_set_int(&sum, 0);
+    for (i = 0; i < n_sigs; i++) {
+        int overflow = 0;
+        secp256k1_scalar_set_b32(&s, sig64[i] + 32, &overflow);
+        if (overflow) {
+            return 0;
+        }
+
+        secp256k1_schnorr_batch_randomizer(&a, ecmult_data.seed, i);
+        secp256k1_scalar_mul(&s, &s, &a);
+        secp256k1_scalar_add(&sum, &sum, &s);
+    }
+    secp256k1_scalar_negate(&sum, &sum);
+
+    ecmult_data.ctx = ctx;
+    ecmult_data.sig64 = sig64;
+    ecmult_data.msghash32 = msghash32;
+    ecmult_data.pubkeys = pubkeys;
+
+    /* All the signatures are valid iff sum(a_i * (R_i + e_i * P_i - s_i * G))
+     * is the point at infinity, except with negligible probability. */
+    if (!secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &rj, &sum, secp256k1_schnorr_verify_batch_ecmult_callback, (void *) &ecmult_data, 2 * n_sigs)) {
+        return 0;
+    }
+
+    return secp256k1_gej_is_infinity(&rj);
+}
+
 int secp256k1_schnorr_sign(
     const secp256k1_context *ctx,
     unsigned char *sig64,
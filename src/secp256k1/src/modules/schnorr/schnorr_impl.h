@@ -127,6 +127,36 @@ static int secp256k1_schnorr_compute_e(
     return !overflow & !secp256k1_scalar_is_zero(e);
 }
 
+/**
+ * Compute the weight a_i of the i-th signature in a batch verification,
+ * i.e. Hash(seed || i) mod n. The first weight is always 1 as randomizing all
+ * but one of the signatures is enough.
+ */
+static void secp256k1_schnorr_batch_randomizer(
+    secp256k1_scalar *a,
+    const unsigned char *seed32,
+    size_t i
+) {
+    secp256k1_sha256 sha;
+    unsigned char buf[32];
+    int j;
+
+    if (i == 0) {
+        secp256k1_scalar_set_int(a, 1);
+        return;
+    }
+
+    for (j = 0; j < 8; j++) {
+        buf[j] = (i >> (8 * j)) & 0xff;
+    }
+
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, seed32, 32);
+    secp256k1_sha256_write(&sha, buf, 8);
+    secp256k1_sha256_finalize(&sha, buf);
+    secp256k1_scalar_set_b32(a, buf, NULL);
+}
+
 static int secp256k1_schnorr_sig_sign(
     const secp256k1_context* ctx,
     unsigned char *sig64,
@@ -78,6 +78,74 @@ void test_schnorr_sign_verify(void) {
 
 #undef SIG_COUNT
 
+#define BATCH_SIZE 16
+
+void test_schnorr_verify_batch(void) {
+    unsigned char privkey[BATCH_SIZE][32];
+    unsigned char msg32[BATCH_SIZE][32];
+    unsigned char sig64[BATCH_SIZE][64];
+    secp256k1_pubkey pubkey[BATCH_SIZE];
+    const unsigned char *sigptr[BATCH_SIZE];
+    const unsigned char *msgptr[BATCH_SIZE];
+    const secp256k1_pubkey *pkptr[BATCH_SIZE];
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(ctx, 1024 * 1024);
+    int i;
+
+    for (i = 0; i < BATCH_SIZE; i++) {
+        secp256k1_scalar key;
+        random_scalar_order_test(&key);
+        secp256k1_scalar_get_b32(privkey[i], &key);
+        secp256k1_testrand256_test(msg32[i]);
+
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey[i], privkey[i]) == 1);
+        CHECK(secp256k1_schnorr_sign(ctx, sig64[i], msg32[i], privkey[i], NULL, NULL) == 1);
+
+        sigptr[i] = sig64[i];
+        msgptr[i] = msg32[i];
+        pkptr[i] = &pubkey[i];
+    }
+
+    /* Empty batches and batches of valid signatures verify, with or without
+     * scratch space. */
+    CHECK(secp256k1_schnorr_verify_batch(ctx, scratch, NULL, NULL, NULL, 0) == 1);
+    for (i = 1; i <= BATCH_SIZE; i++) {
+        CHECK(secp256k1_schnorr_verify_batch(ctx, scratch, sigptr, msgptr, pkptr, i) == 1);
+        CHECK(secp256k1_schnorr_verify_batch(ctx, NULL, sigptr, msgptr, pkptr, i) == 1);
+    }
+
+    /* A single invalid signature, message or key fails the whole batch. */
+    for (i = 0; i < count; i++) {
+        int idx = secp256k1_testrand_int(BATCH_SIZE);
+        int pos = secp256k1_testrand_bits(6);
+        int mod = 1 + secp256k1_testrand_int(255);
+        sig64[idx][pos] ^= mod;
+        CHECK(secp256k1_schnorr_verify_batch(ctx, scratch, sigptr, msgptr, pkptr, BATCH_SIZE) == 0);
+        sig64[idx][pos] ^= mod;
+
+        msg32[idx][pos % 32] ^= mod;
+        CHECK(secp256k1_schnorr_verify_batch(ctx, scratch, sigptr, msgptr, pkptr, BATCH_SIZE) == 0);
+        msg32[idx][pos % 32] ^= mod;
+
+        pkptr[idx] = &pubkey[(idx + 1) % BATCH_SIZE];
+        CHECK(secp256k1_schnorr_verify_batch(ctx, scratch, sigptr, msgptr, pkptr, BATCH_SIZE) == 0);
+        pkptr[idx] = &pubkey[idx];
+    }
+
+    /* Two invalid signatures cannot cancel each other out by swapping their
+     * s values. */
+    {
+        unsigned char tmp[32];
+        memcpy(tmp, sig64[0] + 32, 32);
+        memcpy(sig64[0] + 32, sig64[1] + 32, 32);
+        memcpy(sig64[1] + 32, tmp, 32);
+        CHECK(secp256k1_schnorr_verify_batch(ctx, scratch, sigptr, msgptr, pkptr, BATCH_SIZE) == 0);
+    }
+
+    secp256k1_scratch_space_destroy(ctx, scratch);
+}
+
+#undef BATCH_SIZE
+
 void run_schnorr_compact_test(void) {
     {
         /* Test vector 1 */
@@ -516,6 +584,7 @@ void run_schnorr_tests(void) {
     }
 
     test_schnorr_sign_verify();
+    test_schnorr_verify_batch();
     run_schnorr_compact_test();
 }
 
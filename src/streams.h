@@ -281,6 +281,7 @@ public:
     bool empty() const { return vch.size() == nReadPos; }
     void resize(size_type n, value_type c = 0) { vch.resize(n + nReadPos, c); }
     void reserve(size_type n) { vch.reserve(n + nReadPos); }
+    size_type capacity() const { return vch.capacity(); }
     const_reference operator[](size_type pos) const {
         return vch[pos + nReadPos];
     }
@@ -0,0 +1,137 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SUPPORT_ALLOCATORS_POOL_H
+#define BITCOIN_SUPPORT_ALLOCATORS_POOL_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * Pool of fixed size memory blocks, allocated from the system in chunks.
+ *
+ * Freed blocks are kept in a free list and handed out again by the next
+ * allocations; chunks are only returned to the system all at once by
+ * Release(). This avoids a malloc/free pair per block and the heap
+ * fragmentation that comes with millions of small long-lived allocations,
+ * and makes freeing a whole container a handful of calls to free.
+ *
+ * Chunk sizes grow geometrically from MIN_CHUNK_BLOCKS up to
+ * MAX_CHUNK_BLOCKS so that small pools stay small.
+ */
+template <size_t BLOCK_SIZE, size_t BLOCK_ALIGN> class PoolResource {
+public:
+    static constexpr size_t MIN_CHUNK_BLOCKS = 16;
+    static constexpr size_t MAX_CHUNK_BLOCKS = 4096;
+
+private:
+    /** One block of storage, reused as a free list link when unused. */
+    union Block {
+        Block *next_free;
+        alignas(BLOCK_ALIGN) unsigned char storage[BLOCK_SIZE];
+    };
+
+    struct Chunk {
+        std::unique_ptr<Block[]> blocks;
+        size_t size;
+    };
+
+    std::vector<Chunk> m_chunks;
+    /** Number of blocks handed out from the last chunk. */
+    size_t m_chunk_used{0};
+    Block *m_free_list{nullptr};
+    /** Number of blocks currently allocated. */
+    size_t m_allocated{0};
+
+public:
+    PoolResource() = default;
+    PoolResource(const PoolResource &) = delete;
+    PoolResource &operator=(const PoolResource &) = delete;
+    PoolResource(PoolResource &&other) noexcept { swap(other); }
+    PoolResource &operator=(PoolResource &&other) noexcept {
+        if (this != &other) {
+            Release();
+            swap(other);
+        }
+        return *this;
+    }
+
+    void swap(PoolResource &other) noexcept {
+        using std::swap;
+        swap(m_chunks, other.m_chunks);
+        swap(m_chunk_used, other.m_chunk_used);
+        swap(m_free_list, other.m_free_list);
+        swap(m_allocated, other.m_allocated);
+    }
+
+    /** Return uninitialized storage for one block. */
+    void *Allocate() {
+        Block *block;
+        if (m_free_list) {
+            block = m_free_list;
+            m_free_list = block->next_free;
+        } else {
+            if (m_chunks.empty() || m_chunk_used == m_chunks.back().size) {
+                AddChunk();
+            }
+            block = &m_chunks.back().blocks[m_chunk_used++];
+        }
+        ++m_allocated;
+        return block->storage;
+    }
+
+    /** Give back a block obtained from Allocate(). */
+    void Deallocate(void *p) {
+        assert(m_allocated > 0);
+        Block *block = reinterpret_cast<Block *>(p);
+        block->next_free = m_free_list;
+        m_free_list = block;
+        --m_allocated;
+    }
+
+    /**
+     * Return all the chunks to the system. Outstanding blocks become invalid,
+     * so this may only be called once their contents have been destroyed.
+     */
+    void Release() {
+        std::vector<Chunk>().swap(m_chunks);
+        m_chunk_used = 0;
+        m_free_list = nullptr;
+        m_allocated = 0;
+    }
+
+    size_t NumAllocated() const { return m_allocated; }
+    size_t NumChunks() const { return m_chunks.size(); }
+
+    /**
+     * Heap memory used by the pool, as the sum of malloc_usage() over the
+     * size of every allocation it made from the system.
+     */
+    template <typename MallocUsage>
+    size_t DynamicUsage(MallocUsage malloc_usage) const {
+        size_t usage = 0;
+        for (const Chunk &chunk : m_chunks) {
+            usage += malloc_usage(chunk.size * sizeof(Block));
+        }
+        if (m_chunks.capacity() > 0) {
+            usage += malloc_usage(m_chunks.capacity() * sizeof(Chunk));
+        }
+        return usage;
+    }
+
+private:
+    void AddChunk() {
+        const size_t size =
+            m_chunks.empty()
+                ? MIN_CHUNK_BLOCKS
+                : std::min(2 * m_chunks.back().size, MAX_CHUNK_BLOCKS);
+        m_chunks.push_back({std::unique_ptr<Block[]>(new Block[size]), size});
+        m_chunk_used = 0;
+    }
+};
+
+#endif // BITCOIN_SUPPORT_ALLOCATORS_POOL_H
@@ -361,6 +361,86 @@ BOOST_AUTO_TEST_CASE(EmptyBlockRoundTripTest) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(LargeMempoolRoundTripTest) {
+    CTxMemPool pool;
+    TestMemPoolEntryHelper entry;
+
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].scriptSig.resize(10);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 42 * SATOSHI;
+
+    CBlock block;
+    block.vtx.push_back(MakeTransactionRef(tx));
+    block.nVersion = 42;
+    block.hashPrevBlock = BlockHash(InsecureRand256());
+    block.nBits = 0x207fffff;
+
+    LOCK2(cs_main, pool.cs);
+
+    // More transactions than the short ids computed at once, half of them in
+    // the block.
+    std::vector<CTransactionRef> txs;
+    for (int i = 0; i < 4 * int(SIPHASH_LANES) + 3; ++i) {
+        tx.vin[0].prevout = InsecureRandOutPoint();
+        txs.push_back(MakeTransactionRef(tx));
+        pool.addUnchecked(entry.FromTx(txs.back()));
+        if (i % 2) {
+            block.vtx.push_back(txs.back());
+        }
+    }
+
+    // Removing a transaction keeps the mempool hashes consistent.
+    pool.removeRecursive(*txs.front(), MemPoolRemovalReason::REPLACED);
+    BOOST_CHECK_EQUAL(pool.vTxHashes.size(), pool.size());
+    for (size_t i = 0; i < pool.vTxHashes.size(); ++i) {
+        const auto &[txhash, it] = pool.vTxHashes[i];
+        BOOST_CHECK(it->GetTx().GetHash() == txhash);
+        BOOST_CHECK_EQUAL(it->vTxHashesIdx, i);
+    }
+
+    bool mutated;
+    block.hashMerkleRoot = BlockMerkleRoot(block, &mutated);
+    assert(!mutated);
+    const Consensus::Params &params =
+        GetConfig().GetChainParams().GetConsensus();
+    while (!CheckProofOfWork(block.GetHash(), block.nBits, params)) {
+        ++block.nNonce;
+    }
+
+    CBlockHeaderAndShortTxIDs shortIDs(block);
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << shortIDs;
+    CBlockHeaderAndShortTxIDs shortIDs2;
+    stream >> shortIDs2;
+
+    // The short ids computed at once match the ones computed one by one.
+    std::array<const TxHash *, SIPHASH_LANES> txhashes;
+    for (size_t lane = 0; lane < SIPHASH_LANES; ++lane) {
+        txhashes[lane] = &pool.vTxHashes[lane].first;
+    }
+    const std::array<uint64_t, SIPHASH_LANES> shortids =
+        shortIDs2.GetShortIDs(txhashes);
+    for (size_t lane = 0; lane < SIPHASH_LANES; ++lane) {
+        BOOST_CHECK_EQUAL(shortids[lane],
+                          shortIDs2.GetShortID(*txhashes[lane]));
+    }
+
+    PartiallyDownloadedBlock partialBlock(GetConfig(), &pool);
+    BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        BOOST_CHECK(partialBlock.IsTxAvailable(i));
+    }
+
+    CBlock block2;
+    BOOST_CHECK(partialBlock.FillBlock(block2, {}) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(block.GetHash().ToString(), block2.GetHash().ToString());
+    BOOST_CHECK_EQUAL(block.hashMerkleRoot.ToString(),
+                      BlockMerkleRoot(block2, &mutated).ToString());
+    BOOST_CHECK(!mutated);
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = BlockHash(InsecureRand256());
@@ -3,8 +3,10 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <clientversion.h>
 #include <config.h>
 #include <node/blockstorage.h>
+#include <streams.h>
 #include <undo.h>
 #include <validation.h>
 
@@ -93,4 +95,68 @@ BOOST_AUTO_TEST_CASE(read_tx_data_from_disk_bad) {
     BOOST_CHECK(!node::ReadTxUndoFromDisk(txundo, FlatFilePos(0, 0x7fffffff)));
 }
 
+BOOST_AUTO_TEST_CASE(read_raw_block_from_disk) {
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+    const CChainParams &params = GetConfig().GetChainParams();
+
+    for (int32_t height = 0; height <= 100; height += 10) {
+        const CBlockIndex *pindex = chainman.ActiveTip()->GetAncestor(height);
+        CBlock block;
+        BOOST_CHECK(
+            node::ReadBlockFromDisk(block, pindex, params.GetConsensus()));
+
+        // The raw block is the serialized block.
+        std::vector<uint8_t> raw_block;
+        BOOST_CHECK(
+            node::ReadRawBlockFromDisk(raw_block, pindex, params.DiskMagic()));
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << block;
+        BOOST_CHECK(raw_block == std::vector<uint8_t>(UCharCast(ss.data()),
+                                                      UCharCast(ss.data()) +
+                                                          ss.size()));
+
+        // The disk magic is checked.
+        CMessageHeader::MessageMagic bad_magic = params.DiskMagic();
+        bad_magic[0] ^= 0xff;
+        BOOST_CHECK(!node::ReadRawBlockFromDisk(
+            raw_block, WITH_LOCK(cs_main, return pindex->GetBlockPos()),
+            bad_magic));
+    }
+
+    // The block read must match the index.
+    std::vector<uint8_t> raw_block;
+    const CBlockIndex *tip = chainman.ActiveTip();
+    const BlockHash other_hash = tip->pprev->GetBlockHash();
+    CBlockIndex index;
+    index.phashBlock = &other_hash;
+    {
+        LOCK(cs_main);
+        index.nFile = tip->nFile;
+        index.nDataPos = tip->nDataPos;
+        index.nStatus = tip->nStatus;
+    }
+    BOOST_CHECK(
+        !node::ReadRawBlockFromDisk(raw_block, &index, params.DiskMagic()));
+
+    BOOST_CHECK(!node::ReadRawBlockFromDisk(
+        raw_block, FlatFilePos(0x7fffffff, 8), params.DiskMagic()));
+    BOOST_CHECK(!node::ReadRawBlockFromDisk(
+        raw_block, FlatFilePos(0, 0x7fffffff), params.DiskMagic()));
+    BOOST_CHECK(!node::ReadRawBlockFromDisk(raw_block, FlatFilePos(0, 0),
+                                            params.DiskMagic()));
+
+    // The size stored in front of the block is not trusted.
+    const FlatFilePos corrupt_pos(0x7ffffffe, node::STORAGE_HEADER_BYTES);
+    {
+        CAutoFile fileout(
+            node::OpenBlockFile(FlatFilePos(corrupt_pos.nFile, 0)), SER_DISK,
+            CLIENT_VERSION);
+        BOOST_REQUIRE(!fileout.IsNull());
+        fileout << params.DiskMagic()
+                << uint32_t(GetConfig().GetMaxBlockSize() + 1);
+    }
+    BOOST_CHECK(!node::ReadRawBlockFromDisk(raw_block, corrupt_pos,
+                                            params.DiskMagic()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -140,19 +140,26 @@ typedef CCheckQueue<FailingCheck> Failing_Queue;
 typedef CCheckQueue<UniqueCheck> Unique_Queue;
 typedef CCheckQueue<MemoryCheck> Memory_Queue;
 typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
+typedef WorkStealingCheckQueue<FakeCheckCheckCompletion>
+    WorkStealing_Correct_Queue;
+typedef WorkStealingCheckQueue<FailingCheck> WorkStealing_Failing_Queue;
+typedef WorkStealingCheckQueue<UniqueCheck> WorkStealing_Unique_Queue;
+typedef WorkStealingCheckQueue<MemoryCheck> WorkStealing_Memory_Queue;
 
 /** This test case checks that the CCheckQueue works properly
  * with each specified size_t Checks pushed.
  */
+template <typename Queue = Correct_Queue>
 static void Correct_Queue_range(std::vector<size_t> range) {
-    auto small_queue = std::make_unique<Correct_Queue>(QUEUE_BATCH_SIZE);
+    auto small_queue = std::make_unique<Queue>(QUEUE_BATCH_SIZE);
     small_queue->StartWorkerThreads(SCRIPT_CHECK_THREADS);
     // Make vChecks here to save on malloc (this test can be slow...)
     std::vector<FakeCheckCheckCompletion> vChecks;
     for (const size_t i : range) {
         size_t total = i;
         FakeCheckCheckCompletion::n_calls = 0;
-        CCheckQueueControl<FakeCheckCheckCompletion> control(small_queue.get());
+        CCheckQueueControl<FakeCheckCheckCompletion, Queue> control(
+            small_queue.get());
         while (total) {
             vChecks.resize(std::min(total, (size_t)InsecureRandRange(10)));
             total -= vChecks.size();
@@ -201,12 +208,12 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_Correct_Random) {
 }
 
 /** Test that failing checks are caught */
-BOOST_AUTO_TEST_CASE(test_CheckQueue_Catches_Failure) {
-    auto fail_queue = std::make_unique<Failing_Queue>(QUEUE_BATCH_SIZE);
+template <typename Queue> static void Catches_Failure() {
+    auto fail_queue = std::make_unique<Queue>(QUEUE_BATCH_SIZE);
     fail_queue->StartWorkerThreads(SCRIPT_CHECK_THREADS);
 
     for (size_t i = 0; i < 1001; ++i) {
-        CCheckQueueControl<FailingCheck> control(fail_queue.get());
+        CCheckQueueControl<FailingCheck, Queue> control(fail_queue.get());
         size_t remaining = i;
         while (remaining) {
             size_t r = InsecureRandRange(10);
@@ -227,6 +234,9 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_Catches_Failure) {
     }
     fail_queue->StopWorkerThreads();
 }
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Catches_Failure) {
+    Catches_Failure<Failing_Queue>();
+}
 // Test that a block validation which fails does not interfere with
 // future blocks, ie, the bad state is cleared.
 BOOST_AUTO_TEST_CASE(test_CheckQueue_Recovers_From_Failure) {
@@ -252,14 +262,14 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_Recovers_From_Failure) {
 // Test that unique checks are actually all called individually, rather than
 // just one check being called repeatedly. Test that checks are not called
 // more than once as well
-BOOST_AUTO_TEST_CASE(test_CheckQueue_UniqueCheck) {
-    auto queue = std::make_unique<Unique_Queue>(QUEUE_BATCH_SIZE);
+template <typename Queue> static void Unique_Checks() {
+    auto queue = std::make_unique<Queue>(QUEUE_BATCH_SIZE);
     queue->StartWorkerThreads(SCRIPT_CHECK_THREADS);
 
     size_t COUNT = 100000;
     size_t total = COUNT;
     {
-        CCheckQueueControl<UniqueCheck> control(queue.get());
+        CCheckQueueControl<UniqueCheck, Queue> control(queue.get());
         while (total) {
             size_t r = InsecureRandRange(10);
             std::vector<UniqueCheck> vChecks;
@@ -277,9 +287,13 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_UniqueCheck) {
             r = r && UniqueCheck::results.count(i) == 1;
         }
         BOOST_REQUIRE(r);
+        UniqueCheck::results.clear();
     }
     queue->StopWorkerThreads();
 }
+BOOST_AUTO_TEST_CASE(test_CheckQueue_UniqueCheck) {
+    Unique_Checks<Unique_Queue>();
+}
 
 // Test that blocks which might allocate lots of memory free their memory
 // aggressively.
@@ -287,13 +301,13 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_UniqueCheck) {
 // This test attempts to catch a pathological case where by lazily freeing
 // checks might mean leaving a check un-swapped out, and decreasing by 1 each
 // time could leave the data hanging across a sequence of blocks.
-BOOST_AUTO_TEST_CASE(test_CheckQueue_Memory) {
-    auto queue = std::make_unique<Memory_Queue>(QUEUE_BATCH_SIZE);
+template <typename Queue> static void Memory_Freed() {
+    auto queue = std::make_unique<Queue>(QUEUE_BATCH_SIZE);
     queue->StartWorkerThreads(SCRIPT_CHECK_THREADS);
     for (size_t i = 0; i < 1000; ++i) {
         size_t total = i;
         {
-            CCheckQueueControl<MemoryCheck> control(queue.get());
+            CCheckQueueControl<MemoryCheck, Queue> control(queue.get());
             while (total) {
                 size_t r = InsecureRandRange(10);
                 std::vector<MemoryCheck> vChecks;
@@ -311,6 +325,9 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_Memory) {
     }
     queue->StopWorkerThreads();
 }
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Memory) {
+    Memory_Freed<Memory_Queue>();
+}
 
 // Test that a new verification cannot occur until all checks
 // have been destructed
@@ -354,6 +371,41 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_FrozenCleanup) {
     queue->StopWorkerThreads();
 }
 
+/** Test the work stealing variant */
+BOOST_AUTO_TEST_CASE(test_WorkStealingCheckQueue_Correct_Random) {
+    std::vector<size_t> range{0, 1, 100000};
+    for (size_t i = 2; i < 100000;
+         i += std::max((size_t)1, (size_t)InsecureRandRange(std::min(
+                                      (size_t)1000, ((size_t)100000) - i)))) {
+        range.push_back(i);
+    }
+    Correct_Queue_range<WorkStealing_Correct_Queue>(range);
+}
+BOOST_AUTO_TEST_CASE(test_WorkStealingCheckQueue_Catches_Failure) {
+    Catches_Failure<WorkStealing_Failing_Queue>();
+}
+BOOST_AUTO_TEST_CASE(test_WorkStealingCheckQueue_UniqueCheck) {
+    Unique_Checks<WorkStealing_Unique_Queue>();
+}
+BOOST_AUTO_TEST_CASE(test_WorkStealingCheckQueue_Memory) {
+    Memory_Freed<WorkStealing_Memory_Queue>();
+}
+/** Test that the work stealing variant works without worker threads */
+BOOST_AUTO_TEST_CASE(test_WorkStealingCheckQueue_No_Threads) {
+    WorkStealing_Correct_Queue queue{QUEUE_BATCH_SIZE};
+    FakeCheckCheckCompletion::n_calls = 0;
+    {
+        CCheckQueueControl<FakeCheckCheckCompletion, WorkStealing_Correct_Queue>
+            control(&queue);
+        for (size_t i = 0; i < 100; ++i) {
+            std::vector<FakeCheckCheckCompletion> vChecks(i);
+            control.Add(vChecks);
+        }
+        BOOST_REQUIRE(control.Wait());
+    }
+    BOOST_REQUIRE_EQUAL(FakeCheckCheckCompletion::n_calls, 99U * 100U / 2U);
+}
+
 /** Test that CCheckQueueControl is threadsafe */
 BOOST_AUTO_TEST_CASE(test_CheckQueueControl_Locks) {
     auto queue = std::make_unique<Standard_Queue>(QUEUE_BATCH_SIZE);
@@ -288,6 +288,52 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test) {
     CCoinsViewDB db_base{"test", /*nCacheSize*/ 1 << 23, /*fMemory*/ true,
                          /*fWipe*/ false};
     SimulationTest(&db_base, true);
+
+    CCoinsViewDB flushed_db{"test", /*nCacheSize*/ 1 << 23, /*fMemory*/ true,
+                            /*fWipe*/ false};
+    CCoinsViewBackgroundFlush flush_base{&flushed_db, flushed_db};
+    flush_base.SetBackground(true);
+    SimulationTest(&flush_base, true);
+    BOOST_CHECK(flush_base.WaitForFlush());
+}
+
+BOOST_AUTO_TEST_CASE(coins_background_flush) {
+    CCoinsViewDB db{"test", /*nCacheSize*/ 1 << 23, /*fMemory*/ true,
+                    /*fWipe*/ false};
+    CCoinsViewBackgroundFlush flush_view{&db, db};
+    CCoinsViewCache cache{&flush_view};
+
+    const COutPoint outpoint{TxId(InsecureRand256()), 0};
+    const Coin coin{CTxOut(50 * COIN, CScript() << OP_TRUE), 1, false};
+    const BlockHash best_block{InsecureRand256()};
+    cache.AddCoin(outpoint, Coin(coin), false);
+    cache.SetBestBlock(best_block);
+
+    // The flush returns before the coin is written, but the coin and the best
+    // block are visible through the view in the meantime.
+    const size_t cache_usage = cache.DynamicMemoryUsage();
+    flush_view.SetBackground(true, cache_usage);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+    BOOST_CHECK(cache.HaveCoin(outpoint));
+    BOOST_CHECK(cache.AccessCoin(outpoint) == coin);
+    BOOST_CHECK(cache.GetBestBlock() == best_block);
+
+    // The flushed coins no longer count towards the cache size once written.
+    BOOST_CHECK(flush_view.WaitForFlush());
+    BOOST_CHECK(!flush_view.HasFailed());
+    BOOST_CHECK_EQUAL(flush_view.DynamicMemoryUsage(), 0U);
+    Coin db_coin;
+    BOOST_CHECK(db.GetCoin(outpoint, db_coin));
+    BOOST_CHECK(db_coin == coin);
+    BOOST_CHECK(db.GetBestBlock() == best_block);
+
+    // Spending the coin is written synchronously when not in background mode.
+    cache.SpendCoin(outpoint);
+    flush_view.SetBackground(false);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(!db.HaveCoin(outpoint));
+    BOOST_CHECK(!cache.HaveCoin(outpoint));
 }
 
 // Store of all necessary tx and undo data for next test
@@ -720,6 +766,41 @@ BOOST_AUTO_TEST_CASE(coin_access) {
     CheckAccessCoin(VALUE1, VALUE2, VALUE2, DIRTY | FRESH, DIRTY | FRESH);
 }
 
+static void CheckInsertFetchedCoin(const Amount cache_value,
+                                   const Amount expected_value,
+                                   char cache_flags, char expected_flags) {
+    SingleEntryCacheTest test(VALUE1, cache_value, cache_flags);
+    Coin coin;
+    BOOST_CHECK(test.base.GetCoin(OUTPOINT, coin));
+    test.cache.InsertFetchedCoin(OUTPOINT, std::move(coin));
+    test.cache.SelfTest();
+
+    Amount result_value;
+    char result_flags;
+    GetCoinMapEntry(test.cache.map(), result_value, result_flags);
+    BOOST_CHECK_EQUAL(result_value, expected_value);
+    BOOST_CHECK_EQUAL(result_flags, expected_flags);
+}
+
+BOOST_AUTO_TEST_CASE(coin_insert_fetched) {
+    /* Check InsertFetchedCoin behavior, inserting a coin retrieved from the
+     * base view into the cache, and checking the resulting entry in the cache
+     * is the same as the one AccessCoin would have produced.
+     *
+     *                      Cache   Result  Cache        Result
+     *                      Value   Value   Flags        Flags
+     */
+    CheckInsertFetchedCoin(ABSENT, VALUE1, NO_ENTRY, 0);
+    CheckInsertFetchedCoin(SPENT, SPENT, 0, 0);
+    CheckInsertFetchedCoin(SPENT, SPENT, FRESH, FRESH);
+    CheckInsertFetchedCoin(SPENT, SPENT, DIRTY, DIRTY);
+    CheckInsertFetchedCoin(SPENT, SPENT, DIRTY | FRESH, DIRTY | FRESH);
+    CheckInsertFetchedCoin(VALUE2, VALUE2, 0, 0);
+    CheckInsertFetchedCoin(VALUE2, VALUE2, FRESH, FRESH);
+    CheckInsertFetchedCoin(VALUE2, VALUE2, DIRTY, DIRTY);
+    CheckInsertFetchedCoin(VALUE2, VALUE2, DIRTY | FRESH, DIRTY | FRESH);
+}
+
 static void CheckSpendCoin(Amount base_value, Amount cache_value,
                            Amount expected_value, char cache_flags,
                            char expected_flags) {
@@ -0,0 +1,92 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/coinsprefetch.h>
+
+#include <chainparams.h>
+#include <config.h>
+#include <txdb.h>
+#include <validation.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+using node::CoinsPrefetcher;
+
+BOOST_AUTO_TEST_SUITE(coinsprefetch_tests)
+
+BOOST_FIXTURE_TEST_CASE(coins_prefetch, TestChain100Setup) {
+    Chainstate &chainstate = Assert(m_node.chainman)->ActiveChainstate();
+    chainstate.ForceFlushStateToDisk();
+
+    // A block spending a coin from the database and a missing coin.
+    const COutPoint spent{m_coinbase_txns[0]->GetId(), 0};
+    const COutPoint missing{TxId(InsecureRand256()), 0};
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(spent);
+    mtx.vin.emplace_back(missing);
+    mtx.vout.emplace_back(COIN, CScript() << OP_TRUE);
+    const CBlock block = CreateBlock({mtx}, CScript() << OP_TRUE, chainstate);
+
+    CCoinsViewDB *db;
+    FlatFilePos pos;
+    {
+        LOCK(cs_main);
+        db = &chainstate.CoinsDB();
+        pos = chainstate.m_blockman.SaveBlockToDisk(
+            block, chainstate.m_chain.Height() + 1, chainstate.m_chain,
+            Params(), nullptr);
+    }
+    BOOST_REQUIRE(!pos.IsNull());
+
+    CCoinsViewBackgroundFlush flush_view{db, *db};
+    CCoinsViewCache cache{&flush_view};
+    CoinsPrefetcher prefetcher{flush_view, Params().GetConsensus()};
+    const uint64_t max_block_size = GetConfig().GetMaxBlockSize();
+
+    // The block is read and checked ahead of time.
+    prefetcher.Prefetch({{block.GetHash(), pos}}, max_block_size);
+    prefetcher.WaitForIdle();
+    const std::shared_ptr<const CBlock> prefetched_block =
+        prefetcher.TakeBlock(block.GetHash());
+    BOOST_REQUIRE(prefetched_block);
+    BOOST_CHECK(prefetched_block->GetHash() == block.GetHash());
+    BOOST_CHECK(prefetched_block->fChecked);
+    BOOST_CHECK(!prefetcher.TakeBlock(block.GetHash()));
+
+    // Only the coin found in the database is prefetched.
+    BOOST_CHECK_EQUAL(prefetcher.TakeCoins(block.GetHash(), cache), 1U);
+    BOOST_CHECK(cache.HaveCoinInCache(spent));
+    BOOST_CHECK(!cache.HaveCoinInCache(missing));
+    BOOST_CHECK(cache.AccessCoin(spent).GetTxOut() ==
+                m_coinbase_txns[0]->vout[0]);
+
+    // The coins are only taken once.
+    BOOST_CHECK_EQUAL(prefetcher.TakeCoins(block.GetHash(), cache), 0U);
+
+    // Coins already in the cache are not overwritten.
+    cache.SpendCoin(spent);
+    prefetcher.Prefetch({{block.GetHash(), pos}}, max_block_size);
+    prefetcher.WaitForIdle();
+    BOOST_CHECK_EQUAL(prefetcher.TakeCoins(block.GetHash(), cache), 0U);
+    BOOST_CHECK(!cache.HaveCoin(spent));
+
+    // Coins read before a write to the view are dropped.
+    CCoinsViewCache fresh_cache{&flush_view};
+    prefetcher.Prefetch({{block.GetHash(), pos}}, max_block_size);
+    prefetcher.WaitForIdle();
+    CCoinsMap empty_map;
+    BOOST_CHECK(flush_view.BatchWrite(empty_map, db->GetBestBlock()));
+    BOOST_CHECK_EQUAL(prefetcher.TakeCoins(block.GetHash(), fresh_cache), 0U);
+    BOOST_CHECK(!fresh_cache.HaveCoinInCache(spent));
+
+    // Blocks that are not upcoming anymore are dropped.
+    prefetcher.Prefetch({{block.GetHash(), pos}}, max_block_size);
+    prefetcher.WaitForIdle();
+    prefetcher.Prefetch({}, max_block_size);
+    BOOST_CHECK_EQUAL(prefetcher.TakeCoins(block.GetHash(), fresh_cache), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
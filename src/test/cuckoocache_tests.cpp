@@ -8,6 +8,7 @@
 #include <script/sigcache.h>
 
 #include <deque>
+#include <set>
 
 #include <test/util/setup_common.h>
 
@@ -530,4 +531,28 @@ BOOST_AUTO_TEST_CASE(cuckoocache_map) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(cuckoocache_for_each) {
+    SeedInsecureRand(SeedRand::ZEROS);
+
+    CuckooCacheSet cc{};
+    cc.setup_bytes(4 << 20);
+    std::set<uint256> inserted;
+    for (int x = 0; x < 1000; ++x) {
+        const uint256 k = InsecureRand256();
+        cc.insert(k);
+        inserted.insert(k);
+    }
+
+    // Erased elements are skipped.
+    const uint256 erased = *inserted.begin();
+    BOOST_CHECK(cc.contains(erased, true));
+    inserted.erase(erased);
+
+    std::set<uint256> visited;
+    cc.for_each([&](const CuckooCache::KeyOnly<uint256> &e) {
+        BOOST_CHECK(visited.insert(e.getKey()).second);
+    });
+    BOOST_CHECK(visited == inserted);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
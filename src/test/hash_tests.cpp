@@ -156,6 +156,23 @@ BOOST_AUTO_TEST_CASE(siphash) {
         BOOST_CHECK_EQUAL(SipHashUint256(k1, k2, x), sip256.Finalize());
         BOOST_CHECK_EQUAL(SipHashUint256Extra(k1, k2, x, n), sip288.Finalize());
     }
+
+    // Check consistency between SipHashUint256 and SipHashUint256Lanes.
+    for (int i = 0; i < 16; ++i) {
+        uint64_t k1 = ctx.rand64();
+        uint64_t k2 = ctx.rand64();
+        std::array<uint256, SIPHASH_LANES> vals;
+        std::array<const uint256 *, SIPHASH_LANES> val_ptrs;
+        for (size_t lane = 0; lane < SIPHASH_LANES; ++lane) {
+            vals[lane] = InsecureRand256();
+            val_ptrs[lane] = &vals[lane];
+        }
+        std::array<uint64_t, SIPHASH_LANES> hashes;
+        SipHashUint256Lanes(k1, k2, val_ptrs, hashes);
+        for (size_t lane = 0; lane < SIPHASH_LANES; ++lane) {
+            BOOST_CHECK_EQUAL(hashes[lane], SipHashUint256(k1, k2, vals[lane]));
+        }
+    }
 }
 
 namespace {
@@ -405,6 +405,48 @@ BOOST_AUTO_TEST_CASE(key_key_negation) {
     BOOST_CHECK(key.GetPubKey().data()[0] == 0x03);
 }
 
+BOOST_AUTO_TEST_CASE(schnorr_batch_verify) {
+    std::vector<CKey> keys(16);
+    std::vector<uint256> hashes(keys.size());
+    std::vector<std::vector<uint8_t>> sigs(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        keys[i].MakeNewKey(i % 2);
+        hashes[i] = InsecureRand256();
+        BOOST_CHECK(keys[i].SignSchnorr(hashes[i], sigs[i]));
+    }
+
+    // An empty batch is valid.
+    SchnorrBatchVerifier batch;
+    BOOST_CHECK(batch.empty());
+    BOOST_CHECK(batch.Verify());
+
+    // Batches of valid signatures are valid.
+    for (size_t i = 0; i < keys.size(); i++) {
+        BOOST_CHECK(batch.Add(keys[i].GetPubKey(), hashes[i], sigs[i]));
+        BOOST_CHECK_EQUAL(batch.size(), i + 1);
+        BOOST_CHECK(batch.Verify());
+    }
+
+    // A single invalid signature invalidates the whole batch.
+    for (size_t i = 0; i < keys.size(); i++) {
+        batch.clear();
+        for (size_t j = 0; j < keys.size(); j++) {
+            const uint256 &hash = i == j ? hashes[(j + 1) % keys.size()]
+                                         : hashes[j];
+            BOOST_CHECK(batch.Add(keys[j].GetPubKey(), hash, sigs[j]));
+        }
+        BOOST_CHECK(!batch.Verify());
+    }
+
+    // Signatures that are known invalid upfront are not queued.
+    batch.clear();
+    BOOST_CHECK(!batch.Add(CPubKey(), hashes[0], sigs[0]));
+    std::vector<uint8_t> ecdsa_sig;
+    BOOST_CHECK(keys[0].SignECDSA(hashes[0], ecdsa_sig));
+    BOOST_CHECK(!batch.Add(keys[0].GetPubKey(), hashes[0], ecdsa_sig));
+    BOOST_CHECK(batch.empty());
+}
+
 static CPubKey UnserializePubkey(const std::vector<uint8_t> &data) {
     CDataStream stream{SER_NETWORK, INIT_PROTO_VERSION};
     stream << data;
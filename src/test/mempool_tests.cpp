@@ -4,6 +4,7 @@
 
 #include <txmempool.h>
 
+#include <coins.h>
 #include <policy/settings.h>
 #include <reverse_iterator.h>
 #include <util/system.h>
@@ -311,6 +312,192 @@ BOOST_AUTO_TEST_CASE(MempoolRemoveTest) {
     BOOST_CHECK_EQUAL(testPool.size(), 0UL);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolRemoveForBlockTest) {
+    // Test CTxMemPool::removeForBlock functionality
+
+    TestMemPoolEntryHelper entry;
+    // Parent transaction with three children, and three grand-children:
+    CMutableTransaction txParent;
+    txParent.vin.resize(1);
+    txParent.vin[0].prevout = COutPoint(TxId(InsecureRand256()), 0);
+    txParent.vin[0].scriptSig = CScript() << OP_11;
+    txParent.vout.resize(3);
+    for (int i = 0; i < 3; i++) {
+        txParent.vout[i].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+        txParent.vout[i].nValue = 33000 * SATOSHI;
+    }
+    CMutableTransaction txChild[3];
+    CMutableTransaction txGrandChild[3];
+    for (int i = 0; i < 3; i++) {
+        txChild[i].vin.resize(1);
+        txChild[i].vin[0].scriptSig = CScript() << OP_11;
+        txChild[i].vin[0].prevout = COutPoint(txParent.GetId(), i);
+        txChild[i].vout.resize(1);
+        txChild[i].vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+        txChild[i].vout[0].nValue = 11000 * SATOSHI;
+
+        txGrandChild[i].vin.resize(1);
+        txGrandChild[i].vin[0].scriptSig = CScript() << OP_11;
+        txGrandChild[i].vin[0].prevout = COutPoint(txChild[i].GetId(), 0);
+        txGrandChild[i].vout.resize(1);
+        txGrandChild[i].vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+        txGrandChild[i].vout[0].nValue = 11000 * SATOSHI;
+    }
+    // A transaction conflicting with a block transaction:
+    CMutableTransaction txBlockSpend;
+    txBlockSpend.vin.resize(1);
+    txBlockSpend.vin[0].prevout = COutPoint(TxId(InsecureRand256()), 0);
+    txBlockSpend.vin[0].scriptSig = CScript() << OP_12;
+    txBlockSpend.vout.resize(1);
+    txBlockSpend.vout[0].scriptPubKey = CScript() << OP_12 << OP_EQUAL;
+    txBlockSpend.vout[0].nValue = 11000 * SATOSHI;
+    CMutableTransaction txDoubleSpend = txBlockSpend;
+    txDoubleSpend.vout[0].nValue = 10000 * SATOSHI;
+
+    // The coins of the confirmed transactions, to check the mempool with.
+    CCoinsView dummy;
+    CCoinsViewCache coins(&dummy);
+    AddCoins(coins, CTransaction(txParent), 1);
+    AddCoins(coins, CTransaction(txChild[0]), 1);
+    AddCoins(coins, CTransaction(txChild[1]), 1);
+
+    for (const bool wellington : {false, true}) {
+        CTxMemPool testPool(/*check_ratio=*/1);
+        testPool.wellingtonLatched = wellington;
+        LOCK2(cs_main, testPool.cs);
+
+        testPool.addUnchecked(entry.FromTx(txParent));
+        for (int i = 0; i < 3; i++) {
+            testPool.addUnchecked(entry.FromTx(txChild[i]));
+            testPool.addUnchecked(entry.FromTx(txGrandChild[i]));
+        }
+        testPool.addUnchecked(entry.FromTx(txDoubleSpend));
+        BOOST_CHECK_EQUAL(testPool.size(), 8UL);
+
+        // The block is sorted by txid, not topologically.
+        std::vector<CTransactionRef> vtx{
+            MakeTransactionRef(txParent), MakeTransactionRef(txChild[0]),
+            MakeTransactionRef(txChild[1]), MakeTransactionRef(txBlockSpend)};
+        std::sort(vtx.begin(), vtx.end(), [](const auto &a, const auto &b) {
+            return a->GetId() < b->GetId();
+        });
+        testPool.removeForBlock(vtx);
+
+        BOOST_CHECK_EQUAL(testPool.size(), 4UL);
+        BOOST_CHECK(testPool.exists(txChild[2].GetId()));
+        for (int i = 0; i < 3; i++) {
+            BOOST_CHECK(testPool.exists(txGrandChild[i].GetId()));
+        }
+        BOOST_CHECK(!testPool.exists(txDoubleSpend.GetId()));
+
+        // The links to the confirmed transactions are gone.
+        auto child = testPool.GetIter(txChild[2].GetId()).value();
+        BOOST_CHECK(child->GetMemPoolParentsConst().empty());
+        BOOST_CHECK_EQUAL(child->GetMemPoolChildrenConst().size(), 1UL);
+        for (int i = 0; i < 2; i++) {
+            auto grandchild = testPool.GetIter(txGrandChild[i].GetId()).value();
+            BOOST_CHECK(grandchild->GetMemPoolParentsConst().empty());
+        }
+
+        if (!wellington) {
+            // The confirmed ancestors are not accounted for anymore.
+            BOOST_CHECK_EQUAL(child->GetCountWithAncestors(), 1UL);
+            BOOST_CHECK_EQUAL(child->GetSizeWithAncestors(),
+                              child->GetTxSize());
+            auto grandchild = testPool.GetIter(txGrandChild[2].GetId()).value();
+            BOOST_CHECK_EQUAL(grandchild->GetCountWithAncestors(), 2UL);
+            BOOST_CHECK_EQUAL(grandchild->GetSizeWithAncestors(),
+                              child->GetTxSize() + grandchild->GetTxSize());
+
+            // Both the parent and the grandparent of these ones are confirmed.
+            for (int i = 0; i < 2; i++) {
+                grandchild = testPool.GetIter(txGrandChild[i].GetId()).value();
+                BOOST_CHECK_EQUAL(grandchild->GetCountWithAncestors(), 1UL);
+                BOOST_CHECK_EQUAL(grandchild->GetSizeWithAncestors(),
+                                  grandchild->GetTxSize());
+                BOOST_CHECK_EQUAL(grandchild->GetModFeesWithAncestors(),
+                                  grandchild->GetModifiedFee());
+                BOOST_CHECK_EQUAL(grandchild->GetSigChecksWithAncestors(),
+                                  grandchild->GetSigChecks());
+            }
+        }
+
+        testPool.check(coins, /*spendheight=*/2);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MempoolSnapshotTest) {
+    TestMemPoolEntryHelper entry;
+    CMutableTransaction txParent;
+    txParent.vin.resize(1);
+    txParent.vin[0].scriptSig = CScript() << OP_11;
+    txParent.vout.resize(1);
+    txParent.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    txParent.vout[0].nValue = 33000 * SATOSHI;
+    CMutableTransaction txChild;
+    txChild.vin.resize(1);
+    txChild.vin[0].scriptSig = CScript() << OP_11;
+    txChild.vin[0].prevout = COutPoint(txParent.GetId(), 0);
+    txChild.vout.resize(1);
+    txChild.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    txChild.vout[0].nValue = 11000 * SATOSHI;
+
+    CTxMemPool testPool;
+    const ConstMempoolSnapshotRef empty = testPool.GetSnapshot();
+    BOOST_CHECK(empty->GetEntries().empty());
+    // The snapshot is reused as long as the mempool does not change.
+    BOOST_CHECK(testPool.GetSnapshot() == empty);
+
+    {
+        LOCK2(cs_main, testPool.cs);
+        testPool.addUnchecked(entry.Fee(1000 * SATOSHI).FromTx(txParent));
+        testPool.addUnchecked(entry.Height(7).FromTx(txChild));
+    }
+
+    const ConstMempoolSnapshotRef snapshot = testPool.GetSnapshot();
+    BOOST_CHECK(snapshot != empty);
+    BOOST_CHECK(testPool.GetSnapshot() == snapshot);
+    BOOST_CHECK_EQUAL(snapshot->GetSequence(),
+                      WITH_LOCK(testPool.cs, return testPool.GetSequence()));
+
+    // The entries are in insertion order, with their links.
+    const auto &entries = snapshot->GetEntries();
+    BOOST_REQUIRE_EQUAL(entries.size(), 2UL);
+    BOOST_CHECK(entries[0]->info.tx->GetId() == txParent.GetId());
+    BOOST_CHECK_EQUAL(entries[0]->info.fee, 1000 * SATOSHI);
+    BOOST_CHECK(entries[0]->parents.empty());
+    BOOST_REQUIRE_EQUAL(entries[0]->children.size(), 1UL);
+    BOOST_CHECK(entries[0]->children[0] == txChild.GetId());
+    BOOST_CHECK(entries[1]->info.tx->GetId() == txChild.GetId());
+    BOOST_CHECK_EQUAL(entries[1]->height, 7U);
+    BOOST_REQUIRE_EQUAL(entries[1]->parents.size(), 1UL);
+    BOOST_CHECK(entries[1]->parents[0] == txParent.GetId());
+    BOOST_CHECK(!entries[1]->unbroadcast);
+
+    // Changes to the unbroadcast set and to the fees are picked up.
+    testPool.AddUnbroadcastTx(txChild.GetId());
+    const ConstMempoolSnapshotRef unbroadcast = testPool.GetSnapshot();
+    BOOST_CHECK(unbroadcast != snapshot);
+    BOOST_CHECK(unbroadcast->GetEntries()[1]->unbroadcast);
+    // Only the entry which changed is copied again.
+    BOOST_CHECK(unbroadcast->GetEntries()[0] == entries[0]);
+    BOOST_CHECK(unbroadcast->GetEntries()[1] != entries[1]);
+    testPool.PrioritiseTransaction(txParent.GetId(), 500 * SATOSHI);
+    BOOST_CHECK_EQUAL(
+        testPool.GetSnapshot()->GetEntries()[0]->info.nFeeDelta,
+        500 * SATOSHI);
+
+    // Previous snapshots are left untouched by the removals.
+    {
+        LOCK(testPool.cs);
+        testPool.removeRecursive(CTransaction(txParent),
+                                 MemPoolRemovalReason::CONFLICT);
+    }
+    BOOST_CHECK(testPool.GetSnapshot()->GetEntries().empty());
+    BOOST_CHECK_EQUAL(snapshot->GetEntries().size(), 2UL);
+    BOOST_CHECK(entries[1]->info.tx->GetId() == txChild.GetId());
+}
+
 BOOST_AUTO_TEST_CASE(MempoolClearTest) {
     // Test CTxMemPool::clear functionality
 
@@ -22,14 +22,17 @@
 #include <util/system.h>
 #include <util/time.h>
 #include <validation.h>
+#include <validationinterface.h>
 
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
 
 #include <memory>
+#include <set>
 
 using node::BlockAssembler;
+using node::BlockTemplateBuilder;
 using node::CBlockTemplate;
 using node::CBlockTemplateEntry;
 using node::IncrementExtraNonce;
@@ -846,4 +849,70 @@ BOOST_AUTO_TEST_CASE(TestCBlockTemplateEntry) {
     BOOST_CHECK_EQUAL(txEntry.sigChecks, 10);
 }
 
+BOOST_FIXTURE_TEST_CASE(BlockTemplateBuilder_updates, TestChain100Setup) {
+    BlockTemplateBuilder builder(GetConfig(), *m_node.mempool);
+    RegisterValidationInterface(&builder);
+
+    Chainstate &chainstate = m_node.chainman->ActiveChainstate();
+    const CScript scriptPubKey = CScript()
+                                 << ToByteVector(coinbaseKey.GetPubKey())
+                                 << OP_CHECKSIG;
+    const auto GetTemplateTxIds = [&]() {
+        SyncWithValidationInterfaceQueue();
+        const std::shared_ptr<const CBlockTemplate> pblocktemplate =
+            builder.GetBlockTemplate(chainstate, scriptPubKey);
+        BOOST_CHECK(pblocktemplate->block.hashPrevBlock ==
+                    WITH_LOCK(cs_main, return chainstate.m_chain.Tip()
+                                           ->GetBlockHash()));
+        std::set<TxId> txids;
+        for (const CTransactionRef &tx : pblocktemplate->block.vtx) {
+            if (!tx->IsCoinBase()) {
+                txids.insert(tx->GetId());
+            }
+        }
+        return txids;
+    };
+
+    BOOST_CHECK(GetTemplateTxIds().empty());
+
+    // The transactions added to the mempool are added to the template.
+    const Amount fee = 10000 * SATOSHI;
+    const CTransactionRef parent =
+        MakeTransactionRef(CreateValidMempoolTransaction(
+            m_coinbase_txns[0], 0, 1, coinbaseKey, scriptPubKey,
+            m_coinbase_txns[0]->vout[0].nValue - fee));
+    const CTransactionRef child = MakeTransactionRef(
+        CreateValidMempoolTransaction(parent, 0, 101, coinbaseKey, scriptPubKey,
+                                      parent->vout[0].nValue - fee));
+    BOOST_CHECK(GetTemplateTxIds() ==
+                std::set<TxId>({parent->GetId(), child->GetId()}));
+
+    // The template is shared as long as the mempool doesn't change, and only
+    // the coinbase changes with the script.
+    const std::shared_ptr<const CBlockTemplate> pblocktemplate =
+        builder.GetBlockTemplate(chainstate, scriptPubKey);
+    BOOST_CHECK(builder.GetBlockTemplate(chainstate, scriptPubKey) ==
+                pblocktemplate);
+    const std::shared_ptr<const CBlockTemplate> otherScriptTemplate =
+        builder.GetBlockTemplate(chainstate, CScript() << OP_TRUE);
+    BOOST_CHECK(otherScriptTemplate != pblocktemplate);
+    BOOST_CHECK(otherScriptTemplate->block.vtx[0]->vout[0].scriptPubKey ==
+                CScript() << OP_TRUE);
+    BOOST_CHECK_EQUAL(otherScriptTemplate->block.vtx.size(),
+                      pblocktemplate->block.vtx.size());
+
+    // So are the removed ones.
+    WITH_LOCK(m_node.mempool->cs, m_node.mempool->removeRecursive(
+                                      *child, MemPoolRemovalReason::EXPIRY));
+    BOOST_CHECK(GetTemplateTxIds() == std::set<TxId>({parent->GetId()}));
+
+    // A new template is built on the new tip.
+    CreateAndProcessBlock({}, scriptPubKey);
+    BOOST_CHECK(GetTemplateTxIds() == std::set<TxId>({parent->GetId()}));
+    CreateAndProcessBlock({CMutableTransaction(*parent)}, scriptPubKey);
+    BOOST_CHECK(GetTemplateTxIds().empty());
+
+    UnregisterValidationInterface(&builder);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
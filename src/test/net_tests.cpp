@@ -1182,4 +1182,125 @@ BOOST_FIXTURE_TEST_CASE(net_group_limit, TestChain100Setup) {
     g_avalanche.reset();
 }
 
+BOOST_AUTO_TEST_CASE(net_message_buffer_pool) {
+    NetMessageBufferPool pool;
+
+    // The pool is empty, new buffers are returned.
+    CDataStream buffer = pool.Get(SER_NETWORK, PROTOCOL_VERSION);
+    BOOST_CHECK_EQUAL(buffer.capacity(), 0U);
+    BOOST_CHECK_EQUAL(buffer.GetVersion(), PROTOCOL_VERSION);
+
+    // Buffers without memory are not kept.
+    pool.Put(std::move(buffer));
+    BOOST_CHECK_EQUAL(pool.Get(SER_NETWORK, PROTOCOL_VERSION).capacity(), 0U);
+
+    // The buffers are reused empty, with their memory.
+    buffer.write("data", 4);
+    buffer.reserve(1000);
+    const size_t capacity = buffer.capacity();
+    pool.Put(std::move(buffer));
+    buffer = pool.Get(SER_NETWORK, INIT_PROTO_VERSION);
+    BOOST_CHECK_EQUAL(buffer.capacity(), capacity);
+    BOOST_CHECK(buffer.empty());
+    BOOST_CHECK_EQUAL(buffer.GetVersion(), INIT_PROTO_VERSION);
+    BOOST_CHECK_EQUAL(pool.Get(SER_NETWORK, PROTOCOL_VERSION).capacity(), 0U);
+
+    // Large buffers are freed.
+    buffer.reserve(NetMessageBufferPool::MAX_BUFFER_BYTES + 1);
+    pool.Put(std::move(buffer));
+    BOOST_CHECK_EQUAL(pool.Get(SER_NETWORK, PROTOCOL_VERSION).capacity(), 0U);
+
+    // The number of buffers kept is limited.
+    for (size_t i = 0; i < NetMessageBufferPool::MAX_BUFFERS + 1; ++i) {
+        CDataStream small(SER_NETWORK, PROTOCOL_VERSION);
+        small.reserve(1);
+        pool.Put(std::move(small));
+    }
+    for (size_t i = 0; i < NetMessageBufferPool::MAX_BUFFERS; ++i) {
+        BOOST_CHECK(pool.Get(SER_NETWORK, PROTOCOL_VERSION).capacity() > 0);
+    }
+    BOOST_CHECK_EQUAL(pool.Get(SER_NETWORK, PROTOCOL_VERSION).capacity(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(transport_deserializer_chunks) {
+    const Config &config = GetConfig();
+    V1TransportSerializer serializer;
+    V1TransportDeserializer deserializer(
+        config.GetChainParams().NetMagic(), SER_NETWORK, INIT_PROTO_VERSION);
+
+    // A message larger than the size allocated ahead, received in chunks.
+    CSerializedNetMsg msg;
+    msg.m_type = NetMsgType::BLOCK;
+    msg.data.resize(1024 * 1024);
+    for (size_t i = 0; i < msg.data.size(); ++i) {
+        msg.data[i] = uint8_t(i * 7);
+    }
+    const std::vector<uint8_t> payload = msg.data;
+    std::vector<uint8_t> bytes;
+    serializer.prepareForTransport(config, msg, bytes);
+    bytes.insert(bytes.end(), msg.data.begin(), msg.data.end());
+
+    for (int i = 0; i < 2; ++i) {
+        Span<const uint8_t> remaining(bytes);
+        while (!remaining.empty()) {
+            Span<const uint8_t> chunk =
+                remaining.first(std::min<size_t>(remaining.size(), 1000));
+            remaining = remaining.subspan(chunk.size());
+            while (!chunk.empty()) {
+                BOOST_CHECK(deserializer.Read(config, chunk) > 0);
+            }
+        }
+        BOOST_REQUIRE(deserializer.Complete());
+
+        const CNetMessage received = deserializer.GetMessage(config, 0us);
+        BOOST_CHECK(received.m_valid_checksum);
+        BOOST_CHECK_EQUAL(received.m_command, NetMsgType::BLOCK);
+        BOOST_CHECK_EQUAL(received.m_message_size, payload.size());
+        const Span<const uint8_t> received_payload =
+            MakeUCharSpan(received.m_recv);
+        BOOST_CHECK(std::equal(received_payload.begin(), received_payload.end(),
+                               payload.begin(), payload.end()));
+        // The buffer is never grown past the message size.
+        BOOST_CHECK_EQUAL(received.m_recv.capacity(), payload.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(shared_net_msg) {
+    const Config &config = GetConfig();
+    V1TransportSerializer serializer;
+
+    CSerializedNetMsg msg;
+    msg.m_type = NetMsgType::CMPCTBLOCK;
+    msg.data = {0x01, 0x02, 0x03, 0x04, 0x05};
+    const std::vector<uint8_t> payload = msg.data;
+
+    CSerializedNetMsg copy;
+    copy.m_type = msg.m_type;
+    copy.data = msg.data;
+    const CSharedNetMsg shared(std::move(copy));
+    BOOST_CHECK_EQUAL(shared.m_type, NetMsgType::CMPCTBLOCK);
+    BOOST_REQUIRE(shared.data);
+    BOOST_CHECK(*shared.data == payload);
+
+    // The header of the shared message is the same as the one of a message
+    // sent to a single peer.
+    std::vector<uint8_t> header;
+    std::vector<uint8_t> shared_header;
+    serializer.prepareForTransport(config, msg, header);
+    serializer.prepareForTransport(config, shared, shared_header);
+    BOOST_CHECK(header == shared_header);
+
+    // The send buffer uses the shared payload when it is set.
+    CSendBuffer buffer;
+    buffer.data = header;
+    BOOST_CHECK_EQUAL(buffer.size(), header.size());
+    BOOST_CHECK(std::equal(buffer.Get().begin(), buffer.Get().end(),
+                           header.begin(), header.end()));
+    buffer.data.clear();
+    buffer.shared_data = shared.data;
+    BOOST_CHECK_EQUAL(buffer.size(), payload.size());
+    BOOST_CHECK(std::equal(buffer.Get().begin(), buffer.Get().end(),
+                           payload.begin(), payload.end()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
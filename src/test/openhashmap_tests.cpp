@@ -0,0 +1,165 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <openhashmap.h>
+
+#include <memusage.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+
+BOOST_FIXTURE_TEST_SUITE(openhashmap_tests, BasicTestingSetup)
+
+namespace {
+/** Poor hash putting keys in few buckets, to exercise long probe chains. */
+struct CollidingHasher {
+    size_t operator()(uint32_t key) const { return (key % 7) << 7 | key % 3; }
+};
+
+template <typename Map>
+void CheckEqual(const Map &map, const std::map<uint32_t, std::string> &ref) {
+    BOOST_CHECK_EQUAL(map.size(), ref.size());
+    size_t count = 0;
+    for (const auto &[key, value] : map) {
+        auto it = ref.find(key);
+        BOOST_REQUIRE(it != ref.end());
+        BOOST_CHECK_EQUAL(value, it->second);
+        ++count;
+    }
+    BOOST_CHECK_EQUAL(count, ref.size());
+    for (const auto &[key, value] : ref) {
+        auto it = map.find(key);
+        BOOST_REQUIRE(it != map.end());
+        BOOST_CHECK_EQUAL(it->second, value);
+    }
+}
+
+template <typename Hash> void RandomizedTest() {
+    OpenHashMap<uint32_t, std::string, Hash> map;
+    std::map<uint32_t, std::string> ref;
+
+    for (int i = 0; i < 20000; ++i) {
+        const uint32_t key = InsecureRandRange(500);
+        switch (InsecureRandRange(5)) {
+            case 0:
+            case 1: {
+                const std::string value = std::to_string(InsecureRand32());
+                const bool inserted = map.emplace(key, value).second;
+                BOOST_CHECK_EQUAL(inserted, ref.emplace(key, value).second);
+                break;
+            }
+            case 2: {
+                const std::string value = std::to_string(InsecureRand32());
+                map[key] = value;
+                ref[key] = value;
+                break;
+            }
+            case 3:
+                BOOST_CHECK_EQUAL(map.erase(key), ref.erase(key));
+                break;
+            case 4: {
+                auto it = map.find(key);
+                BOOST_CHECK_EQUAL(it != map.end(), ref.count(key) == 1);
+                if (it != map.end()) {
+                    map.erase(it);
+                    ref.erase(key);
+                }
+                break;
+            }
+        }
+    }
+    CheckEqual(map, ref);
+
+    // Erase every other element while iterating, using both idioms.
+    bool odd = false;
+    for (auto it = map.begin(); it != map.end();) {
+        odd = !odd;
+        if (!odd) {
+            ++it;
+            continue;
+        }
+        ref.erase(it->first);
+        if (InsecureRandBool()) {
+            map.erase(it++);
+        } else {
+            it = map.erase(it);
+        }
+    }
+    CheckEqual(map, ref);
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(openhashmap_randomized) {
+    RandomizedTest<std::hash<uint32_t>>();
+    RandomizedTest<CollidingHasher>();
+}
+
+BOOST_AUTO_TEST_CASE(openhashmap_reference_stability) {
+    OpenHashMap<uint32_t, uint32_t> map;
+    std::vector<const std::pair<const uint32_t, uint32_t> *> entries;
+    for (uint32_t i = 0; i < 10000; ++i) {
+        entries.push_back(&*map.emplace(i, i * 2).first);
+    }
+    // The table was rehashed many times, but entries did not move.
+    for (uint32_t i = 0; i < 10000; ++i) {
+        auto it = map.find(i);
+        BOOST_REQUIRE(it != map.end());
+        BOOST_CHECK_EQUAL(&*it, entries[i]);
+        BOOST_CHECK_EQUAL(entries[i]->second, i * 2);
+    }
+
+    // Failed insertions leave the existing entry untouched.
+    auto [it, inserted] = map.emplace(42, 0);
+    BOOST_CHECK(!inserted);
+    BOOST_CHECK_EQUAL(&*it, entries[42]);
+    BOOST_CHECK_EQUAL(it->second, 84U);
+    std::tie(it, inserted) = map.try_emplace(42, 0);
+    BOOST_CHECK(!inserted);
+    BOOST_CHECK_EQUAL(it->second, 84U);
+}
+
+BOOST_AUTO_TEST_CASE(openhashmap_memory) {
+    OpenHashMap<uint32_t, std::shared_ptr<int>> map;
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), 0U);
+
+    auto shared = std::make_shared<int>(0);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        map.emplace(i, shared);
+    }
+    BOOST_CHECK_EQUAL(shared.use_count(), 1001);
+    const size_t usage = memusage::DynamicUsage(map);
+    BOOST_CHECK(usage > 1000 * sizeof(std::pair<const uint32_t,
+                                                 std::shared_ptr<int>>));
+
+    // Erasing destroys the entries, and their storage is reused.
+    for (uint32_t i = 0; i < 500; ++i) {
+        BOOST_CHECK_EQUAL(map.erase(i), 1U);
+    }
+    BOOST_CHECK_EQUAL(shared.use_count(), 501);
+    for (uint32_t i = 0; i < 500; ++i) {
+        map.emplace(i, shared);
+    }
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), usage);
+
+    // Clearing destroys the entries and releases all the memory.
+    map.clear();
+    BOOST_CHECK_EQUAL(shared.use_count(), 1);
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.begin() == map.end());
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), 0U);
+
+    // Moving transfers ownership of the entries.
+    map.emplace(1, shared);
+    OpenHashMap<uint32_t, std::shared_ptr<int>> other(std::move(map));
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK_EQUAL(other.size(), 1U);
+    BOOST_CHECK_EQUAL(shared.use_count(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <support/allocators/pool.h>
+
+#include <memusage.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+
+BOOST_FIXTURE_TEST_SUITE(pool_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(pool_allocate_reuse) {
+    using Pool = PoolResource<24, 8>;
+    Pool pool;
+    BOOST_CHECK_EQUAL(pool.NumChunks(), 0U);
+    BOOST_CHECK_EQUAL(pool.DynamicUsage(memusage::MallocUsage), 0U);
+
+    std::set<void *> blocks;
+    for (size_t i = 0; i < Pool::MIN_CHUNK_BLOCKS; ++i) {
+        void *p = pool.Allocate();
+        BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(p) % 8, 0U);
+        BOOST_CHECK(blocks.insert(p).second);
+    }
+    BOOST_CHECK_EQUAL(pool.NumChunks(), 1U);
+    BOOST_CHECK_EQUAL(pool.NumAllocated(), Pool::MIN_CHUNK_BLOCKS);
+
+    // The next chunk is twice as large.
+    blocks.insert(pool.Allocate());
+    BOOST_CHECK_EQUAL(pool.NumChunks(), 2U);
+    const size_t usage = pool.DynamicUsage(memusage::MallocUsage);
+    BOOST_CHECK(usage >= 3 * Pool::MIN_CHUNK_BLOCKS * 24);
+
+    // Freed blocks are handed out again before touching new memory.
+    void *freed = *blocks.begin();
+    pool.Deallocate(freed);
+    BOOST_CHECK_EQUAL(pool.Allocate(), freed);
+    BOOST_CHECK_EQUAL(pool.NumChunks(), 2U);
+    BOOST_CHECK_EQUAL(pool.DynamicUsage(memusage::MallocUsage), usage);
+
+    for (void *p : blocks) {
+        pool.Deallocate(p);
+    }
+    BOOST_CHECK_EQUAL(pool.NumAllocated(), 0U);
+    BOOST_CHECK_EQUAL(pool.DynamicUsage(memusage::MallocUsage), usage);
+
+    // Release returns all the chunks at once.
+    pool.Release();
+    BOOST_CHECK_EQUAL(pool.NumChunks(), 0U);
+    BOOST_CHECK_EQUAL(pool.DynamicUsage(memusage::MallocUsage), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(pool_chunk_growth) {
+    using Pool = PoolResource<8, 8>;
+    Pool pool;
+    size_t expected_chunks = 0;
+    size_t chunk_size = 0;
+    size_t capacity = 0;
+    for (size_t i = 0; i < 4 * Pool::MAX_CHUNK_BLOCKS; ++i) {
+        if (i == capacity) {
+            chunk_size = chunk_size == 0
+                             ? Pool::MIN_CHUNK_BLOCKS
+                             : std::min(2 * chunk_size, Pool::MAX_CHUNK_BLOCKS);
+            capacity += chunk_size;
+            ++expected_chunks;
+        }
+        pool.Allocate();
+        BOOST_CHECK_EQUAL(pool.NumChunks(), expected_chunks);
+    }
+    BOOST_CHECK_EQUAL(pool.NumAllocated(), 4 * Pool::MAX_CHUNK_BLOCKS);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -369,6 +369,43 @@ BOOST_AUTO_TEST_CASE(json_parse_errors) {
                       std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(json_write_reply) {
+    UniValue result(UniValue::VARR);
+    for (int i = 0; i < 10000; ++i) {
+        result.push_back(std::string(100, 'a' + i % 26));
+    }
+    const UniValue id("id");
+    const UniValue error = JSONRPCError(RPC_MISC_ERROR, "error");
+
+    const std::vector<std::pair<UniValue, UniValue>> replies{
+        {result, NullUniValue}, {result, error}, {NullUniValue, NullUniValue}};
+    for (const auto &[res, err] : replies) {
+        std::string reply;
+        size_t chunks = 0;
+        JSONRPCWriteReply(res, err, id, [&](const std::string &chunk) {
+            reply += chunk;
+            ++chunks;
+        });
+        BOOST_CHECK_EQUAL(reply, JSONRPCReply(res, err, id));
+        BOOST_CHECK(chunks > 1);
+    }
+
+    // Large results are written in several chunks.
+    size_t largest_chunk = 0;
+    JSONRPCWriteReply(result, NullUniValue, id, [&](const std::string &chunk) {
+        largest_chunk = std::max(largest_chunk, chunk.size());
+    });
+    BOOST_CHECK(largest_chunk < JSONRPC_REPLY_CHUNK_SIZE + 200);
+}
+
+BOOST_AUTO_TEST_CASE(rpc_read_only) {
+    BOOST_CHECK(tableRPC.isReadOnly("getblockcount"));
+    BOOST_CHECK(tableRPC.isReadOnly("getrawtransaction"));
+    BOOST_CHECK(!tableRPC.isReadOnly("sendrawtransaction"));
+    BOOST_CHECK(!tableRPC.isReadOnly("stop"));
+    BOOST_CHECK(!tableRPC.isReadOnly("invalidmethod"));
+}
+
 BOOST_AUTO_TEST_CASE(rpc_ban) {
     BOOST_CHECK_NO_THROW(CallRPC(std::string("clearbanned")));
 
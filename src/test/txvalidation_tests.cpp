@@ -4,8 +4,11 @@
 
 #include <config.h>
 #include <consensus/validation.h>
+#include <key.h>
 #include <primitives/transaction.h>
 #include <script/script.h>
+#include <script/standard.h>
+#include <txmempool.h>
 #include <validation.h>
 
 #include <test/util/setup_common.h>
@@ -48,4 +51,78 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_reject_coinbase, TestChain100Setup) {
     BOOST_CHECK_EQUAL(result.m_state.GetRejectReason(), "bad-tx-coinbase");
     BOOST_CHECK(result.m_state.GetResult() == TxValidationResult::TX_CONSENSUS);
 }
+
+/**
+ * Ensure that transactions accepted as a batch get the same results as if they
+ * were accepted one at a time.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_accept_batch, TestChain100Setup) {
+    // Make the first four coinbase transactions mature.
+    mineBlocks(3);
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript spk = GetScriptForDestination(PKHash(key.GetPubKey()));
+    const auto make_tx = [&](const CTransactionRef &input, const CKey &signer,
+                             Amount amount) {
+        return MakeTransactionRef(CreateValidMempoolTransaction(
+            input, 0, 0, signer, spk, amount, /*submit=*/false));
+    };
+
+    const CTransactionRef tx1 = make_tx(m_coinbase_txns[0], coinbaseKey,
+                                        49 * COIN);
+    const CTransactionRef child = make_tx(tx1, key, 48 * COIN);
+    const CTransactionRef tx2 = make_tx(m_coinbase_txns[1], coinbaseKey,
+                                        49 * COIN);
+    const CTransactionRef double_spend =
+        make_tx(m_coinbase_txns[1], coinbaseKey, 48 * COIN);
+    const CTransactionRef tx3 = make_tx(m_coinbase_txns[2], coinbaseKey,
+                                        49 * COIN);
+    // Changing the output invalidates the signature.
+    CMutableTransaction mtx_bad_sig = CreateValidMempoolTransaction(
+        m_coinbase_txns[3], 0, 0, coinbaseKey, spk, 49 * COIN,
+        /*submit=*/false);
+    mtx_bad_sig.vout[0].nValue = 48 * COIN;
+    const CTransactionRef bad_sig = MakeTransactionRef(mtx_bad_sig);
+
+    LOCK(cs_main);
+    const unsigned int initialPoolSize = m_node.mempool->size();
+
+    // The child is accepted after its parent.
+    const std::vector<MempoolAcceptResult> results =
+        m_node.chainman->ProcessTransactions({tx1, child, tx2});
+    BOOST_REQUIRE_EQUAL(results.size(), 3U);
+    for (const MempoolAcceptResult &result : results) {
+        BOOST_CHECK(result.m_result_type ==
+                    MempoolAcceptResult::ResultType::VALID);
+    }
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize + 3);
+    {
+        LOCK(m_node.mempool->cs);
+        // The sigchecks of the scripts checked in parallel are accounted for.
+        for (const CTransactionRef &tx : {tx1, child, tx2}) {
+            auto it = m_node.mempool->GetIter(tx->GetId());
+            BOOST_REQUIRE(it);
+            BOOST_CHECK_EQUAL((*it)->GetSigChecks(), 1);
+        }
+    }
+
+    // A failing script check is attributed to the right transaction, and
+    // conflicting transactions are rejected.
+    const std::vector<MempoolAcceptResult> results2 =
+        m_node.chainman->ProcessTransactions({bad_sig, double_spend, tx3});
+    BOOST_REQUIRE_EQUAL(results2.size(), 3U);
+    BOOST_CHECK(results2[0].m_state.GetResult() ==
+                TxValidationResult::TX_CONSENSUS);
+    BOOST_CHECK(results2[0].m_state.GetRejectReason().rfind(
+                    "mandatory-script-verify-flag-failed", 0) == 0);
+    BOOST_CHECK_EQUAL(results2[1].m_state.GetRejectReason(),
+                      "txn-mempool-conflict");
+    BOOST_CHECK(results2[2].m_result_type ==
+                MempoolAcceptResult::ResultType::VALID);
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize + 4);
+    BOOST_CHECK(!m_node.mempool->exists(bad_sig->GetId()));
+    BOOST_CHECK(!m_node.mempool->exists(double_spend->GetId()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
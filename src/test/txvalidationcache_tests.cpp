@@ -12,6 +12,7 @@
 #include <script/sign.h>
 #include <script/signingprovider.h>
 #include <txmempool.h>
+#include <util/time.h>
 #include <validation.h>
 
 #include <test/lcg.h>
@@ -690,4 +691,60 @@ BOOST_AUTO_TEST_CASE(scriptcache_values) {
     CHECK_CACHE_HAS(key1A, 42);
 }
 
+BOOST_FIXTURE_TEST_CASE(scriptcache_persistence, BasicTestingSetup) {
+    const fs::path path = m_args.GetDataDirNet() / "scriptcache.dat";
+    InitScriptExecutionCache();
+
+    CMutableTransaction tx;
+    tx.nVersion = 1;
+    // The key depends on the nonce the cache is currently salted with.
+    const auto key = [&] {
+        return ScriptCacheKey(CTransaction(tx), 0x7fffffff);
+    };
+    WITH_LOCK(cs_main, AddKeyInScriptCache(key(), 42));
+    BOOST_CHECK(DumpScriptCaches(path));
+
+    // The cache is salted with a fresh nonce when initialized again, so the
+    // entry is lost unless it is loaded from disk.
+    InitScriptExecutionCache();
+    {
+        LOCK(cs_main);
+        CHECK_CACHE_MISSING(key());
+    }
+    BOOST_CHECK(LoadScriptCaches(path));
+    {
+        LOCK(cs_main);
+        CHECK_CACHE_HAS(key(), 42);
+    }
+
+    // Entries are dropped once the nonce they were computed with is too old.
+    InitScriptExecutionCache();
+    SetMockTime(GetTime() + count_seconds(MAX_SCRIPT_CACHE_NONCE_AGE) + 1);
+    BOOST_CHECK(LoadScriptCaches(path));
+    {
+        LOCK(cs_main);
+        CHECK_CACHE_MISSING(key());
+    }
+    SetMockTime(0);
+
+    // The caches saved by another version are discarded. The client version
+    // follows the 8 bytes of the file format version.
+    FILE *file = fsbridge::fopen(path, "r+b");
+    BOOST_REQUIRE(file);
+    int32_t client_version;
+    BOOST_REQUIRE_EQUAL(std::fseek(file, 8, SEEK_SET), 0);
+    BOOST_REQUIRE_EQUAL(std::fread(&client_version, 4, 1, file), 1U);
+    client_version ^= 1;
+    BOOST_REQUIRE_EQUAL(std::fseek(file, 8, SEEK_SET), 0);
+    BOOST_REQUIRE_EQUAL(std::fwrite(&client_version, 4, 1, file), 1U);
+    std::fclose(file);
+
+    InitScriptExecutionCache();
+    BOOST_CHECK(!LoadScriptCaches(path));
+    {
+        LOCK(cs_main);
+        CHECK_CACHE_MISSING(key());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -63,94 +63,49 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate) {
                           MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes*/ 0),
                       CoinsCacheSizeState::OK);
 
-    // If the initial memory allocations of cacheCoins don't match these common
-    // cases, we can't really continue to make assertions about memory usage.
-    // End the test early.
-    if (view.DynamicMemoryUsage() != 32 && view.DynamicMemoryUsage() != 16) {
-        // Add a bunch of coins to see that we at least flip over to CRITICAL.
-
-        for (int i{0}; i < 1000; ++i) {
-            COutPoint res = add_coin(view);
-            BOOST_CHECK_EQUAL(view.AccessCoin(res).DynamicMemoryUsage(),
-                              COIN_SIZE);
-        }
-
-        BOOST_CHECK_EQUAL(
-            chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES,
-                                              /*max_mempool_size_bytes*/ 0),
-            CoinsCacheSizeState::CRITICAL);
-
-        BOOST_TEST_MESSAGE(
-            "Exiting cache flush tests early due to unsupported arch");
-        return;
-    }
+    // The cache does not allocate anything until the first coin is added.
+    BOOST_CHECK_EQUAL(view.DynamicMemoryUsage(), 0U);
 
+    // Coins are allocated from chunks, so the usage grows in steps that are
+    // larger than a single coin: adding one coin is enough to go CRITICAL.
+    COutPoint res = add_coin(view);
     print_view_mem_usage(view);
-    BOOST_CHECK_EQUAL(view.DynamicMemoryUsage(), is_64_bit ? 32U : 16U);
-
-    // We should be able to add COINS_UNTIL_CRITICAL coins to the cache before
-    // going CRITICAL. This is contingent not only on the dynamic memory usage
-    // of the Coins that we're adding (COIN_SIZE bytes per), but also on how
-    // much memory the cacheCoins (unordered_map) preallocates.
-    constexpr int COINS_UNTIL_CRITICAL{3};
-
-    for (int i{0}; i < COINS_UNTIL_CRITICAL; ++i) {
-        COutPoint res = add_coin(view);
-        print_view_mem_usage(view);
-        BOOST_CHECK_EQUAL(view.AccessCoin(res).DynamicMemoryUsage(), COIN_SIZE);
-        BOOST_CHECK_EQUAL(
-            chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES,
-                                              /*max_mempool_size_bytes*/ 0),
-            CoinsCacheSizeState::OK);
-    }
-
-    // Adding some additional coins will push us over the edge to CRITICAL.
-    for (int i{0}; i < 4; ++i) {
-        add_coin(view);
-        print_view_mem_usage(view);
-        if (chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES,
-                                              /*max_mempool_size_bytes*/ 0) ==
-            CoinsCacheSizeState::CRITICAL) {
-            break;
-        }
-    }
-
+    BOOST_CHECK_EQUAL(view.AccessCoin(res).DynamicMemoryUsage(), COIN_SIZE);
+    BOOST_CHECK(view.DynamicMemoryUsage() > MAX_COINS_CACHE_BYTES);
     BOOST_CHECK_EQUAL(chainstate.GetCoinsCacheSizeState(
                           MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes*/ 0),
                       CoinsCacheSizeState::CRITICAL);
 
     // Passing non-zero max mempool usage should allow us more headroom.
-    BOOST_CHECK_EQUAL(
-        chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES,
-                                          /*max_mempool_size_bytes*/ 1 << 10),
-        CoinsCacheSizeState::OK);
-
-    for (int i{0}; i < 3; ++i) {
+    BOOST_CHECK(chainstate.GetCoinsCacheSizeState(
+                    MAX_COINS_CACHE_BYTES,
+                    /*max_mempool_size_bytes*/ 1 << 20) !=
+                CoinsCacheSizeState::CRITICAL);
+
+    // Add coins until we go over the limit with the mempool headroom too.
+    size_t coins_usage = COIN_SIZE;
+    while (chainstate.GetCoinsCacheSizeState(
+               MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes*/ 1 << 10) !=
+           CoinsCacheSizeState::CRITICAL) {
         add_coin(view);
-        print_view_mem_usage(view);
-        BOOST_CHECK_EQUAL(
-            chainstate.GetCoinsCacheSizeState(
-                MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes*/ 1 << 10),
-            CoinsCacheSizeState::OK);
+        coins_usage += COIN_SIZE;
+        BOOST_CHECK(view.DynamicMemoryUsage() > coins_usage);
     }
-
-    // Adding another coin with the additional mempool room will put us >90%
-    // but not yet critical.
-    add_coin(view);
     print_view_mem_usage(view);
 
-    // Only perform these checks on 64 bit hosts; I haven't done the math
-    // for 32.
-    if (is_64_bit) {
-        float usage_percentage = (float)view.DynamicMemoryUsage() /
-                                 (MAX_COINS_CACHE_BYTES + (1 << 10));
-        BOOST_TEST_MESSAGE("CoinsTip usage percentage: " << usage_percentage);
-        BOOST_CHECK(usage_percentage >= 0.9);
-        BOOST_CHECK(usage_percentage < 1);
-        BOOST_CHECK_EQUAL(
-            chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, 1 << 10),
-            CoinsCacheSizeState::LARGE);
-    }
+    // With just enough mempool headroom for the cache to fit, the cache uses
+    // more than 90% of the total space but doesn't exceed it.
+    const size_t headroom = view.DynamicMemoryUsage() - MAX_COINS_CACHE_BYTES +
+                            mempool.DynamicMemoryUsage();
+    BOOST_CHECK_EQUAL(
+        chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, headroom),
+        CoinsCacheSizeState::LARGE);
+    BOOST_CHECK_EQUAL(
+        chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, headroom - 1),
+        CoinsCacheSizeState::CRITICAL);
+    BOOST_CHECK_EQUAL(chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES,
+                                                        2 * headroom),
+                      CoinsCacheSizeState::OK);
 
     // Using the default max_* values permits way more coins to be added.
     for (int i{0}; i < 1000; ++i) {
@@ -159,20 +114,20 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate) {
                           CoinsCacheSizeState::OK);
     }
 
-    // Flushing the view doesn't take us back to OK because cacheCoins has
-    // preallocated memory that doesn't get reclaimed even after flush.
-
     BOOST_CHECK_EQUAL(
         chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, 0),
         CoinsCacheSizeState::CRITICAL);
 
+    // Flushing the view releases all the memory held by cacheCoins, which
+    // takes us back to OK.
     view.SetBestBlock(BlockHash(InsecureRand256()));
     BOOST_CHECK(view.Flush());
     print_view_mem_usage(view);
+    BOOST_CHECK_EQUAL(view.DynamicMemoryUsage(), 0U);
 
     BOOST_CHECK_EQUAL(
         chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, 0),
-        CoinsCacheSizeState::CRITICAL);
+        CoinsCacheSizeState::OK);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
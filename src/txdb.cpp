@@ -11,12 +11,14 @@
 #include <random.h>
 #include <shutdown.h>
 #include <util/system.h>
+#include <util/thread.h>
 #include <util/translation.h>
 #include <util/vector.h>
 #include <version.h>
 
 #include <cstdint>
 #include <memory>
+#include <type_traits>
 
 static const char DB_COIN = 'C';
 static const char DB_COINS = 'c';
@@ -116,6 +118,20 @@ std::vector<BlockHash> CCoinsViewDB::GetHeadBlocks() const {
 }
 
 bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock) {
+    bool ret = WriteCoinsImpl(mapCoins, hashBlock);
+    // The entries have been freed as they were written, release the memory
+    // they were allocated from.
+    mapCoins.clear();
+    return ret;
+}
+
+bool CCoinsViewDB::WriteCoins(const CCoinsMap &mapCoins,
+                              const BlockHash &hashBlock) {
+    return WriteCoinsImpl(mapCoins, hashBlock);
+}
+
+template <typename Map>
+bool CCoinsViewDB::WriteCoinsImpl(Map &mapCoins, const BlockHash &hashBlock) {
     CDBBatch batch(*m_db);
     size_t count = 0;
     size_t changed = 0;
@@ -141,7 +157,7 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock) {
     batch.Erase(DB_BEST_BLOCK);
     batch.Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
 
-    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
+    for (auto it = mapCoins.begin(); it != mapCoins.end();) {
         if (it->second.flags & CCoinsCacheEntry::DIRTY) {
             CoinEntry entry(&it->first);
             if (it->second.coin.IsSpent()) {
@@ -152,8 +168,11 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock) {
             changed++;
         }
         count++;
-        CCoinsMap::iterator itOld = it++;
-        mapCoins.erase(itOld);
+        if constexpr (std::is_const_v<Map>) {
+            ++it;
+        } else {
+            it = mapCoins.erase(it);
+        }
         if (batch.SizeEstimate() > batch_size) {
             LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n",
                      batch.SizeEstimate() * (1.0 / 1048576.0));
@@ -183,6 +202,152 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock) {
     return ret;
 }
 
+CCoinsViewBackgroundFlush::CCoinsViewBackgroundFlush(CCoinsView *base,
+                                                     CCoinsViewDB &db)
+    : CCoinsViewBacked(base), m_db(db) {}
+
+CCoinsViewBackgroundFlush::~CCoinsViewBackgroundFlush() {
+    {
+        LOCK(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+bool CCoinsViewBackgroundFlush::GetCoin(const COutPoint &outpoint,
+                                        Coin &coin) const {
+    {
+        LOCK(m_mutex);
+        if (m_frozen) {
+            CCoinsMap::const_iterator it = m_frozen->find(outpoint);
+            if (it != m_frozen->end()) {
+                coin = it->second.coin;
+                return !coin.IsSpent();
+            }
+        }
+    }
+    // Entries missing from the frozen layer are not being written, so the
+    // database has them as of the flushed best block.
+    return base->GetCoin(outpoint, coin);
+}
+
+bool CCoinsViewBackgroundFlush::HaveCoin(const COutPoint &outpoint) const {
+    Coin coin;
+    return GetCoin(outpoint, coin);
+}
+
+BlockHash CCoinsViewBackgroundFlush::GetBestBlock() const {
+    {
+        LOCK(m_mutex);
+        if (m_frozen) {
+            return m_frozen_best_block;
+        }
+    }
+    return base->GetBestBlock();
+}
+
+bool CCoinsViewBackgroundFlush::BatchWrite(CCoinsMap &mapCoins,
+                                           const BlockHash &hashBlock) {
+    if (!WaitForFlush()) {
+        return false;
+    }
+
+    if (!WITH_LOCK(m_mutex, return m_background)) {
+        WITH_LOCK(m_mutex, ++m_generation);
+        const bool ret = m_db.BatchWrite(mapCoins, hashBlock);
+        WITH_LOCK(m_mutex, ++m_generation);
+        return ret;
+    }
+
+    {
+        LOCK(m_mutex);
+        // Readers see either all or none of the frozen entries, so the write
+        // is atomic from their point of view.
+        m_generation += 2;
+        m_frozen = std::make_unique<CCoinsMap>(std::move(mapCoins));
+        m_frozen_best_block = hashBlock;
+        m_frozen_usage = m_background_usage;
+        if (!m_thread.joinable()) {
+            m_thread = std::thread(&util::TraceThread, "coinsflush",
+                                   [this] { ThreadWrite(); });
+        }
+    }
+    m_cv.notify_all();
+    return true;
+}
+
+void CCoinsViewBackgroundFlush::SetBackground(bool background, size_t usage) {
+    LOCK(m_mutex);
+    m_background = background;
+    m_background_usage = usage;
+}
+
+size_t CCoinsViewBackgroundFlush::DynamicMemoryUsage() const {
+    LOCK(m_mutex);
+    return m_frozen ? m_frozen_usage : 0;
+}
+
+bool CCoinsViewBackgroundFlush::WaitForFlush() {
+    WAIT_LOCK(m_mutex, lock);
+    m_cv.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return !m_frozen || m_failed;
+    });
+    return !m_failed;
+}
+
+uint64_t CCoinsViewBackgroundFlush::GetGeneration() const {
+    LOCK(m_mutex);
+    return m_generation;
+}
+
+bool CCoinsViewBackgroundFlush::HasFailed() const {
+    LOCK(m_mutex);
+    return m_failed;
+}
+
+void CCoinsViewBackgroundFlush::ThreadWrite() {
+    while (true) {
+        const CCoinsMap *frozen;
+        BlockHash best_block;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_cv.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                return m_stop || (m_frozen && !m_failed);
+            });
+            if (!m_frozen || m_failed) {
+                return;
+            }
+            frozen = m_frozen.get();
+            best_block = m_frozen_best_block;
+        }
+
+        // The frozen entries are only read from here on, concurrently with
+        // readers of this view, until they are released below.
+        bool ok = false;
+        try {
+            ok = m_db.WriteCoins(*frozen, best_block);
+        } catch (const std::runtime_error &e) {
+            LogPrintf("Error writing to coin database: %s\n", e.what());
+        }
+
+        std::unique_ptr<CCoinsMap> written;
+        {
+            LOCK(m_mutex);
+            if (ok) {
+                written = std::move(m_frozen);
+            } else {
+                m_failed = true;
+            }
+        }
+        m_cv.notify_all();
+        // Free the entries outside of the lock.
+        written.reset();
+    }
+}
+
 size_t CCoinsViewDB::EstimateSize() const {
     return m_db->EstimateSize(DB_COIN, char(DB_COIN + 1));
 }
@@ -10,10 +10,13 @@
 #include <coins.h>
 #include <dbwrapper.h>
 #include <flatfile.h>
+#include <sync.h>
 
+#include <condition_variable>
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -72,6 +75,10 @@ public:
     bool BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
 
+    //! Write the dirty entries of mapCoins without modifying it. Same as
+    //! BatchWrite otherwise.
+    bool WriteCoins(const CCoinsMap &mapCoins, const BlockHash &hashBlock);
+
     //! Attempt to update from an older database format.
     //! Returns whether an error occurred.
     bool Upgrade();
@@ -79,6 +86,81 @@ public:
 
     //! Dynamically alter the underlying leveldb cache size.
     void ResizeCache(size_t new_cache_size) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+private:
+    //! Write the dirty entries of mapCoins, erasing them as they are written
+    //! unless the map is const.
+    template <typename Map>
+    bool WriteCoinsImpl(Map &mapCoins, const BlockHash &hashBlock);
+};
+
+/**
+ * Layer between the in-memory coins cache and the coin database that can write
+ * a flushed cache to the database on a background thread.
+ *
+ * In background mode, BatchWrite() takes the flushed entries over in constant
+ * time and returns. They are kept as a frozen layer that keeps being served to
+ * readers until a dedicated thread has written them to the database, so the
+ * cache above always sees the state at the flushed best block. The write goes
+ * through the usual head blocks marker of CCoinsViewDB, so a crash in the
+ * middle of it is recovered by replaying blocks on startup.
+ *
+ * At most one write is in flight: the next flush waits for the previous one.
+ */
+class CCoinsViewBackgroundFlush final : public CCoinsViewBacked {
+public:
+    /**
+     * @param[in] base  View used to read coins, on top of db.
+     * @param[in] db    Database the flushed entries are written to.
+     */
+    CCoinsViewBackgroundFlush(CCoinsView *base, CCoinsViewDB &db);
+    ~CCoinsViewBackgroundFlush();
+
+    bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    bool HaveCoin(const COutPoint &outpoint) const override;
+    BlockHash GetBestBlock() const override;
+    bool BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock) override;
+
+    //! Whether the next BatchWrite() calls return before the entries are
+    //! written to the database. usage is the memory used by the cache being
+    //! flushed, which DynamicMemoryUsage() reports until it is written.
+    void SetBackground(bool background, size_t usage = 0)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Memory used by the entries handed over by a background flush and not
+    //! written yet, so that it can be counted against the coins cache limit.
+    size_t DynamicMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Wait until the pending write, if any, completes.
+    //! Returns false if a background write failed.
+    bool WaitForFlush() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Counter that changes whenever the view is written to, and that is odd
+    //! while a synchronous write is in progress. Coins read while it keeps the
+    //! same even value are still current.
+    uint64_t GetGeneration() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Whether a background write failed. The entries it was writing are still
+    //! served to readers but will never make it to disk.
+    bool HasFailed() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    void ThreadWrite() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    CCoinsViewDB &m_db;
+
+    mutable Mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_background GUARDED_BY(m_mutex){false};
+    size_t m_background_usage GUARDED_BY(m_mutex){0};
+    //! Entries handed over by the last flush, until they are written.
+    std::unique_ptr<CCoinsMap> m_frozen GUARDED_BY(m_mutex);
+    BlockHash m_frozen_best_block GUARDED_BY(m_mutex);
+    size_t m_frozen_usage GUARDED_BY(m_mutex){0};
+    bool m_failed GUARDED_BY(m_mutex){false};
+    uint64_t m_generation GUARDED_BY(m_mutex){0};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_thread;
 };
 
 /** Specialization of CCoinsViewCursor to iterate over a CCoinsViewDB */
@@ -127,6 +127,7 @@ void CTxMemPoolEntry::UpdateFeeDelta(Amount newFeeDelta) {
     nModFeesWithDescendants += newFeeDelta - feeDelta;
     nModFeesWithAncestors += newFeeDelta - feeDelta;
     feeDelta = newFeeDelta;
+    InvalidateSnapshotEntry();
 }
 
 void CTxMemPoolEntry::UpdateLockPoints(const LockPoints &lp) {
@@ -389,6 +390,7 @@ void CTxMemPoolEntry::UpdateDescendantState(int64_t modifySize,
     assert(int64_t(nCountWithDescendants) > 0);
     nSigChecksWithDescendants += modifySigChecks;
     assert(nSigChecksWithDescendants >= 0);
+    InvalidateSnapshotEntry();
 }
 
 void CTxMemPoolEntry::UpdateAncestorState(int64_t modifySize, Amount modifyFee,
@@ -401,6 +403,7 @@ void CTxMemPoolEntry::UpdateAncestorState(int64_t modifySize, Amount modifyFee,
     assert(int64_t(nCountWithAncestors) > 0);
     nSigChecksWithAncestors += modifySigChecks;
     assert(nSigChecksWithAncestors >= 0);
+    InvalidateSnapshotEntry();
 }
 
 CTxMemPool::CTxMemPool(int check_ratio) : m_check_ratio(check_ratio) {
@@ -408,7 +411,12 @@ CTxMemPool::CTxMemPool(int check_ratio) : m_check_ratio(check_ratio) {
     _clear();
 }
 
-CTxMemPool::~CTxMemPool() {}
+CTxMemPool::~CTxMemPool() {
+    const MempoolSnapshot *snapshot = m_snapshot.exchange(nullptr);
+    if (snapshot) {
+        ConstMempoolSnapshotRef::acquire(snapshot);
+    }
+}
 
 bool CTxMemPool::isSpent(const COutPoint &outpoint) const {
     LOCK(cs);
@@ -451,6 +459,9 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entryIn,
     // further updated.)
     cachedInnerUsage += entry.DynamicMemoryUsage();
 
+    vTxHashes.emplace_back(newit->GetTx().GetHash(), newit);
+    newit->vTxHashesIdx = vTxHashes.size() - 1;
+
     const CTransaction &tx = newit->GetTx();
     std::set<TxId> setParentTransactions;
     for (const CTxIn &in : tx.vin) {
@@ -496,6 +507,18 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason) {
     /* add logging because unchecked */
     RemoveUnbroadcastTx(it->GetTx().GetId(), true);
 
+    if (vTxHashes.size() > 1) {
+        // Move the last hash into the slot of the removed one.
+        vTxHashes[it->vTxHashesIdx] = std::move(vTxHashes.back());
+        vTxHashes[it->vTxHashesIdx].second->vTxHashesIdx = it->vTxHashesIdx;
+        vTxHashes.pop_back();
+        if (vTxHashes.size() * 2 < vTxHashes.capacity()) {
+            vTxHashes.shrink_to_fit();
+        }
+    } else {
+        vTxHashes.clear();
+    }
+
     totalTxSize -= it->GetTxSize();
     m_total_fee -= it->GetFee();
     cachedInnerUsage -= it->DynamicMemoryUsage();
@@ -598,30 +621,96 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef> &vtx) {
         return;
     }
 
-    DisconnectedBlockTransactions disconnectpool;
-    disconnectpool.addForBlock(vtx, *this);
-
-    for (const CTransactionRef &tx :
-         reverse_iterate(disconnectpool.GetQueuedTx().get<insertion_order>())) {
+    // The block is sorted by txid rather than topologically, and the confirmed
+    // transactions are removed all at once so their order doesn't matter.
+    // Following the block order makes the insertions into the set cheap.
+    setEntries confirmed;
+    for (const CTransactionRef &tx : vtx) {
         txiter it = mapTx.find(tx->GetId());
         if (it != mapTx.end()) {
-            setEntries stage;
-            stage.insert(it);
-            RemoveStaged(stage, true, MemPoolRemovalReason::BLOCK);
-        } else {
-            // Conflicting txs can only exist if the tx was not in the mempool
-            removeConflicts(*tx);
+            confirmed.insert(confirmed.end(), it);
         }
-        ClearPrioritisation(tx->GetId());
     }
+    RemoveConfirmed(confirmed);
 
-    disconnectpool.clear();
+    for (const CTransactionRef &tx : vtx) {
+        // Conflicting txs can only exist if the tx was not in the mempool, and
+        // they can't be descendants of a confirmed tx.
+        removeConflicts(*tx);
+        ClearPrioritisation(tx->GetId());
+    }
 
     lastRollingFeeUpdate = GetTime();
     blockSinceLastRollingFeeBump = true;
 }
 
+void CTxMemPool::RemoveConfirmed(const setEntries &confirmed) {
+    AssertLockHeld(cs);
+
+    // The in-mempool ancestors of a confirmed transaction are confirmed as
+    // well, so only the descendants that remain in the mempool need updating.
+    // Fall back to the generic path otherwise.
+    for (txiter it : confirmed) {
+        for (const CTxMemPoolEntry &parent : it->GetMemPoolParentsConst()) {
+            if (!confirmed.count(mapTx.iterator_to(parent))) {
+                RemoveStaged(confirmed, true, MemPoolRemovalReason::BLOCK);
+                return;
+            }
+        }
+    }
+
+    // Remove this branch after wellington
+    if (!wellingtonLatched) {
+        // Accumulate the confirmed ancestors of each remaining descendant, so
+        // that its ancestor state is only modified once.
+        struct AncestorStateDelta {
+            int64_t size{0};
+            Amount fee{Amount::zero()};
+            int64_t count{0};
+            int64_t sig_checks{0};
+        };
+        std::map<txiter, AncestorStateDelta, CompareIteratorById> deltas;
+        for (txiter it : confirmed) {
+            // The remaining descendants can also descend from it through
+            // other confirmed entries, so walk all of them.
+            setEntries descendants;
+            CalculateDescendants(it, descendants);
+            for (txiter dit : descendants) {
+                if (confirmed.count(dit)) {
+                    continue;
+                }
+                AncestorStateDelta &delta = deltas[dit];
+                delta.size -= it->GetTxSize();
+                delta.fee -= it->GetModifiedFee();
+                delta.count -= 1;
+                delta.sig_checks -= it->GetSigChecks();
+            }
+        }
+        for (const auto &[dit, delta] : deltas) {
+            mapTx.modify(dit, update_ancestor_state(delta.size, delta.fee,
+                                                    delta.count,
+                                                    delta.sig_checks));
+        }
+    }
+
+    // Only the links to the remaining children need to be severed, the
+    // confirmed entries are erased along with their links to each other.
+    for (txiter it : confirmed) {
+        for (const CTxMemPoolEntry &child : it->GetMemPoolChildrenConst()) {
+            txiter childit = mapTx.iterator_to(child);
+            if (!confirmed.count(childit)) {
+                UpdateParent(childit, it, false);
+            }
+        }
+    }
+
+    for (txiter it : confirmed) {
+        removeUnchecked(it, MemPoolRemovalReason::BLOCK);
+    }
+}
+
 void CTxMemPool::_clear() {
+    vTxHashes.clear();
     mapTx.clear();
     mapNextTx.clear();
     totalTxSize = 0;
@@ -668,6 +757,8 @@ void CTxMemPool::check(const CCoinsViewCache &active_coins_tip,
         const CTransaction &tx = entry.GetTx();
         innerUsage += memusage::DynamicUsage(entry.GetMemPoolParentsConst()) +
                       memusage::DynamicUsage(entry.GetMemPoolChildrenConst());
+        assert(&*vTxHashes.at(entry.vTxHashesIdx).second == &entry);
+        assert(vTxHashes[entry.vTxHashesIdx].first == tx.GetHash());
 
         CTxMemPoolEntry::Parents setParentCheck;
         for (const CTxIn &txin : tx.vin) {
@@ -784,6 +875,7 @@ void CTxMemPool::check(const CCoinsViewCache &active_coins_tip,
     assert(totalTxSize == checkTotal);
     assert(m_total_fee == check_total_fee);
     assert(innerUsage == cachedInnerUsage);
+    assert(vTxHashes.size() == mapTx.size());
 }
 
 bool CTxMemPool::CompareTopologically(const TxId &txida,
@@ -818,19 +910,87 @@ GetInfo(CTxMemPool::indexed_transaction_set::const_iterator it) {
 }
 
 std::vector<TxMempoolInfo> CTxMemPool::infoAll() const {
-    LOCK(cs);
+    const ConstMempoolSnapshotRef snapshot = GetSnapshot();
 
     std::vector<TxMempoolInfo> ret;
-    ret.reserve(mapTx.size());
-
-    const auto &index = mapTx.get<entry_id>();
-    for (auto it = index.begin(); it != index.end(); ++it) {
-        ret.push_back(GetInfo(mapTx.project<0>(it)));
+    ret.reserve(snapshot->GetEntries().size());
+    for (const auto &entry : snapshot->GetEntries()) {
+        ret.push_back(entry->info);
     }
 
     return ret;
 }
 
+MempoolSnapshotEntry::MempoolSnapshotEntry(const CTxMemPoolEntry &entry,
+                                           bool unbroadcast_in)
+    : info{entry.GetSharedTx(), entry.GetTime(), entry.GetFee(),
+           entry.GetTxSize(), entry.GetModifiedFee() - entry.GetFee()},
+      height(entry.GetHeight()),
+      count_with_ancestors(entry.GetCountWithAncestors()),
+      size_with_ancestors(entry.GetSizeWithAncestors()),
+      mod_fees_with_ancestors(entry.GetModFeesWithAncestors()),
+      count_with_descendants(entry.GetCountWithDescendants()),
+      size_with_descendants(entry.GetSizeWithDescendants()),
+      mod_fees_with_descendants(entry.GetModFeesWithDescendants()),
+      unbroadcast(unbroadcast_in) {
+    parents.reserve(entry.GetMemPoolParentsConst().size());
+    for (const CTxMemPoolEntry &parent : entry.GetMemPoolParentsConst()) {
+        parents.push_back(parent.GetTx().GetId());
+    }
+    children.reserve(entry.GetMemPoolChildrenConst().size());
+    for (const CTxMemPoolEntry &child : entry.GetMemPoolChildrenConst()) {
+        children.push_back(child.GetTx().GetId());
+    }
+}
+
+MempoolSnapshot::MempoolSnapshot(const CTxMemPool &pool) {
+    AssertLockHeld(pool.cs);
+
+    m_sequence = pool.GetSequence();
+    m_transactions_updated = pool.nTransactionsUpdated;
+    m_unbroadcast_updated = pool.m_unbroadcast_updated;
+    m_entries.reserve(pool.mapTx.size());
+    for (const CTxMemPoolEntry &entry : pool.mapTx.get<entry_id>()) {
+        // Only copy the entries which changed since the previous snapshot.
+        if (!entry.m_snapshot_entry) {
+            entry.m_snapshot_entry = std::make_shared<MempoolSnapshotEntry>(
+                entry,
+                pool.m_unbroadcast_txids.count(entry.GetTx().GetId()) > 0);
+        }
+        m_entries.push_back(entry.m_snapshot_entry);
+    }
+}
+
+ConstMempoolSnapshotRef CTxMemPool::GetSnapshot() const {
+    {
+        RCULock lock;
+        const MempoolSnapshot *snapshot = m_snapshot.load();
+        if (snapshot &&
+            snapshot->m_transactions_updated == nTransactionsUpdated &&
+            snapshot->m_unbroadcast_updated == m_unbroadcast_updated) {
+            return ConstMempoolSnapshotRef::copy(snapshot);
+        }
+    }
+
+    // The mempool changed since the latest snapshot: build a new one. Readers
+    // still holding the previous snapshot keep it alive until they are done.
+    LOCK(cs);
+    // The snapshot cannot be replaced while the lock is held.
+    const MempoolSnapshot *snapshot = m_snapshot.load();
+    if (snapshot && snapshot->m_transactions_updated == nTransactionsUpdated &&
+        snapshot->m_unbroadcast_updated == m_unbroadcast_updated) {
+        return ConstMempoolSnapshotRef::copy(snapshot);
+    }
+
+    ConstMempoolSnapshotRef fresh = ConstMempoolSnapshotRef::make(*this);
+    const MempoolSnapshot *previous = m_snapshot.exchange(
+        ConstMempoolSnapshotRef::copy(fresh.get()).release());
+    if (previous) {
+        ConstMempoolSnapshotRef::acquire(previous);
+    }
+    return fresh;
+}
+
 CTransactionRef CTxMemPool::get(const TxId &txid) const {
     LOCK(cs);
     indexed_transaction_set::const_iterator i = mapTx.find(txid);
@@ -987,19 +1147,25 @@ void CCoinsViewMemPool::PackageAddTransaction(const CTransactionRef &tx) {
 
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
-    // Estimate the overhead of mapTx to be 12 pointers + an allocation, as no
+    // Estimate the overhead of mapTx to be 11 pointers + an allocation, as no
     // exact formula for boost::multi_index_contained is implemented.
     return memusage::MallocUsage(sizeof(CTxMemPoolEntry) +
-                                 12 * sizeof(void *)) *
+                                 11 * sizeof(void *)) *
                mapTx.size() +
            memusage::DynamicUsage(mapNextTx) +
-           memusage::DynamicUsage(mapDeltas) + cachedInnerUsage;
+           memusage::DynamicUsage(mapDeltas) +
+           memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const TxId &txid, const bool unchecked) {
     LOCK(cs);
 
     if (m_unbroadcast_txids.erase(txid)) {
+        auto it = mapTx.find(txid);
+        if (it != mapTx.end()) {
+            it->InvalidateSnapshotEntry();
+        }
+        ++m_unbroadcast_updated;
         LogPrint(
             BCLog::MEMPOOL, "Removed %i from set of unbroadcast txns%s\n",
             txid.GetHex(),
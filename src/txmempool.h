@@ -12,6 +12,7 @@
 #include <indirectmap.h>
 #include <policy/packages.h>
 #include <primitives/transaction.h>
+#include <rcu.h>
 #include <sync.h>
 #include <util/hasher.h>
 
@@ -31,8 +32,11 @@
 
 class CBlockIndex;
 class CChain;
+class CTxMemPool;
 class Chainstate;
 class Config;
+class MempoolSnapshot;
+struct MempoolSnapshotEntry;
 
 extern RecursiveMutex cs_main;
 
@@ -118,6 +122,9 @@ private:
     Amount feeDelta{Amount::zero()};
     //! Track the height and time at which tx was final
     LockPoints lockPoints;
+    //! Copy of the entry in the latest mempool snapshot, reused by the next
+    //! snapshots until the entry changes
+    mutable std::shared_ptr<const MempoolSnapshotEntry> m_snapshot_entry;
 
     // NOTE:
     // The below members will stop being updated after Wellington activation,
@@ -142,6 +149,9 @@ private:
     int64_t nSigChecksWithAncestors;
 
 public:
+    //! Index in the mempool's vTxHashes
+    mutable size_t vTxHashesIdx{0};
+
     CTxMemPoolEntry(const CTransactionRef &_tx, const Amount fee, int64_t time,
                     unsigned int entry_height, bool spends_coinbase,
                     int64_t sigchecks, LockPoints lp);
@@ -200,8 +210,19 @@ public:
 
     const Parents &GetMemPoolParentsConst() const { return m_parents; }
     const Children &GetMemPoolChildrenConst() const { return m_children; }
-    Parents &GetMemPoolParents() const { return m_parents; }
-    Children &GetMemPoolChildren() const { return m_children; }
+    Parents &GetMemPoolParents() const {
+        InvalidateSnapshotEntry();
+        return m_parents;
+    }
+    Children &GetMemPoolChildren() const {
+        InvalidateSnapshotEntry();
+        return m_children;
+    }
+
+    //! Drop the copy of the entry in the mempool snapshots once it changed
+    void InvalidateSnapshotEntry() const { m_snapshot_entry.reset(); }
+
+    friend class MempoolSnapshot;
 };
 
 // extracts a transaction id from CTxMemPoolEntry or CTransactionRef
@@ -223,13 +244,6 @@ struct CompareTxMemPoolEntryByEntryTime {
     }
 };
 
-// used by the entry_id index
-struct CompareTxMemPoolEntryByEntryId {
-    bool operator()(const CTxMemPoolEntry &a, const CTxMemPoolEntry &b) const {
-        return a.GetEntryId() < b.GetEntryId();
-    }
-};
-
 /**
  * \class CompareTxMemPoolEntryByModifiedFeeRate
  *
@@ -283,6 +297,63 @@ struct TxMempoolInfo {
     Amount nFeeDelta;
 };
 
+/**
+ * Copy of the information about a mempool entry, which remains valid after the
+ * entry is modified or removed from the mempool.
+ */
+struct MempoolSnapshotEntry {
+    TxMempoolInfo info;
+    unsigned int height;
+
+    uint64_t count_with_ancestors;
+    uint64_t size_with_ancestors;
+    Amount mod_fees_with_ancestors;
+    uint64_t count_with_descendants;
+    uint64_t size_with_descendants;
+    Amount mod_fees_with_descendants;
+
+    /** The in-mempool parents and children of the transaction. */
+    std::vector<TxId> parents;
+    std::vector<TxId> children;
+
+    /** Whether the initial broadcast of the transaction is unconfirmed. */
+    bool unbroadcast;
+
+    MempoolSnapshotEntry(const CTxMemPoolEntry &entry, bool unbroadcast_in);
+};
+
+/**
+ * Immutable copy of all the mempool entries, in insertion order. The latest
+ * snapshot is shared by CTxMemPool::GetSnapshot() callers, which can iterate
+ * over it without holding the mempool lock. The copies of the entries which
+ * did not change are shared with the previous snapshot.
+ */
+class MempoolSnapshot {
+    std::vector<std::shared_ptr<const MempoolSnapshotEntry>> m_entries;
+    uint64_t m_sequence;
+
+    //! The mempool counters at the time of the snapshot, to find out whether
+    //! it is still up to date.
+    uint32_t m_transactions_updated;
+    uint64_t m_unbroadcast_updated;
+
+    explicit MempoolSnapshot(const CTxMemPool &pool);
+
+    friend class CTxMemPool;
+
+    IMPLEMENT_RCU_REFCOUNT(uint64_t);
+
+public:
+    const std::vector<std::shared_ptr<const MempoolSnapshotEntry>> &
+    GetEntries() const {
+        return m_entries;
+    }
+    /** The mempool sequence number at the time of the snapshot. */
+    uint64_t GetSequence() const { return m_sequence; }
+};
+
+using ConstMempoolSnapshotRef = RCUPtr<const MempoolSnapshot>;
+
 /**
  * Reason why a transaction was removed from the mempool, this is passed to the
  * notification signal.
@@ -358,6 +429,10 @@ private:
     const int m_check_ratio;
     //! Used by getblocktemplate to trigger CreateNewBlock() invocation
     std::atomic<uint32_t> nTransactionsUpdated{0};
+    //! Number of changes to the unbroadcast set
+    std::atomic<uint64_t> m_unbroadcast_updated{0};
+    //! Latest snapshot of the mempool, owned by the mempool
+    mutable std::atomic<const MempoolSnapshot *> m_snapshot{nullptr};
 
     //! sum of all mempool tx's sizes.
     uint64_t totalTxSize GUARDED_BY(cs);
@@ -385,6 +460,8 @@ private:
     //! CTxMemPoolEntry::entryId's
     uint64_t nextEntryId GUARDED_BY(cs) = 1;
 
+    friend class MempoolSnapshot;
+
 public:
     // public only for testing
     static const int ROLLING_FEE_HALFLIFE = 60 * 60 * 12;
@@ -404,11 +481,10 @@ public:
                                  boost::multi_index::tag<entry_time>,
                                  boost::multi_index::identity<CTxMemPoolEntry>,
                                  CompareTxMemPoolEntryByEntryTime>,
-                             // sorted topologically (insertion order)
-                             boost::multi_index::ordered_unique<
-                                 boost::multi_index::tag<entry_id>,
-                                 boost::multi_index::identity<CTxMemPoolEntry>,
-                                 CompareTxMemPoolEntryByEntryId>>>
+                             // sorted topologically (insertion order, which
+                             // is also the entry id order)
+                             boost::multi_index::sequenced<
+                                 boost::multi_index::tag<entry_id>>>>
         indexed_transaction_set;
 
     /**
@@ -480,6 +556,13 @@ private:
 
 public:
     indirectmap<COutPoint, const CTransaction *> mapNextTx GUARDED_BY(cs);
+    /**
+     * The hashes of all the transactions in mapTx along with their entries, in
+     * no particular order. They are stored contiguously so that they can be
+     * scanned quickly, e.g. when computing the short ids of the whole mempool
+     * to reconstruct a compact block.
+     */
+    std::vector<std::pair<TxHash, txiter>> vTxHashes GUARDED_BY(cs);
     std::map<TxId, Amount> mapDeltas GUARDED_BY(cs);
 
     /**
@@ -712,6 +795,14 @@ public:
     CTransactionRef get(const TxId &txid) const;
     TxMempoolInfo info(const TxId &txid) const;
     std::vector<TxMempoolInfo> infoAll() const;
+    /**
+     * Get a snapshot of the mempool, which is up to date with the changes
+     * completed before the call. The snapshot is built again only when the
+     * mempool changed since the previous one, otherwise the mempool lock is
+     * not taken. Rebuilding it only copies the entries which changed, the
+     * other ones are shared with the previous snapshot.
+     */
+    ConstMempoolSnapshotRef GetSnapshot() const;
 
     CFeeRate estimateFee() const;
 
@@ -722,8 +813,10 @@ public:
         LOCK(cs);
         // Sanity check the transaction is in the mempool & insert into
         // unbroadcast set.
-        if (exists(txid)) {
-            m_unbroadcast_txids.insert(txid);
+        auto it = mapTx.find(txid);
+        if (it != mapTx.end() && m_unbroadcast_txids.insert(txid).second) {
+            it->InvalidateSnapshotEntry();
+            ++m_unbroadcast_updated;
         }
     }
 
@@ -773,6 +866,13 @@ private:
         EXCLUSIVE_LOCKS_REQUIRED(cs);
     /** Sever link between specified transaction and direct children. */
     void UpdateChildrenForRemoval(txiter entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /**
+     * Remove the transactions confirmed by a block all at once. The remaining
+     * descendants' ancestor state and parent links are updated once for all
+     * the confirmed transactions, rather than once per transaction.
+     */
+    void RemoveConfirmed(const setEntries &confirmed)
+        EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     /**
      * Before calling removeUnchecked for a given transaction,
@@ -13,6 +13,7 @@
 #include <vector>
 #include <map>
 #include <cassert>
+#include <functional>
 
 #include <utility>        // std::pair
 
@@ -104,6 +105,14 @@ public:
 
     std::string write(unsigned int prettyIndent = 0,
                       unsigned int indentLevel = 0) const;
+    /**
+     * Serialize into chunks of about chunkSize bytes which are passed to sink
+     * as they fill up, so that the whole document is never held in a single
+     * string. String values are not split across chunks.
+     */
+    void write(const std::function<void(const std::string&)>& sink,
+               size_t chunkSize, unsigned int prettyIndent = 0,
+               unsigned int indentLevel = 0) const;
 
     bool read(const char *raw, size_t len);
     bool read(const char *raw) { return read(raw, strlen(raw)); }
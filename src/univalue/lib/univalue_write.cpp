@@ -12,11 +12,31 @@
 namespace {
 struct UniValueStreamWriter {
     std::string str;
+    const std::function<void(const std::string&)>* sink;
+    size_t chunkSize;
 
-    UniValueStreamWriter() {
+    UniValueStreamWriter() : sink(nullptr), chunkSize(0) {
         str.reserve(1024);
     }
 
+    UniValueStreamWriter(const std::function<void(const std::string&)>& sinkIn,
+                         size_t chunkSizeIn)
+        : sink(&sinkIn), chunkSize(chunkSizeIn) {
+        str.reserve(chunkSize);
+    }
+
+    void flush() {
+        if (sink && !str.empty()) {
+            (*sink)(str);
+            str.clear();
+        }
+    }
+    void maybeFlush() {
+        if (sink && str.size() >= chunkSize) {
+            flush();
+        }
+    }
+
     std::string getString() {
 #if __cplusplus >= 201103L
         return std::move(str);
@@ -92,6 +112,7 @@ void UniValueStreamWriter::writeAny(unsigned int prettyIndent, unsigned int inde
         write(obj.val == "1" ? "true" : "false");
         break;
     }
+    maybeFlush();
 }
 
 void UniValueStreamWriter::writeArray(unsigned int prettyIndent, unsigned int indentLevel, const UniValue &obj) {
@@ -161,3 +182,11 @@ std::string UniValue::write(unsigned int prettyIndent, unsigned int indentLevel)
     ss.writeAny(prettyIndent, indentLevel, *this);
     return ss.getString();
 }
+
+void UniValue::write(const std::function<void(const std::string&)>& sink,
+                     size_t chunkSize, unsigned int prettyIndent,
+                     unsigned int indentLevel) const {
+    UniValueStreamWriter ss(sink, chunkSize);
+    ss.writeAny(prettyIndent, indentLevel, *this);
+    ss.flush();
+}
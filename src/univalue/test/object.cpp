@@ -398,6 +398,33 @@ BOOST_AUTO_TEST_CASE(univalue_readwrite)
     BOOST_CHECK(!v.read("{} 42"));
 }
 
+BOOST_AUTO_TEST_CASE(univalue_writechunks)
+{
+    UniValue v;
+    BOOST_CHECK(v.read(json1));
+
+    for (size_t chunkSize : {1, 8, 1000}) {
+        for (unsigned int prettyIndent : {0, 4}) {
+            std::vector<std::string> chunks;
+            v.write([&](const std::string& chunk) { chunks.push_back(chunk); },
+                    chunkSize, prettyIndent);
+            BOOST_CHECK(!chunks.empty());
+
+            std::string joined;
+            for (const std::string& chunk : chunks) {
+                BOOST_CHECK(!chunk.empty());
+                joined += chunk;
+            }
+            BOOST_CHECK_EQUAL(joined, v.write(prettyIndent));
+            if (chunkSize > joined.size()) {
+                BOOST_CHECK_EQUAL(chunks.size(), 1);
+            } else {
+                BOOST_CHECK(chunks.size() > 1);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 int main (int argc, char *argv[])
@@ -408,6 +435,7 @@ int main (int argc, char *argv[])
     univalue_array();
     univalue_object();
     univalue_readwrite();
+    univalue_writechunks();
     return 0;
 }
 
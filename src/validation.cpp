@@ -118,6 +118,9 @@ uint256 g_best_block;
 bool fRequireStandard = true;
 bool fCheckBlockIndex = false;
 bool fCheckpointsEnabled = DEFAULT_CHECKPOINTS_ENABLED;
+bool fParallelInputFetch = DEFAULT_PARALLEL_INPUT_FETCH;
+bool fBackgroundCoinsFlush = DEFAULT_BACKGROUND_COINS_FLUSH;
+bool fPrefetchCoins = DEFAULT_PREFETCH_COINS;
 int64_t nMaxTipAge = DEFAULT_MAX_TIP_AGE;
 
 BlockHash hashAssumeValid;
@@ -290,6 +293,8 @@ static bool CheckInputsFromMempoolAndCache(
                              /*scriptCacheStore=*/true, txdata, nSigChecksOut);
 }
 
+static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+
 namespace {
 
 class MemPoolAccept {
@@ -406,6 +411,16 @@ public:
                                              ATMPArgs &args)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Acceptance of a batch of transactions received together. Each
+     * transaction is accepted or rejected on its own, in order. The script
+     * checks of the transactions which don't depend on or conflict with an
+     * earlier transaction of the batch are run concurrently.
+     */
+    std::vector<MempoolAcceptResult>
+    AcceptTransactionBatch(const std::vector<CTransactionRef> &txns,
+                           ATMPArgs &args) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 private:
     // All the intermediate state that gets passed between the various levels
     // of checking a given transaction.
@@ -441,6 +456,10 @@ private:
          */
         Amount m_modified_fees;
 
+        /** Lock points and coinbase spending, for the mempool entry. */
+        LockPoints m_lock_points;
+        bool m_spends_coinbase{false};
+
         const CTransactionRef &m_ptx;
         TxValidationState m_state;
         /**
@@ -454,6 +473,11 @@ private:
         // ConsensusScriptChecks
         const uint32_t m_next_block_script_verify_flags;
         int m_sig_checks_standard;
+        /**
+         * Sigchecks accounted by the script checks with the standard flags,
+         * which may run after PolicyScriptChecks() returns.
+         */
+        TxSigCheckLimiter m_sig_checks_limiter;
     };
 
     // Run the policy checks on a given transaction, excluding any script
@@ -464,6 +488,19 @@ private:
     bool PreChecks(ATMPArgs &args, Workspace &ws)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
+    // Run the script checks against the standard script flags. If pvChecks is
+    // not null, the checks which are not in the script cache are appended to
+    // it instead of being run, and m_sig_checks_standard is only known once
+    // they have all been run.
+    bool PolicyScriptChecks(Workspace &ws,
+                            std::vector<CScriptCheck> *pvChecks = nullptr)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
+    // Build the mempool entry once the scripts have been checked, and run the
+    // checks that depend on its virtual size and on its mempool ancestors.
+    bool MempoolEntryChecks(const ATMPArgs &args, Workspace &ws)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
     // Enforce package mempool ancestor/descendant limits (distinct from
     // individual ancestor/descendant limits done in PreChecks).
     bool PackageMempoolChecks(const std::vector<CTransactionRef> &txns,
@@ -514,19 +551,15 @@ private:
 bool MemPoolAccept::PreChecks(ATMPArgs &args, Workspace &ws) {
     AssertLockHeld(cs_main);
     AssertLockHeld(m_pool.cs);
-    const CTransactionRef &ptx = ws.m_ptx;
     const CTransaction &tx = *ws.m_ptx;
     const TxId &txid = ws.m_ptx->GetId();
 
     // Copy/alias what we need out of args
-    const int64_t nAcceptTime = args.m_accept_time;
     const bool bypass_limits = args.m_bypass_limits;
     std::vector<COutPoint> &coins_to_uncache = args.m_coins_to_uncache;
-    const unsigned int heightOverride = args.m_heightOverride;
 
     // Alias what we need out of ws
     TxValidationState &state = ws.m_state;
-    std::unique_ptr<CTxMemPoolEntry> &entry = ws.m_entry;
     // Coinbase is only valid in a block, not as a loose transaction.
     if (!CheckRegularTransaction(tx, state)) {
         // state filled in by CheckRegularTransaction.
@@ -569,7 +602,6 @@ bool MemPoolAccept::PreChecks(ATMPArgs &args, Workspace &ws) {
         }
     }
 
-    LockPoints lp;
     m_view.SetBackend(m_viewmempool);
 
     const CCoinsViewCache &coins_cache = m_active_chainstate.CoinsTip();
@@ -625,7 +657,7 @@ bool MemPoolAccept::PreChecks(ATMPArgs &args, Workspace &ws) {
     // since m_view's backend was removed, it no longer pulls coins from the
     // mempool.
     if (!CheckSequenceLocksAtTip(m_active_chainstate.m_chain.Tip(), m_view, tx,
-                                 &lp)) {
+                                 &ws.m_lock_points)) {
         return state.Invalid(TxValidationResult::TX_PREMATURE_SPEND,
                              "non-BIP68-final");
     }
@@ -652,11 +684,10 @@ bool MemPoolAccept::PreChecks(ATMPArgs &args, Workspace &ws) {
 
     // Keep track of transactions that spend a coinbase, which we re-scan
     // during reorgs to ensure COINBASE_MATURITY is still met.
-    bool fSpendsCoinbase = false;
     for (const CTxIn &txin : tx.vin) {
         const Coin &coin = m_view.AccessCoin(txin.prevout);
         if (coin.IsCoinBase()) {
-            fSpendsCoinbase = true;
+            ws.m_spends_coinbase = true;
             break;
         }
     }
@@ -674,20 +705,43 @@ bool MemPoolAccept::PreChecks(ATMPArgs &args, Workspace &ws) {
                                        ::minRelayTxFee.GetFee(nSize)));
     }
 
+    return true;
+}
+
+bool MemPoolAccept::PolicyScriptChecks(Workspace &ws,
+                                       std::vector<CScriptCheck> *pvChecks) {
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
+    const CTransaction &tx = *ws.m_ptx;
+
     // Validate input scripts against standard script flags.
     const uint32_t scriptVerifyFlags =
         ws.m_next_block_script_verify_flags | STANDARD_SCRIPT_VERIFY_FLAGS;
     ws.m_precomputed_txdata = PrecomputedTransactionData{tx};
-    if (!CheckInputScripts(tx, state, m_view, scriptVerifyFlags, true, false,
-                           ws.m_precomputed_txdata, ws.m_sig_checks_standard)) {
+    ws.m_sig_checks_limiter = TxSigCheckLimiter();
+    if (!CheckInputScripts(tx, ws.m_state, m_view, scriptVerifyFlags, true,
+                           false, ws.m_precomputed_txdata,
+                           ws.m_sig_checks_standard, ws.m_sig_checks_limiter,
+                           nullptr, pvChecks)) {
         // State filled in by CheckInputScripts
         return false;
     }
+    return true;
+}
+
+bool MemPoolAccept::MempoolEntryChecks(const ATMPArgs &args, Workspace &ws) {
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
+    const CTransactionRef &ptx = ws.m_ptx;
+    TxValidationState &state = ws.m_state;
+    std::unique_ptr<CTxMemPoolEntry> &entry = ws.m_entry;
+    const bool bypass_limits = args.m_bypass_limits;
+    const unsigned int heightOverride = args.m_heightOverride;
 
     entry.reset(new CTxMemPoolEntry(
-        ptx, ws.m_base_fees, nAcceptTime,
+        ptx, ws.m_base_fees, args.m_accept_time,
         heightOverride ? heightOverride : m_active_chainstate.m_chain.Height(),
-        fSpendsCoinbase, ws.m_sig_checks_standard, lp));
+        ws.m_spends_coinbase, ws.m_sig_checks_standard, ws.m_lock_points));
 
     ws.m_vsize = entry->GetTxVirtualSize();
 
@@ -931,7 +985,8 @@ MemPoolAccept::AcceptSingleTransaction(const CTransactionRef &ptx,
     // Perform the inexpensive checks first and avoid hashing and signature
     // verification unless those checks pass, to mitigate CPU exhaustion
     // denial-of-service attacks.
-    if (!PreChecks(args, ws)) {
+    if (!PreChecks(args, ws) || !PolicyScriptChecks(ws) ||
+        !MempoolEntryChecks(args, ws)) {
         return MempoolAcceptResult::Failure(ws.m_state);
     }
 
@@ -1003,7 +1058,8 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(
     // Do all PreChecks first and fail fast to avoid running expensive script
     // checks when unnecessary.
     for (Workspace &ws : workspaces) {
-        if (!PreChecks(args, ws)) {
+        if (!PreChecks(args, ws) || !PolicyScriptChecks(ws) ||
+            !MempoolEntryChecks(args, ws)) {
             package_state.Invalid(PackageValidationResult::PCKG_TX,
                                   "transaction failed");
             // Exit early to avoid doing pointless work. Update the failed tx
@@ -1158,6 +1214,128 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptPackage(const Package &package,
     }
     return submission_result;
 }
+
+std::vector<MempoolAcceptResult>
+MemPoolAccept::AcceptTransactionBatch(const std::vector<CTransactionRef> &txns,
+                                      ATMPArgs &args) {
+    AssertLockHeld(cs_main);
+    LOCK(m_pool.cs);
+
+    const Consensus::Params &consensusParams =
+        args.m_config.GetChainParams().GetConsensus();
+    const CBlockIndex *tip = m_active_chainstate.m_chain.Tip();
+    // See AcceptSingleTransaction().
+    m_pool.wellingtonLatched =
+        m_pool.wellingtonLatched || IsWellingtonEnabled(consensusParams, tip);
+    const uint32_t next_block_script_verify_flags =
+        GetNextBlockScriptFlags(consensusParams, tip);
+
+    std::vector<std::optional<MempoolAcceptResult>> results(txns.size());
+    // The script checks hold pointers to the workspaces, so they must not be
+    // reallocated.
+    std::vector<Workspace> workspaces;
+    workspaces.reserve(txns.size());
+    std::vector<size_t> workspace_indexes;
+    std::vector<CScriptCheck> checks;
+
+    // Transactions spending an output of, or conflicting with, an earlier
+    // transaction of the batch can only be checked once the earlier one is in
+    // the mempool. They are accepted one at a time at the end.
+    std::vector<size_t> deferred;
+    std::set<TxId> batch_txids;
+    std::set<COutPoint> batch_spent;
+
+    // Run the inexpensive checks first, and collect the script checks of the
+    // transactions that pass them.
+    for (size_t i = 0; i < txns.size(); ++i) {
+        const CTransaction &tx = *txns[i];
+        const bool depends_on_batch =
+            std::any_of(tx.vin.begin(), tx.vin.end(), [&](const CTxIn &txin) {
+                return batch_txids.count(txin.prevout.GetTxId()) ||
+                       batch_spent.count(txin.prevout);
+            });
+        batch_txids.insert(tx.GetId());
+        for (const CTxIn &txin : tx.vin) {
+            batch_spent.insert(txin.prevout);
+        }
+        if (depends_on_batch) {
+            deferred.push_back(i);
+            continue;
+        }
+
+        Workspace &ws =
+            workspaces.emplace_back(txns[i], next_block_script_verify_flags);
+        if (!PreChecks(args, ws) || !PolicyScriptChecks(ws, &checks)) {
+            results[i].emplace(MempoolAcceptResult::Failure(ws.m_state));
+            workspaces.pop_back();
+            continue;
+        }
+        workspace_indexes.push_back(i);
+    }
+
+    // The script check queue is only used while holding cs_main, so it is
+    // available.
+    bool scripts_valid;
+    {
+        CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+        control.Add(checks);
+        scripts_valid = control.Wait();
+    }
+
+    bool evicted = false;
+    for (size_t j = 0; j < workspaces.size(); ++j) {
+        Workspace &ws = workspaces[j];
+        const size_t i = workspace_indexes[j];
+
+        // Trimming the mempool may have evicted the parents of the remaining
+        // transactions, they need to be looked up again.
+        if (evicted) {
+            deferred.push_back(i);
+            continue;
+        }
+
+        if (scripts_valid) {
+            ws.m_sig_checks_standard = ws.m_sig_checks_limiter.GetConsumed();
+        } else if (!PolicyScriptChecks(ws)) {
+            // Run the checks again one transaction at a time to find out which
+            // ones failed and why. The valid signatures are in the signature
+            // cache by now.
+            results[i].emplace(MempoolAcceptResult::Failure(ws.m_state));
+            continue;
+        }
+
+        if (!MempoolEntryChecks(args, ws) || !ConsensusScriptChecks(args, ws)) {
+            results[i].emplace(MempoolAcceptResult::Failure(ws.m_state));
+            continue;
+        }
+
+        const size_t pool_size = m_pool.size();
+        if (!Finalize(args, ws)) {
+            results[i].emplace(MempoolAcceptResult::Failure(ws.m_state));
+        } else {
+            GetMainSignals().TransactionAddedToMempool(
+                ws.m_ptx, m_pool.GetAndIncrementSequence());
+            results[i].emplace(
+                MempoolAcceptResult::Success(ws.m_vsize, ws.m_base_fees));
+        }
+        evicted = m_pool.size() != pool_size + 1;
+    }
+
+    std::sort(deferred.begin(), deferred.end());
+    for (const size_t i : deferred) {
+        // Use a fresh view, the coins cached in m_view may have been spent or
+        // evicted in the meantime.
+        results[i].emplace(MemPoolAccept(m_pool, m_active_chainstate)
+                               .AcceptSingleTransaction(txns[i], args));
+    }
+
+    std::vector<MempoolAcceptResult> batch_results;
+    batch_results.reserve(txns.size());
+    for (std::optional<MempoolAcceptResult> &result : results) {
+        batch_results.push_back(std::move(*result));
+    }
+    return batch_results;
+}
 } // namespace
 
 MempoolAcceptResult AcceptToMemoryPool(const Config &config,
@@ -1195,6 +1373,45 @@ MempoolAcceptResult AcceptToMemoryPool(const Config &config,
     return result;
 }
 
+std::vector<MempoolAcceptResult>
+AcceptTransactionsToMemoryPool(const Config &config,
+                               Chainstate &active_chainstate,
+                               const std::vector<CTransactionRef> &txns,
+                               int64_t accept_time) {
+    AssertLockHeld(::cs_main);
+    assert(active_chainstate.GetMempool() != nullptr);
+    CTxMemPool &pool{*active_chainstate.GetMempool()};
+
+    std::vector<COutPoint> coins_to_uncache;
+    auto args = MemPoolAccept::ATMPArgs::SingleAccept(
+        config, accept_time, /*bypass_limits=*/false, coins_to_uncache,
+        /*test_accept=*/false, /*heightOverride=*/0);
+    std::vector<MempoolAcceptResult> results =
+        MemPoolAccept(pool, active_chainstate)
+            .AcceptTransactionBatch(txns, args);
+
+    // Remove the coins that were brought into the coins cache for the
+    // transactions that were rejected, see AcceptToMemoryPool().
+    std::set<COutPoint> accepted_inputs;
+    for (size_t i = 0; i < txns.size(); ++i) {
+        if (results[i].m_result_type ==
+            MempoolAcceptResult::ResultType::VALID) {
+            for (const CTxIn &txin : txns[i]->vin) {
+                accepted_inputs.insert(txin.prevout);
+            }
+        }
+    }
+    for (const COutPoint &outpoint : coins_to_uncache) {
+        if (!accepted_inputs.count(outpoint)) {
+            active_chainstate.CoinsTip().Uncache(outpoint);
+        }
+    }
+
+    BlockValidationState stateDummy;
+    active_chainstate.FlushStateToDisk(stateDummy, FlushStateMode::PERIODIC);
+    return results;
+}
+
 PackageMempoolAcceptResult
 ProcessNewPackage(const Config &config, Chainstate &active_chainstate,
                   CTxMemPool &pool, const Package &package, bool test_accept) {
@@ -1246,14 +1463,16 @@ Amount GetBlockSubsidy(int nHeight, const Consensus::Params &consensusParams) {
 }
 
 CoinsViews::CoinsViews(std::string ldb_name, size_t cache_size_bytes,
-                       bool in_memory, bool should_wipe)
+                       bool in_memory, bool should_wipe,
+                       const Consensus::Params &params)
     : m_dbview(gArgs.GetDataDirNet() / ldb_name, cache_size_bytes, in_memory,
                should_wipe),
-      m_catcherview(&m_dbview) {}
+      m_catcherview(&m_dbview), m_flushview(&m_catcherview, m_dbview),
+      m_prefetcher(m_flushview, params) {}
 
 void CoinsViews::InitCache() {
     AssertLockHeld(::cs_main);
-    m_cacheview = std::make_unique<CCoinsViewCache>(&m_catcherview);
+    m_cacheview = std::make_unique<CCoinsViewCache>(&m_flushview);
 }
 
 Chainstate::Chainstate(CTxMemPool *mempool, BlockManager &blockman,
@@ -1268,8 +1487,9 @@ void Chainstate::InitCoinsDB(size_t cache_size_bytes, bool in_memory,
     if (m_from_snapshot_blockhash) {
         leveldb_name += "_" + m_from_snapshot_blockhash->ToString();
     }
-    m_coins_views = std::make_unique<CoinsViews>(leveldb_name, cache_size_bytes,
-                                                 in_memory, should_wipe);
+    m_coins_views =
+        std::make_unique<CoinsViews>(leveldb_name, cache_size_bytes, in_memory,
+                                     should_wipe, m_params.GetConsensus());
 }
 
 void Chainstate::InitCoinsCache(size_t cache_size_bytes) {
@@ -1479,14 +1699,16 @@ void UpdateCoins(CCoinsViewCache &view, const CTransaction &tx, CTxUndo &txundo,
     AddCoins(view, tx, nHeight);
 }
 
-bool CScriptCheck::operator()() {
+bool CScriptCheck::EvalScript(SchnorrBatchVerifier *batch) {
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
-    if (!VerifyScript(scriptSig, m_tx_out.scriptPubKey, nFlags,
-                      CachingTransactionSignatureChecker(
-                          ptxTo, nIn, m_tx_out.nValue, cacheStore, txdata),
-                      metrics, &error)) {
-        return false;
-    }
+    return VerifyScript(scriptSig, m_tx_out.scriptPubKey, nFlags,
+                        CachingTransactionSignatureChecker(
+                            ptxTo, nIn, m_tx_out.nValue, cacheStore, txdata,
+                            batch),
+                        metrics, &error);
+}
+
+bool CScriptCheck::ConsumeSigChecks() {
     if ((pTxLimitSigChecks &&
          !pTxLimitSigChecks->consume_and_check(metrics.nSigChecks)) ||
         (pBlockLimitSigChecks &&
@@ -1500,6 +1722,56 @@ bool CScriptCheck::operator()() {
     return true;
 }
 
+bool CScriptCheck::operator()() {
+    return EvalScript(nullptr) && ConsumeSigChecks();
+}
+
+bool CScriptCheck::RunBatch(std::vector<CScriptCheck> &checks) {
+    SchnorrBatchVerifier batch;
+    std::vector<CScriptCheck *> batched;
+    batched.reserve(checks.size());
+
+    for (CScriptCheck &check : checks) {
+        // Assuming a signature is valid is only safe if an invalid one would
+        // make the script fail, which is what NULLFAIL guarantees: a 64 bytes
+        // signature is always a Schnorr one and can never be checked by the
+        // legacy multisig, which is the only place where a failing check is
+        // tolerated. The results are also never stored into the cache.
+        if (!(check.nFlags & SCRIPT_VERIFY_NULLFAIL) || check.cacheStore) {
+            if (!check()) {
+                return false;
+            }
+            continue;
+        }
+
+        if (!check.EvalScript(&batch)) {
+            // The script fails even if all the queued signatures are valid,
+            // and with NULLFAIL any invalid signature would fail it too.
+            // Evaluate it again without batching to get the actual error.
+            return check();
+        }
+        batched.push_back(&check);
+    }
+
+    if (!batch.Verify()) {
+        // At least one signature is invalid. Fall back to checking the
+        // scripts one by one. Their sigchecks have not been consumed yet.
+        for (CScriptCheck *check : batched) {
+            if (!(*check)()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    for (CScriptCheck *check : batched) {
+        if (!check->ConsumeSigChecks()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool CheckInputScripts(const CTransaction &tx, TxValidationState &state,
                        const CCoinsViewCache &inputs, const uint32_t flags,
                        bool sigCacheStore, bool scriptCacheStore,
@@ -1727,14 +1999,110 @@ DisconnectResult ApplyBlockUndo(const CBlockUndo &blockUndo,
     return fClean ? DisconnectResult::OK : DisconnectResult::UNCLEAN;
 }
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+namespace {
+/**
+ * Closure representing the lookup of a single coin in the UTXO database.
+ * Lookups never fail: a coin that cannot be found is left spent, and the
+ * missing input is reported later on by Consensus::CheckTxInputs().
+ */
+class CCoinFetchCheck {
+private:
+    const CCoinsView *m_db{nullptr};
+    COutPoint m_outpoint;
+    Coin *m_coin{nullptr};
+
+public:
+    CCoinFetchCheck() = default;
+    CCoinFetchCheck(const CCoinsView &db, const COutPoint &outpoint,
+                    Coin &coin)
+        : m_db(&db), m_outpoint(outpoint), m_coin(&coin) {}
+
+    bool operator()() {
+        if (!m_db->GetCoin(m_outpoint, *m_coin)) {
+            m_coin->Clear();
+        }
+        return true;
+    }
+
+    void swap(CCoinFetchCheck &check) {
+        std::swap(m_db, check.m_db);
+        std::swap(m_outpoint, check.m_outpoint);
+        std::swap(m_coin, check.m_coin);
+    }
+};
+} // namespace
+
+/**
+ * The coin fetch threads are only busy while ConnectBlock() waits for the
+ * inputs of a block, before any script check is queued, so the two pools are
+ * never runnable at the same time. A single fetch is much cheaper than a
+ * script check, so the threads would mostly contend on the lock of a shared
+ * CCheckQueue: each of them takes its fetches from its own queue instead.
+ */
+static WorkStealingCheckQueue<CCoinFetchCheck> coinfetchqueue(128);
 
 void StartScriptCheckWorkerThreads(int threads_num) {
     scriptcheckqueue.StartWorkerThreads(threads_num);
+    coinfetchqueue.StartWorkerThreads(
+        std::min(threads_num, MAX_INPUT_FETCH_THREADS), "inputfetch");
 }
 
 void StopScriptCheckWorkerThreads() {
     scriptcheckqueue.StopWorkerThreads();
+    coinfetchqueue.StopWorkerThreads();
+}
+
+/**
+ * Load the coins spent by the block into the coins tip cache, reading them
+ * from the database on the worker threads.
+ *
+ * The database reads are independent from each other and LevelDB supports
+ * concurrent readers, so they can be sharded across threads while the caller
+ * holds cs_main. db must be the view right below the tip cache, so that coins
+ * still being written by a background flush are read from memory rather than
+ * from a partially updated database. The cache itself is not
+ * thread safe and is only updated from the calling thread once all the reads
+ * are done. Outputs created by the block itself must already be in the view.
+ */
+static void FetchBlockInputs(const CBlock &block, const CCoinsViewCache &view,
+                             CCoinsViewCache &tip, const CCoinsView &db) {
+    std::vector<COutPoint> outpoints;
+    for (const auto &ptx : block.vtx) {
+        if (ptx->IsCoinBase()) {
+            continue;
+        }
+        for (const CTxIn &in : ptx->vin) {
+            if (!view.HaveCoinInCache(in.prevout) &&
+                !tip.HaveCoinInCache(in.prevout)) {
+                outpoints.push_back(in.prevout);
+            }
+        }
+    }
+
+    if (outpoints.empty()) {
+        return;
+    }
+
+    std::vector<Coin> coins(outpoints.size());
+    {
+        std::vector<CCoinFetchCheck> vChecks;
+        vChecks.reserve(outpoints.size());
+        for (size_t i = 0; i < outpoints.size(); i++) {
+            vChecks.emplace_back(db, outpoints[i], coins[i]);
+        }
+
+        CCheckQueueControl<CCoinFetchCheck,
+                           WorkStealingCheckQueue<CCoinFetchCheck>>
+            control(&coinfetchqueue);
+        control.Add(vChecks);
+        control.Wait();
+    }
+
+    for (size_t i = 0; i < outpoints.size(); i++) {
+        if (!coins[i].IsSpent()) {
+            tip.InsertFetchedCoin(outpoints[i], std::move(coins[i]));
+        }
+    }
 }
 
 // Returns the script flags which should be checked for the block after
@@ -2086,6 +2454,17 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
                              "tx-duplicate");
     }
 
+    // Move the coins looked up ahead of time for this block into the cache,
+    // so that only the remaining ones have to be fetched below.
+    m_coins_views->m_prefetcher.TakeCoins(pindex->GetBlockHash(), CoinsTip());
+
+    // With canonical transaction ordering the inputs can be fetched in any
+    // order once all the outputs of the block have been added, so fetch the
+    // missing ones in parallel before the spends are processed serially.
+    if (fParallelInputFetch && coinfetchqueue.HasThreads()) {
+        FetchBlockInputs(block, view, CoinsTip(), m_coins_views->m_flushview);
+    }
+
     size_t txIndex = 0;
     // nSigChecksRet may be accurate (found in cache) or 0 (checks were
     // deferred into vChecks).
@@ -2268,7 +2647,9 @@ Chainstate::GetCoinsCacheSizeState(size_t max_coins_cache_size_bytes,
                                    size_t max_mempool_size_bytes) {
     AssertLockHeld(::cs_main);
     int64_t nMempoolUsage = m_mempool ? m_mempool->DynamicMemoryUsage() : 0;
-    int64_t cacheSize = CoinsTip().DynamicMemoryUsage();
+    // The coins of a background flush stay in memory until they are written.
+    int64_t cacheSize = CoinsTip().DynamicMemoryUsage() +
+                        m_coins_views->m_flushview.DynamicMemoryUsage();
     int64_t nTotalSpace =
         max_coins_cache_size_bytes +
         std::max<int64_t>(int64_t(max_mempool_size_bytes) - nMempoolUsage, 0);
@@ -2301,6 +2682,11 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
     const size_t coins_count = CoinsTip().GetCacheSize();
     const size_t coins_mem_usage = CoinsTip().DynamicMemoryUsage();
 
+    CCoinsViewBackgroundFlush &flush_view = m_coins_views->m_flushview;
+    if (flush_view.HasFailed()) {
+        return AbortNode(state, "Failed to write to coin database");
+    }
+
     try {
         {
             bool fFlushForPrune = false;
@@ -2398,8 +2784,14 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
                     }
                 }
 
-                // Finally remove any pruned files
+                // Finally remove any pruned files, once a pending background
+                // write that may need them to be replayed has completed.
                 if (fFlushForPrune) {
+                    if (!flush_view.WaitForFlush()) {
+                        return AbortNode(state,
+                                         "Failed to write to coin database");
+                    }
+
                     LOG_TIME_MILLIS_WITH_CATEGORY("unlink pruned files",
                                                   BCLog::BENCH);
 
@@ -2428,8 +2820,18 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
                 }
 
                 // Flush the chainstate (which may refer to block index
-                // entries).
-                if (!CoinsTip().Flush()) {
+                // entries). Unless the caller needs the database to be up to
+                // date or we are about to prune block files that a replay of
+                // the write could need, the write happens in the background
+                // and only the handover of the entries blocks here.
+                const bool background =
+                    fBackgroundCoinsFlush && !fFlushForPrune &&
+                    (mode == FlushStateMode::IF_NEEDED ||
+                     mode == FlushStateMode::PERIODIC);
+                flush_view.SetBackground(background, coins_mem_usage);
+                const bool flushed = CoinsTip().Flush();
+                flush_view.SetBackground(false);
+                if (!flushed) {
                     return AbortNode(state, "Failed to write to coin database");
                 }
                 nLastFlush = nNow;
@@ -2671,14 +3073,22 @@ bool Chainstate::ConnectTip(const Config &config, BlockValidationState &state,
     // Read block from disk.
     int64_t nTime1 = GetTimeMicros();
     std::shared_ptr<const CBlock> pthisBlock;
+    bool prefetched = false;
     if (!pblock) {
+        // The block may have been read ahead while the previous ones were
+        // being connected.
+        pthisBlock =
+            m_coins_views->m_prefetcher.TakeBlock(pindexNew->GetBlockHash());
+        prefetched = pthisBlock != nullptr;
+    } else {
+        pthisBlock = pblock;
+    }
+    if (!pthisBlock) {
         std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
         if (!ReadBlockFromDisk(*pblockNew, pindexNew, consensusParams)) {
             return AbortNode(state, "Failed to read block");
         }
         pthisBlock = pblockNew;
-    } else {
-        pthisBlock = pblock;
     }
 
     const CBlock &blockConnecting = *pthisBlock;
@@ -2687,8 +3097,9 @@ bool Chainstate::ConnectTip(const Config &config, BlockValidationState &state,
     int64_t nTime2 = GetTimeMicros();
     nTimeReadFromDisk += nTime2 - nTime1;
     int64_t nTime3;
-    LogPrint(BCLog::BENCH, "  - Load block from disk: %.2fms [%.2fs]\n",
-             (nTime2 - nTime1) * MILLI, nTimeReadFromDisk * MICRO);
+    LogPrint(BCLog::BENCH, "  - Load block from disk: %.2fms [%.2fs]%s\n",
+             (nTime2 - nTime1) * MILLI, nTimeReadFromDisk * MICRO,
+             prefetched ? " (prefetched)" : "");
     {
         Amount blockFees{Amount::zero()};
         CCoinsViewCache view(&CoinsTip());
@@ -3068,6 +3479,22 @@ bool Chainstate::ActivateBestChainStep(
 
         nHeight = nTargetHeight;
 
+        // Read the blocks to connect and look up the coins they spend ahead of
+        // time.
+        if (fPrefetchCoins) {
+            std::vector<std::pair<BlockHash, FlatFilePos>> to_prefetch;
+            for (const CBlockIndex *pindex :
+                 reverse_iterate(vpindexToConnect)) {
+                if (!pindex->nStatus.hasData()) {
+                    break;
+                }
+                to_prefetch.emplace_back(pindex->GetBlockHash(),
+                                         pindex->GetBlockPos());
+            }
+            m_coins_views->m_prefetcher.Prefetch(to_prefetch,
+                                                 config.GetMaxBlockSize());
+        }
+
         // Connect new blocks.
         for (CBlockIndex *pindexConnect : reverse_iterate(vpindexToConnect)) {
             BlockPolicyValidationState blockPolicyState;
@@ -4541,6 +4968,24 @@ ChainstateManager::ProcessTransaction(const CTransactionRef &tx,
     return result;
 }
 
+std::vector<MempoolAcceptResult>
+ChainstateManager::ProcessTransactions(
+    const std::vector<CTransactionRef> &txns) {
+    AssertLockHeld(cs_main);
+    Chainstate &active_chainstate = ActiveChainstate();
+    if (!active_chainstate.GetMempool()) {
+        TxValidationState state;
+        state.Invalid(TxValidationResult::TX_NO_MEMPOOL, "no-mempool");
+        return std::vector<MempoolAcceptResult>(
+            txns.size(), MempoolAcceptResult::Failure(state));
+    }
+    auto results = AcceptTransactionsToMemoryPool(
+        ::GetConfig(), active_chainstate, txns, GetTime());
+    active_chainstate.GetMempool()->check(
+        active_chainstate.CoinsTip(), active_chainstate.m_chain.Height() + 1);
+    return results;
+}
+
 bool TestBlockValidity(BlockValidationState &state, const CChainParams &params,
                        Chainstate &chainstate, const CBlock &block,
                        CBlockIndex *pindexPrev,
@@ -5095,15 +5540,9 @@ bool Chainstate::LoadGenesisBlock() {
     return true;
 }
 
-void Chainstate::LoadExternalBlockFile(const Config &config, FILE *fileIn,
-                                       FlatFilePos *dbp) {
-    AssertLockNotHeld(m_chainstate_mutex);
-    // Map of disk positions for blocks with unknown parent (only used for
-    // reindex)
-    static std::multimap<uint256, FlatFilePos> mapBlocksUnknownParent;
-    int64_t nStart = GetTimeMillis();
-
-    int nLoaded = 0;
+void ReadExternalBlockFile(
+    FILE *fileIn, const CChainParams &params, FlatFilePos *dbp,
+    const std::function<bool(const std::shared_ptr<CBlock> &)> &fn) {
     try {
         // This takes over fileIn and calls fclose() on it in the CBufferedFile
         // destructor. Make sure we have at least 2*MAX_TX_SIZE space in there
@@ -5125,10 +5564,10 @@ void Chainstate::LoadExternalBlockFile(const Config &config, FILE *fileIn,
             try {
                 // Locate a header.
                 uint8_t buf[CMessageHeader::MESSAGE_START_SIZE];
-                blkdat.FindByte(char(m_params.DiskMagic()[0]));
+                blkdat.FindByte(char(params.DiskMagic()[0]));
                 nRewind = blkdat.GetPos() + 1;
                 blkdat >> buf;
-                if (memcmp(buf, m_params.DiskMagic().data(),
+                if (memcmp(buf, params.DiskMagic().data(),
                            CMessageHeader::MESSAGE_START_SIZE)) {
                     continue;
                 }
@@ -5151,95 +5590,11 @@ void Chainstate::LoadExternalBlockFile(const Config &config, FILE *fileIn,
                 }
                 blkdat.SetLimit(nBlockPos + nSize);
                 std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-                CBlock &block = *pblock;
-                blkdat >> block;
+                blkdat >> *pblock;
                 nRewind = blkdat.GetPos();
 
-                const BlockHash hash = block.GetHash();
-                {
-                    LOCK(cs_main);
-                    // detect out of order blocks, and store them for later
-                    if (hash != m_params.GetConsensus().hashGenesisBlock &&
-                        !m_blockman.LookupBlockIndex(block.hashPrevBlock)) {
-                        LogPrint(
-                            BCLog::REINDEX,
-                            "%s: Out of order block %s, parent %s not known\n",
-                            __func__, hash.ToString(),
-                            block.hashPrevBlock.ToString());
-                        if (dbp) {
-                            mapBlocksUnknownParent.insert(
-                                std::make_pair(block.hashPrevBlock, *dbp));
-                        }
-                        continue;
-                    }
-
-                    // process in case the block isn't known yet
-                    const CBlockIndex *pindex =
-                        m_blockman.LookupBlockIndex(hash);
-                    if (!pindex || !pindex->nStatus.hasData()) {
-                        BlockValidationState state;
-                        if (AcceptBlock(config, pblock, state, true, dbp,
-                                        nullptr)) {
-                            nLoaded++;
-                        }
-                        if (state.IsError()) {
-                            break;
-                        }
-                    } else if (hash !=
-                                   m_params.GetConsensus().hashGenesisBlock &&
-                               pindex->nHeight % 1000 == 0) {
-                        LogPrint(
-                            BCLog::REINDEX,
-                            "Block Import: already had block %s at height %d\n",
-                            hash.ToString(), pindex->nHeight);
-                    }
-                }
-
-                // Activate the genesis block so normal node progress can
-                // continue
-                if (hash == m_params.GetConsensus().hashGenesisBlock) {
-                    BlockValidationState state;
-                    if (!ActivateBestChain(config, state, nullptr)) {
-                        break;
-                    }
-                }
-
-                NotifyHeaderTip(*this);
-
-                // Recursively process earlier encountered successors of this
-                // block
-                std::deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    std::pair<std::multimap<uint256, FlatFilePos>::iterator,
-                              std::multimap<uint256, FlatFilePos>::iterator>
-                        range = mapBlocksUnknownParent.equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, FlatFilePos>::iterator it =
-                            range.first;
-                        std::shared_ptr<CBlock> pblockrecursive =
-                            std::make_shared<CBlock>();
-                        if (ReadBlockFromDisk(*pblockrecursive, it->second,
-                                              m_params.GetConsensus())) {
-                            LogPrint(
-                                BCLog::REINDEX,
-                                "%s: Processing out of order child %s of %s\n",
-                                __func__, pblockrecursive->GetHash().ToString(),
-                                head.ToString());
-                            LOCK(cs_main);
-                            BlockValidationState dummy;
-                            if (AcceptBlock(config, pblockrecursive, dummy,
-                                            true, &it->second, nullptr)) {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
-                            }
-                        }
-                        range.first++;
-                        mapBlocksUnknownParent.erase(it);
-                        NotifyHeaderTip(*this);
-                    }
+                if (!fn(pblock)) {
+                    break;
                 }
             } catch (const std::exception &e) {
                 LogPrintf("%s: Deserialize or I/O error - %s\n", __func__,
@@ -5249,11 +5604,112 @@ void Chainstate::LoadExternalBlockFile(const Config &config, FILE *fileIn,
     } catch (const std::runtime_error &e) {
         AbortNode(std::string("System error: ") + e.what());
     }
+}
+
+void Chainstate::LoadExternalBlockFile(const Config &config, FILE *fileIn,
+                                       FlatFilePos *dbp) {
+    AssertLockNotHeld(m_chainstate_mutex);
+    int64_t nStart = GetTimeMillis();
+
+    int nLoaded = 0;
+    ReadExternalBlockFile(fileIn, m_params, dbp,
+                          [&](const std::shared_ptr<CBlock> &pblock) {
+                              return LoadExternalBlock(config, pblock, dbp,
+                                                       nLoaded);
+                          });
 
     LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded,
               GetTimeMillis() - nStart);
 }
 
+bool Chainstate::LoadExternalBlock(const Config &config,
+                                   const std::shared_ptr<CBlock> &pblock,
+                                   const FlatFilePos *dbp, int &nLoaded) {
+    AssertLockNotHeld(m_chainstate_mutex);
+    // Map of disk positions for blocks with unknown parent (only used for
+    // reindex)
+    static std::multimap<uint256, FlatFilePos> mapBlocksUnknownParent;
+
+    const CBlock &block = *pblock;
+    const BlockHash hash = block.GetHash();
+    {
+        LOCK(cs_main);
+        // detect out of order blocks, and store them for later
+        if (hash != m_params.GetConsensus().hashGenesisBlock &&
+            !m_blockman.LookupBlockIndex(block.hashPrevBlock)) {
+            LogPrint(BCLog::REINDEX,
+                     "%s: Out of order block %s, parent %s not known\n",
+                     __func__, hash.ToString(), block.hashPrevBlock.ToString());
+            if (dbp) {
+                mapBlocksUnknownParent.insert(
+                    std::make_pair(block.hashPrevBlock, *dbp));
+            }
+            return true;
+        }
+
+        // process in case the block isn't known yet
+        const CBlockIndex *pindex = m_blockman.LookupBlockIndex(hash);
+        if (!pindex || !pindex->nStatus.hasData()) {
+            BlockValidationState state;
+            if (AcceptBlock(config, pblock, state, true, dbp, nullptr)) {
+                nLoaded++;
+            }
+            if (state.IsError()) {
+                return false;
+            }
+        } else if (hash != m_params.GetConsensus().hashGenesisBlock &&
+                   pindex->nHeight % 1000 == 0) {
+            LogPrint(BCLog::REINDEX,
+                     "Block Import: already had block %s at height %d\n",
+                     hash.ToString(), pindex->nHeight);
+        }
+    }
+
+    // Activate the genesis block so normal node progress can continue
+    if (hash == m_params.GetConsensus().hashGenesisBlock) {
+        BlockValidationState state;
+        if (!ActivateBestChain(config, state, nullptr)) {
+            return false;
+        }
+    }
+
+    NotifyHeaderTip(*this);
+
+    // Recursively process earlier encountered successors of this block
+    std::deque<uint256> queue;
+    queue.push_back(hash);
+    while (!queue.empty()) {
+        uint256 head = queue.front();
+        queue.pop_front();
+        std::pair<std::multimap<uint256, FlatFilePos>::iterator,
+                  std::multimap<uint256, FlatFilePos>::iterator>
+            range = mapBlocksUnknownParent.equal_range(head);
+        while (range.first != range.second) {
+            std::multimap<uint256, FlatFilePos>::iterator it = range.first;
+            std::shared_ptr<CBlock> pblockrecursive =
+                std::make_shared<CBlock>();
+            if (ReadBlockFromDisk(*pblockrecursive, it->second,
+                                  m_params.GetConsensus())) {
+                LogPrint(BCLog::REINDEX,
+                         "%s: Processing out of order child %s of %s\n",
+                         __func__, pblockrecursive->GetHash().ToString(),
+                         head.ToString());
+                LOCK(cs_main);
+                BlockValidationState dummy;
+                if (AcceptBlock(config, pblockrecursive, dummy, true,
+                                &it->second, nullptr)) {
+                    nLoaded++;
+                    queue.push_back(pblockrecursive->GetHash());
+                }
+            }
+            range.first++;
+            mapBlocksUnknownParent.erase(it);
+            NotifyHeaderTip(*this);
+        }
+    }
+    return true;
+}
+
 void Chainstate::CheckBlockIndex() {
     if (!fCheckBlockIndex) {
         return;
@@ -5614,6 +6070,8 @@ bool Chainstate::ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size) {
     size_t old_coinstip_size = m_coinstip_cache_size_bytes;
     m_coinstip_cache_size_bytes = coinstip_size;
     m_coinsdb_cache_size_bytes = coinsdb_size;
+    // The database is reopened, make sure nothing reads from it meanwhile.
+    m_coins_views->m_prefetcher.Interrupt();
     CoinsDB().ResizeCache(coinsdb_size);
 
     LogPrintf("[%s] resized coinsdb cache to %.1f MiB\n", this->ToString(),
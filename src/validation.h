@@ -23,6 +23,7 @@
 #include <flatfile.h>
 #include <fs.h>
 #include <node/blockstorage.h>
+#include <node/coinsprefetch.h>
 #include <policy/packages.h>
 #include <script/script_error.h>
 #include <script/script_metrics.h>
@@ -35,6 +36,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <optional>
@@ -51,6 +53,7 @@ class ChainstateManager;
 class Config;
 class CScriptCheck;
 class CTxMemPool;
+class SchnorrBatchVerifier;
 class CTxUndo;
 class DisconnectedBlockTransactions;
 
@@ -86,6 +89,18 @@ static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
 static const int64_t DEFAULT_MAX_TIP_AGE = 24 * 60 * 60;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
 static const bool DEFAULT_TXINDEX = false;
+/** Fetch the coins spent by a block on the input fetch threads by default */
+static const bool DEFAULT_PARALLEL_INPUT_FETCH = true;
+/**
+ * Maximum number of threads fetching the coins spent by a block, started
+ * alongside the script-checking threads. The fetches mostly wait on the
+ * database, so a few threads are enough to keep its reads in flight.
+ */
+static const int MAX_INPUT_FETCH_THREADS = 4;
+/** Write the coins cache to disk on a background thread by default */
+static const bool DEFAULT_BACKGROUND_COINS_FLUSH = true;
+/** Look up the coins spent by upcoming blocks ahead of time by default */
+static const bool DEFAULT_PREFETCH_COINS = true;
 static constexpr bool DEFAULT_COINSTATSINDEX{false};
 static const char *const DEFAULT_BLOCKFILTERINDEX = "0";
 
@@ -129,6 +144,21 @@ extern uint256 g_best_block;
 extern bool fRequireStandard;
 extern bool fCheckBlockIndex;
 extern bool fCheckpointsEnabled;
+/**
+ * Whether the coins spent by a block are fetched from the UTXO database on the
+ * input fetch worker threads before the block is connected.
+ */
+extern bool fParallelInputFetch;
+/**
+ * Whether the periodic and size triggered flushes of the coins cache are
+ * written to the UTXO database on a background thread.
+ */
+extern bool fBackgroundCoinsFlush;
+/**
+ * Whether the coins spent by the blocks queued for connection are looked up
+ * on background threads ahead of time.
+ */
+extern bool fPrefetchCoins;
 
 /**
  * A fee rate smaller than this is considered zero fee (for relaying, mining and
@@ -189,7 +219,8 @@ public:
 };
 
 /**
- * Run instances of script checking worker threads
+ * Run instances of script checking worker threads, along with at most
+ * MAX_INPUT_FETCH_THREADS threads fetching the inputs of the blocks
  */
 void StartScriptCheckWorkerThreads(int threads_num);
 
@@ -331,6 +362,34 @@ AcceptToMemoryPool(const Config &config, Chainstate &active_chainstate,
                    unsigned int heightOverride = 0)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/**
+ * Try to add a batch of transactions received together to the mempool, e.g. a
+ * burst of transactions relayed by a peer. This is an internal function and is
+ * exposed only for testing. Client code should use
+ * ChainstateManager::ProcessTransactions()
+ *
+ * The transactions are checked in order, as if they were submitted one at a
+ * time, except that the script checks of the transactions which don't spend
+ * or conflict with an earlier transaction of the batch are run concurrently on
+ * the script check threads. The other transactions are accepted one at a time
+ * afterwards.
+ *
+ * @param[in]  config             The global configuration.
+ * @param[in]  active_chainstate  Reference to the active chainstate.
+ * @param[in]  txns               The transactions to submit for mempool
+ *                                acceptance, parents before children.
+ * @param[in]  accept_time        The timestamp for adding the transactions to
+ *                                the mempool.
+ *
+ * @returns a MempoolAcceptResult for each transaction, in the same order.
+ */
+std::vector<MempoolAcceptResult>
+AcceptTransactionsToMemoryPool(const Config &config,
+                               Chainstate &active_chainstate,
+                               const std::vector<CTransactionRef> &txns,
+                               int64_t accept_time)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 /**
  * Validate (and maybe submit) a package to the mempool.
  * See doc/policy/packages.md for full detailson package validation rules.
@@ -379,6 +438,12 @@ public:
         return *this;
     }
 
+    /**
+     * Number of sigchecks consumed so far. Only meaningful for a limiter
+     * constructed with the default limit.
+     */
+    int64_t GetConsumed() const { return MAX_TX_SIGCHECKS - remaining; }
+
     static TxSigCheckLimiter getDisabled() {
         TxSigCheckLimiter txLimiter;
         // Historically, there has not been a transaction with more than 20k sig
@@ -497,6 +562,14 @@ private:
     TxSigCheckLimiter *pTxLimitSigChecks;
     CheckInputsLimiter *pBlockLimitSigChecks;
 
+    /**
+     * Evaluate the script. If batch is not null, Schnorr signatures are
+     * queued into it and assumed valid.
+     */
+    bool EvalScript(SchnorrBatchVerifier *batch);
+    /** Account for the executed sigchecks against the limits. */
+    bool ConsumeSigChecks();
+
 public:
     CScriptCheck()
         : ptxTo(nullptr), nIn(0), nFlags(0), cacheStore(false),
@@ -515,6 +588,12 @@ public:
 
     bool operator()();
 
+    /**
+     * Run a batch of checks, verifying all their Schnorr signatures at once.
+     * Used by CCheckQueue.
+     */
+    static bool RunBatch(std::vector<CScriptCheck> &checks);
+
     void swap(CScriptCheck &check) noexcept {
         std::swap(ptxTo, check.ptxTo);
         std::swap(m_tx_out, check.m_tx_out);
@@ -545,6 +624,16 @@ bool CheckBlock(const CBlock &block, BlockValidationState &state,
                 const Consensus::Params &params,
                 BlockValidationOptions validationOptions);
 
+/**
+ * Deserialize the blocks found in a block file, in file order, and pass them
+ * to fn. If dbp is not null, its position is set to the one of each block
+ * before fn is called. Stops at the end of the file or when fn returns false.
+ * This takes over fileIn and closes it.
+ */
+void ReadExternalBlockFile(
+    FILE *fileIn, const CChainParams &params, FlatFilePos *dbp,
+    const std::function<bool(const std::shared_ptr<CBlock> &)> &fn);
+
 /**
  * This is a variant of ContextualCheckTransaction which computes the contextual
  * check for a transaction based on the chain tip.
@@ -600,8 +689,18 @@ public:
     CCoinsViewDB m_dbview GUARDED_BY(cs_main);
 
     //! This view wraps access to the leveldb instance and handles read errors
-    //! gracefully.
-    CCoinsViewErrorCatcher m_catcherview GUARDED_BY(cs_main);
+    //! gracefully. It is not guarded by cs_main because the background flush,
+    //! coins prefetch and input fetch threads read through it concurrently;
+    //! the database is only reopened once the prefetch threads are stopped.
+    CCoinsViewErrorCatcher m_catcherview;
+
+    //! This view holds the coins flushed from the cache until they are
+    //! written to the database, when the write happens in the background.
+    CCoinsViewBackgroundFlush m_flushview;
+
+    //! Looks up the coins spent by upcoming blocks in m_flushview ahead of
+    //! time.
+    node::CoinsPrefetcher m_prefetcher;
 
     //! This is the top layer of the cache hierarchy - it keeps as many coins in
     //! memory as can fit per the dbcache setting.
@@ -614,9 +713,9 @@ public:
     //! to disk, which should not be done until the health of the database is
     //! verified.
     //!
-    //! All arguments forwarded onto CCoinsViewDB.
+    //! All arguments but params forwarded onto CCoinsViewDB.
     CoinsViews(std::string ldb_name, size_t cache_size_bytes, bool in_memory,
-               bool should_wipe);
+               bool should_wipe, const Consensus::Params &params);
 
     //! Initialize the CCoinsViewCache member.
     void InitCache() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
@@ -774,9 +873,11 @@ public:
         return *m_coins_views->m_cacheview.get();
     }
 
-    //! @returns A reference to the on-disk UTXO set database.
+    //! @returns A reference to the on-disk UTXO set database, once any
+    //!     pending background flush has been written to it.
     CCoinsViewDB &CoinsDB() EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
         AssertLockHeld(::cs_main);
+        m_coins_views->m_flushview.WaitForFlush();
         return m_coins_views->m_dbview;
     }
 
@@ -810,6 +911,16 @@ public:
                                FlatFilePos *dbp = nullptr)
         EXCLUSIVE_LOCKS_REQUIRED(!m_chainstate_mutex);
 
+    /**
+     * Import a block read from an external file at position dbp, then the
+     * blocks previously read from the file that were waiting for it.
+     * @returns false if the import of the file should stop.
+     */
+    bool LoadExternalBlock(const Config &config,
+                           const std::shared_ptr<CBlock> &pblock,
+                           const FlatFilePos *dbp, int &nLoaded)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_chainstate_mutex);
+
     /**
      * Update the on-disk chain state.
      * The caches and indexes are flushed depending on the mode we're called
@@ -1278,6 +1389,18 @@ public:
     ProcessTransaction(const CTransactionRef &tx, bool test_accept = false)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Try to add a batch of transactions received together to the memory
+     * pool, running their script checks concurrently when possible.
+     *
+     * @param[in]  txns            The transactions to submit for mempool
+     *                             acceptance, parents before children.
+     * @returns a MempoolAcceptResult for each transaction, in the same order.
+     */
+    [[nodiscard]] std::vector<MempoolAcceptResult>
+    ProcessTransactions(const std::vector<CTransactionRef> &txns)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
     //! Load the block tree and coins database from disk, initializing state if
     //! we're running with -reindex
     bool LoadBlockIndex() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -7,6 +7,7 @@
 - Start a single node and generate 3 blocks.
 - Stop the node and restart it with -reindex. Verify that the node has reindexed up to block 3.
 - Stop the node and restart it with -reindex-chainstate. Verify that the node has reindexed up to block 3.
+- Do the same while reading the block files on a single thread with -reindexthreads=1.
 """
 
 from test_framework.test_framework import BitcoinTestFramework
@@ -18,13 +19,15 @@ class ReindexTest(BitcoinTestFramework):
         self.setup_clean_chain = True
         self.num_nodes = 1
 
-    def reindex(self, justchainstate=False):
+    def reindex(self, justchainstate=False, reindex_threads=None):
         self.generatetoaddress(
             self.nodes[0], 3, self.nodes[0].get_deterministic_priv_key().address
         )
         blockcount = self.nodes[0].getblockcount()
         self.stop_nodes()
         extra_args = [["-reindex-chainstate" if justchainstate else "-reindex"]]
+        if reindex_threads is not None:
+            extra_args[0].append(f"-reindexthreads={reindex_threads}")
         self.start_nodes(extra_args)
         # start_node is blocking on reindex
         assert_equal(self.nodes[0].getblockcount(), blockcount)
@@ -33,6 +36,8 @@ class ReindexTest(BitcoinTestFramework):
     def run_test(self):
         self.reindex(False)
         self.reindex(True)
+        self.reindex(False, reindex_threads=1)
+        self.reindex(True, reindex_threads=1)
         self.reindex(False)
         self.reindex(True)
 
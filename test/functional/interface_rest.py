@@ -12,7 +12,7 @@ from enum import Enum
 from io import BytesIO
 from struct import pack, unpack
 
-from test_framework.messages import BLOCK_HEADER_SIZE
+from test_framework.messages import BLOCK_HEADER_SIZE, hash256
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
     assert_equal,
@@ -387,6 +387,65 @@ class RESTTest(BitcoinTestFramework):
         # Now we should have 5 header objects
         assert_equal(len(json_obj), 5)
 
+        self.log.info("Test the /blocks URI")
+
+        def read_records(data, with_undo=False):
+            records = []
+            while data:
+                size = unpack("<I", data[4:8])[0]
+                records.append((data[:4], data[8 : 8 + size]))
+                data = data[8 + size :]
+                # The undo data is followed by its checksum
+                if with_undo and len(records) % 2 == 0:
+                    records[-1] += (data[:32],)
+                    data = data[32:]
+            return records
+
+        blocks = read_records(
+            self.test_rest_request(
+                f"/blocks/{bb_hash}/5", req_type=ReqType.BIN, ret_type=RetType.BYTES
+            )
+        )
+        assert_equal(len(blocks), 5)
+        for (magic, block), header in zip(blocks, json_obj):
+            assert_equal(magic, blocks[0][0])
+            assert_equal(block.hex(), self.nodes[0].getblock(header["hash"], 0))
+
+        # The undo data follows each block, it is empty for the genesis block
+        genesis_hash = self.nodes[0].getblockhash(0)
+        records = read_records(
+            self.test_rest_request(
+                f"/blocks/undo/{genesis_hash}/2",
+                req_type=ReqType.BIN,
+                ret_type=RetType.BYTES,
+            ),
+            with_undo=True,
+        )
+        assert_equal(len(records), 4)
+        assert_equal(records[0][1].hex(), self.nodes[0].getblock(genesis_hash, 0))
+        assert_equal(records[1][1:], (b"", bytes(32)))
+        assert_equal(
+            records[2][1].hex(),
+            self.nodes[0].getblock(self.nodes[0].getblockhash(1), 0),
+        )
+        # No transaction other than the coinbase
+        assert_equal(records[3][1], b"\x00")
+        # The checksum commits to the previous block hash and the undo data
+        assert_equal(
+            records[3][2],
+            hash256(bytes.fromhex(genesis_hash)[::-1] + records[3][1]),
+        )
+
+        # Only the binary format is supported, for at most 1000 blocks
+        self.test_rest_request(f"/blocks/{bb_hash}/5", ret_type=RetType.OBJ, status=404)
+        for count in [0, 1001]:
+            self.test_rest_request(
+                f"/blocks/{bb_hash}/{count}",
+                req_type=ReqType.BIN,
+                ret_type=RetType.OBJ,
+                status=400,
+            )
+
         self.log.info("Test tx inclusion in the /mempool and /block URIs")
 
         # Make 3 tx and mine them on node 1
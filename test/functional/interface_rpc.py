@@ -53,6 +53,17 @@ class RPCInterfaceTest(BitcoinTestFramework):
             os.path.join(self.nodes[0].datadir, self.chain, "debug.log"),
         )
 
+        assert_equal(len(info["http_work_queues"]), 1)
+        queue = info["http_work_queues"][0]
+        assert_equal(queue["max_depth"], 16)
+        assert_equal(queue["rejected"], 0)
+
+        # Every request is counted once it has been handled
+        for _ in range(5):
+            self.nodes[0].getblockcount()
+        handled = self.nodes[0].getrpcinfo()["http_work_queues"][0]["handled"]
+        assert_greater_than_or_equal(handled, queue["handled"] + 5)
+
     def test_batch_request(self):
         self.log.info("Testing basic JSON-RPC batch request...")
 
@@ -81,12 +92,46 @@ class RPCInterfaceTest(BitcoinTestFramework):
         assert_equal(result_by_id[3]["error"], None)
         assert result_by_id[3]["result"] is not None
 
+    def test_parallel_batch_request(self):
+        self.log.info("Testing JSON-RPC batch request with read only calls...")
+        self.restart_node(0, ["-rpcthreads=4"])
+        node = self.nodes[0]
+        best_hash = node.getbestblockhash()
+
+        # The read only calls are executed in parallel, around the other calls
+        # which are executed in order. The replies are in the order of the
+        # requests.
+        requests = []
+        for i in range(50):
+            requests.append({"method": "getblockhash", "id": i, "params": [0]})
+        requests.append({"method": "setmocktime", "id": 50, "params": [0]})
+        requests.append({"method": "invalidmethod", "id": 51})
+        for i in range(52, 100):
+            requests.append({"method": "getbestblockhash", "id": i})
+        results = node.batch(requests)
+        assert_equal([res["id"] for res in results], list(range(100)))
+        for res in results[:50]:
+            assert_equal(res["result"], node.getblockhash(0))
+        assert_equal(results[50]["error"], None)
+        assert_equal(results[51]["error"]["code"], -32601)
+        for res in results[52:]:
+            assert_equal(res["result"], best_hash)
+
     def test_http_status_codes(self):
         self.log.info("Testing HTTP status codes for JSON-RPC requests...")
 
         expect_http_status(404, -32601, self.nodes[0].invalidmethod)
         expect_http_status(500, -8, self.nodes[0].getblockhash, 42)
 
+    def test_event_threads(self):
+        self.log.info("Testing multiple HTTP event threads...")
+        self.restart_node(0, ["-rpceventthreads=3", "-rpcthreads=4"])
+        for _ in range(20):
+            self.nodes[0].getblockcount()
+        queues = self.nodes[0].getrpcinfo()["http_work_queues"]
+        assert_equal(len(queues), 3)
+        assert_greater_than_or_equal(sum(q["handled"] for q in queues), 20)
+
     def test_work_queue_exceeded(self):
         if not self.is_cli_compiled():
             self.log.info("Skipping test_work_queue_exceeded (CLI not compiled)")
@@ -118,7 +163,9 @@ class RPCInterfaceTest(BitcoinTestFramework):
     def run_test(self):
         self.test_getrpcinfo()
         self.test_batch_request()
+        self.test_parallel_batch_request()
         self.test_http_status_codes()
+        self.test_event_threads()
         self.test_work_queue_exceeded()
 
 
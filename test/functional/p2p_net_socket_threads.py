@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+# Copyright (c) 2026 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the peer connections spread over several socket handler threads."""
+from collections import defaultdict
+
+from test_framework.messages import MSG_BLOCK, CInv, msg_getdata
+from test_framework.p2p import P2PInterface
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+NUM_PEERS = 8
+
+
+class P2PStoreBlock(P2PInterface):
+    def __init__(self):
+        super().__init__()
+        self.blocks = defaultdict(int)
+
+    def on_block(self, message):
+        message.block.calc_sha256()
+        self.blocks[message.block.sha256] += 1
+
+
+class NetSocketThreadsTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.extra_args = [["-netsocketthreads=3"], []]
+
+    def run_test(self):
+        node = self.nodes[0]
+
+        self.log.info("Connect peers handled by all the socket threads")
+        peers = [node.add_p2p_connection(P2PStoreBlock()) for _ in range(NUM_PEERS)]
+        for peer in peers:
+            peer.sync_with_ping()
+        # The other node is connected as well.
+        assert_equal(len(node.getpeerinfo()), NUM_PEERS + 1)
+
+        self.log.info("Blocks are relayed and served to all the peers")
+        blockhashes = self.generate(node, 5)
+        for peer in peers:
+            getdata = msg_getdata()
+            for blockhash in blockhashes:
+                getdata.inv.append(CInv(t=MSG_BLOCK, h=int(blockhash, 16)))
+            peer.send_message(getdata)
+        # The announced blocks may be requested by the peers as well.
+        for peer in peers:
+            peer.wait_until(
+                lambda peer=peer: all(
+                    peer.blocks[int(h, 16)] >= 1 for h in blockhashes
+                )
+            )
+
+        self.log.info("Peers can be disconnected from any socket thread")
+        node.disconnect_p2ps()
+        self.wait_until(lambda: len(node.getpeerinfo()) == 1)
+        for peer in [node.add_p2p_connection(P2PInterface()) for _ in range(3)]:
+            peer.sync_with_ping()
+        assert_equal(len(node.getpeerinfo()), 4)
+
+
+if __name__ == "__main__":
+    NetSocketThreadsTest().main()